@@ -127,13 +127,17 @@ void DbSqlEditorLog::handle_context_menu(const std::string &action) {
   } else if (action == "append_selected_items") {
     sql = get_selection_text(false, true, false, false);
     SqlEditorPanel *editor(_owner->active_sql_editor_panel());
-    if (editor)
+    if (editor) {
+      editor->finish_loading();
       editor->editor_be()->append_text(sql);
+    }
   } else if (action == "replace_sql_script") {
     sql = get_selection_text(false, true, false, false);
     SqlEditorPanel *editor(_owner->active_sql_editor_panel());
-    if (editor)
+    if (editor) {
+      editor->finish_loading();
       editor->editor_be()->sql(sql.c_str());
+    }
   } else if (action == "clear") {
     reset();
   }
@@ -59,6 +59,7 @@
 #include "grts/structs.db.query.h"
 
 #include "grtdb/db_helpers.h"
+#include "grtsqlparser/mysql_parser_services.h"
 
 #include "mforms/code_editor.h"
 #include "mforms/menubar.h"
@@ -474,7 +475,7 @@ static void call_exec_sql(wb::WBContextSQLIDE *sqlide, bool current_statement_on
 
 static bool validate_exec_sql(wb::WBContextSQLIDE *sqlide) {
   SqlEditorForm *form = sqlide->get_active_sql_editor();
-  return (form && !form->is_running_query() && form->connected());
+  return (form && !form->is_running_query_in_active_editor() && form->connected());
 }
 
 static void call_save_edits(wb::WBContextSQLIDE *sqlide) {
@@ -681,6 +682,25 @@ void WBContextSQLIDE::init() {
 
   DbSqlEditorSnippets::setup(this, base::makePath(bec::GRTManager::get()->get_user_datadir(), "snippets"));
 
+  if (bec::GRTManager::get()->get_app_option_int("DbSqlEditor:PersistentParseCache", 0) != 0) {
+    try {
+      parsers::MySQLParserServices::get()->setParseCacheFile(
+        base::makePath(bec::GRTManager::get()->get_user_datadir(), "parse_cache.dat"));
+    } catch (std::exception &e) {
+      logWarning("Could not set up the parse cache file: %s\n", e.what());
+    }
+  }
+
+  std::string profilePath = base::makePath(bec::GRTManager::get()->get_user_datadir(), "prediction_profile.txt");
+  if (base::file_exists(profilePath)) {
+    try {
+      parsers::MySQLParserServices::get()->importPredictionProfile(base::getTextFileContent(profilePath));
+    } catch (std::exception &e) {
+      logWarning("Could not load the parser prediction profile: %s\n", e.what());
+    }
+  }
+  parsers::MySQLParserServices::get()->startParserWarmUp();
+
   // scoped_connect(wb::WBContextUI::get()->get_wb()->signal_app_closing(),std::bind(&WBContextSQLIDE::finalize, this));
   base::NotificationCenter::get()->add_observer(this, "GNAppClosing");
 
@@ -783,6 +803,15 @@ void WBContextSQLIDE::finalize() {
     }
     ed = next;
   }
+
+  parsers::MySQLParserServices::get()->stopParserWarmUp();
+  parsers::MySQLParserServices::get()->setParseCacheFile(""); // Writes what is still pending.
+  try {
+    base::setTextFileContent(base::makePath(bec::GRTManager::get()->get_user_datadir(), "prediction_profile.txt"),
+                             parsers::MySQLParserServices::get()->exportPredictionProfile());
+  } catch (std::exception &e) {
+    logWarning("Could not save the parser prediction profile: %s\n", e.what());
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -53,8 +53,6 @@ using namespace base;
 
 void SqlEditorForm::auto_save() {
   if (!_autosave_disabled && _startup_done) {
-    logDebug("Auto saving workspace\n");
-
     try {
       save_workspace(sanitize_file_name(_connection.is_valid() ? _connection->name() : "unconnected"), true);
     } catch (std::exception &exc) {
@@ -69,8 +67,52 @@ void SqlEditorForm::auto_save() {
   }
 }
 
-// Save all script buffers, including scratch buffers
+/**
+ * Writes the given editor contents. g_file_set_contents() writes to a temporary file which is then renamed,
+ * so an auto save that is interrupted never leaves a truncated file behind. Returns the errors, if any.
+ */
+static std::string write_editor_contents(const std::vector<std::pair<std::string, std::string> > &contents) {
+  std::string errors;
+  for (auto &content : contents) {
+    GError *error = 0;
+    if (!g_file_set_contents(content.first.c_str(), content.second.data(), (gssize)content.second.size(), &error)) {
+      logError("Could not save snapshot of editor contents to %s: %s\n", content.first.c_str(), error->message);
+      errors += strfmt("Could not save snapshot of editor contents to %s: %s\n", content.first.c_str(), error->message);
+      g_error_free(error);
+    }
+  }
+  return errors;
+}
+
+/**
+ * Waits for the background write started by the last auto save. If that failed, the error is returned and
+ * everything will be written again by the next auto save.
+ */
+std::string SqlEditorForm::finish_auto_save() {
+  if (_autosave_thread.joinable())
+    _autosave_thread.join();
+  _autosave_contents.clear();
+
+  std::string error;
+  std::swap(error, _autosave_error);
+  if (!error.empty()) {
+    _autosaved_path.clear();
+    if (_tabdock) {
+      for (int c = _tabdock->view_count(), i = 0; i < c; i++) {
+        SqlEditorPanel *editor = sql_editor_panel(i);
+        if (editor)
+          editor->reset_auto_save_state();
+      }
+    }
+  }
+  return error;
+}
+
+// Save all script buffers, including scratch buffers.
+// An auto save writes only what changed since the last one and the editor contents are written in the background.
 void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_autosave) {
+  std::string previous_error = finish_auto_save();
+
   std::string path;
 
   // if we're autosaving, just use the same path from previous saves
@@ -94,8 +136,14 @@ void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_au
   } else
     path = _autosave_path;
 
+  bool new_location = path != _autosaved_path;
+  if (new_location) {
+    _autosaved_path = path;
+    _autosaved_tab_order.clear();
+  }
+
   // save the real id of the connection
-  if (_connection.is_valid())
+  if (_connection.is_valid() && new_location)
     g_file_set_contents(base::makePath(path, "connection_id").c_str(), _connection->id().c_str(),
                         (gssize)_connection->id().size(), NULL);
 
@@ -125,9 +173,13 @@ void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_au
       info.append("expanded=").append(expand_state).append("\n");
     }
 
-    g_file_set_contents(base::makePath(path, "schema_tree").c_str(), info.c_str(), info.size(), NULL);
+    if (new_location || info != _autosaved_schema_tree) {
+      g_file_set_contents(base::makePath(path, "schema_tree").c_str(), info.c_str(), info.size(), NULL);
+      _autosaved_schema_tree = info;
+    }
   }
 
+  SqlEditorPanel::AutoSaveContents contents;
   if (_tabdock) {
     for (int c = _tabdock->view_count(), i = 0; i < c; i++) {
       SqlEditorPanel *editor = sql_editor_panel(i);
@@ -135,7 +187,7 @@ void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_au
         continue;
 
       try {
-        editor->auto_save(path);
+        editor->auto_save(path, contents);
       } catch (std::exception &e) {
         logError("Could not auto-save editor %s\n", editor->get_title().c_str());
         mforms::Utilities::show_error(
@@ -145,6 +197,21 @@ void SqlEditorForm::save_workspace(const std::string &workspace_name, bool is_au
     }
   }
   save_workspace_order(path);
+
+  if (!contents.empty()) {
+    logDebug("Auto saving %i editor(s) of workspace\n", (int)contents.size());
+    if (is_autosave) {
+      _autosave_contents.swap(contents);
+      _autosave_thread = std::thread([this]() { _autosave_error = write_editor_contents(_autosave_contents); });
+    } else {
+      std::string error = write_editor_contents(contents);
+      if (!error.empty())
+        mforms::Utilities::show_error("Save Workspace", error, "OK");
+    }
+  }
+
+  if (!previous_error.empty())
+    throw std::runtime_error(previous_error);
 }
 
 std::string SqlEditorForm::find_workspace_state(const std::string &workspace_name,
@@ -459,6 +526,8 @@ void SqlEditorForm::remove_sql_editor(SqlEditorPanel *panel) {
     save_workspace_order(_autosave_path);
   }
 
+  release_pooled_connection(panel);
+
   _tabdock->undock_view(panel);
 
   // no need to delete, undock_view will release the reference and delete it because panel is managed
@@ -506,14 +575,24 @@ void SqlEditorForm::save_workspace_order(const std::string &prefix) {
     logError("save with empty path\n");
 
   if (_tabdock) {
-    std::wofstream orderFile;
-    openStream(base::makePath(prefix, "tab_order"), orderFile);
+    std::string order;
     for (int c = _tabdock->view_count(), i = 0; i < c; i++) {
       SqlEditorPanel *editor = sql_editor_panel(i);
-      if (editor && orderFile.good())
-        orderFile << base::string_to_wstring(editor->autosave_file_suffix()) << std::endl;
+      if (editor)
+        order.append(editor->autosave_file_suffix()).append("\n");
     }
+
+    // Nothing to do if the order didn't change since it was last written there.
+    if (prefix == _autosaved_path && !order.empty() && order == _autosaved_tab_order)
+      return;
+
+    std::wofstream orderFile;
+    openStream(base::makePath(prefix, "tab_order"), orderFile);
+    if (orderFile.good())
+      orderFile << base::string_to_wstring(order);
     orderFile.close();
+    if (prefix == _autosaved_path)
+      _autosaved_tab_order = order;
   }
 }
 
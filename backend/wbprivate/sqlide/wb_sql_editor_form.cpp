@@ -76,6 +76,9 @@
 #include "grtsqlparser/mysql_parser_services.h"
 
 #include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <mutex>
 #include <thread>
 
@@ -322,6 +325,9 @@ SqlEditorForm::~SqlEditorForm() {
   NotificationCenter::get()->remove_observer(this);
   GRTNotificationCenter::get()->remove_grt_observer(this);
 
+  if (_autosave_thread.joinable())
+    _autosave_thread.join();
+
   delete _autosave_lock;
   _autosave_lock = 0;
 
@@ -430,6 +436,353 @@ base::RecMutexLock SqlEditorForm::getUserConnection(sql::Dbc_connection_handler:
 
 //--------------------------------------------------------------------------------------------------
 
+bool SqlEditorForm::connection_pool_enabled() {
+  return bec::GRTManager::get()->get_app_option_int("DbSqlEditor:ConnectionPoolSize", 0) > 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the pooled connection currently leased by the given editor, if any.
+ */
+SqlEditorForm::PooledConnectionRef SqlEditorForm::pooled_connection_for(SqlEditorPanel *editor) {
+  if (editor == nullptr)
+    return PooledConnectionRef();
+
+  MutexLock lock(_connection_pool_mutex);
+  for (auto &pooled : _connection_pool) {
+    if (pooled->owner == editor)
+      return pooled;
+  }
+  return PooledConnectionRef();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the pooled connection for the given editor, reserving a new one if the editor has none yet.
+ * The actual server connection is opened lazily in the background, on the first query run with it.
+ * An empty ref is returned if the pool is disabled or all its connections are taken, in which case the caller
+ * falls back to the shared user connection.
+ */
+SqlEditorForm::PooledConnectionRef SqlEditorForm::lease_pooled_connection(SqlEditorPanel *editor) {
+  if (editor == nullptr || !connection_pool_enabled())
+    return PooledConnectionRef();
+
+  std::size_t pool_size = (std::size_t)bec::GRTManager::get()->get_app_option_int("DbSqlEditor:ConnectionPoolSize", 0);
+
+  MutexLock lock(_connection_pool_mutex);
+  for (auto &pooled : _connection_pool) {
+    if (pooled->owner == editor)
+      return pooled;
+  }
+
+  if (_connection_pool.size() >= pool_size) {
+    logDebug("Connection pool exhausted (%lu connections), using the shared user connection\n",
+             (unsigned long)_connection_pool.size());
+    return PooledConnectionRef();
+  }
+
+  PooledConnectionRef pooled(new PooledConnection());
+  pooled->conn.reset(new sql::Dbc_connection_handler());
+  pooled->conn->autocommit_mode = _usr_dbc_conn->autocommit_mode;
+  pooled->conn->active_schema = _usr_dbc_conn->active_schema;
+  pooled->owner = editor;
+
+  pooled->task = GrtThreadedTask::create();
+  pooled->task->desc("execute sql queries (pooled connection)");
+  pooled->task->send_task_res_msg(false);
+  pooled->task->msg_cb(std::bind(&SqlEditorForm::add_log_message, this, std::placeholders::_1, std::placeholders::_2,
+                                 std::placeholders::_3, ""));
+
+  _connection_pool.push_back(pooled);
+
+  return pooled;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Gives back the connection leased by the given editor (if any) and closes its session, so that no session state
+ * (temporary tables, user variables, open transactions) leaks into another tab.
+ * Editors cannot be closed while they run a query, so the connection is idle here.
+ */
+void SqlEditorForm::release_pooled_connection(SqlEditorPanel *editor) {
+  PooledConnectionRef pooled;
+  {
+    MutexLock lock(_connection_pool_mutex);
+    for (auto iterator = _connection_pool.begin(); iterator != _connection_pool.end(); ++iterator) {
+      if ((*iterator)->owner == editor) {
+        pooled = *iterator;
+        _connection_pool.erase(iterator);
+        break;
+      }
+    }
+  }
+
+  if (pooled) {
+    pooled->owner = nullptr;
+    stop_pooled_connection(pooled);
+
+    RecMutexLock lock(pooled->mutex);
+    close_connection(pooled->conn);
+    pooled->conn->ref.reset();
+    pooled->task->disconnect_callbacks();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SqlEditorForm::close_pooled_connections() {
+  std::vector<PooledConnectionRef> pool;
+  {
+    MutexLock lock(_connection_pool_mutex);
+    pool.swap(_connection_pool);
+  }
+
+  for (auto &pooled : pool) {
+    pooled->owner = nullptr;
+    stop_pooled_connection(pooled);
+
+    RecMutexLock lock(pooled->mutex);
+    close_connection(pooled->conn);
+    pooled->conn->ref.reset();
+    pooled->task->disconnect_callbacks();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Cancels the query running on a pooled connection (if any) and waits until its worker is done, so that the
+ * connection can be closed without pulling it away from under a running statement.
+ */
+void SqlEditorForm::stop_pooled_connection(PooledConnectionRef pooled) {
+  if (!pooled->running && !pooled->task->is_busy())
+    return;
+
+  sql::Dbc_connection_handler::Ref dbc_conn = pooled->conn;
+  if (pooled->running && dbc_conn->id > 0) {
+    db_mgmt_RdbmsRef rdbms = db_mgmt_RdbmsRef::cast_from(_connection->driver()->owner());
+    std::string query_kill_query =
+      SqlFacade::instance_for_rdbms(rdbms)->sqlSpecifics()->query_kill_query(dbc_conn->id);
+
+    if (!query_kill_query.empty()) {
+      try {
+        RecMutexLock aux_dbc_conn_mutex(ensure_valid_aux_connection());
+        std::auto_ptr<sql::Statement> stmt(_aux_dbc_conn->ref->createStatement());
+        stmt->execute(query_kill_query);
+      } catch (std::exception &exc) {
+        logWarning("Could not cancel query on pooled connection %lli: %s\n", (long long)dbc_conn->id, exc.what());
+      }
+    }
+
+    // Killing the query doesn't stop fetching its results, the worker checks this flag for that.
+    dbc_conn->is_stop_query_requested = true;
+  }
+
+  // The worker may wait for the main thread (e.g. for a message box), so keep that going if this is it.
+  while (pooled->task->is_busy()) {
+    if (bec::GRTManager::get()->in_main_thread())
+      bec::GRTManager::get()->perform_idle_tasks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns true if any pooled connection still has a worker running a query.
+ */
+bool SqlEditorForm::has_busy_pooled_connections() {
+  MutexLock lock(_connection_pool_mutex);
+  for (auto &pooled : _connection_pool) {
+    if (pooled->running || pooled->task->is_busy())
+      return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Opens the pooled connection if that didn't happen yet (or checks it and reconnects if needed) and brings its
+ * session state in line with the user connection. Must be called from the task thread of the pooled connection.
+ */
+base::RecMutexLock SqlEditorForm::ensure_valid_pooled_connection(PooledConnectionRef pooled) {
+  {
+    RecMutexLock lock(pooled->mutex);
+    if (!pooled->conn->ref.get_ptr()) {
+      std::shared_ptr<sql::TunnelConnection> tunnel = sql::DriverManager::getDriverManager()->getTunnel(_connection);
+      create_connection(pooled->conn, _connection, tunnel, _dbc_auth, pooled->conn->autocommit_mode, true);
+    }
+  }
+
+  RecMutexLock lock(ensure_valid_dbc_connection(pooled->conn, pooled->mutex));
+  replay_session_state(pooled);
+
+  return lock;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Connection getter for the recordsets of a query run on a pooled connection, they are reloaded and fetched on the
+ * same session.
+ */
+base::RecMutexLock SqlEditorForm::getPooledConnection(PooledConnectionRef pooled,
+                                                      sql::Dbc_connection_handler::Ref &conn, bool lockOnly) {
+  RecMutexLock lock(ensure_valid_dbc_connection(pooled->conn, pooled->mutex, false, lockOnly));
+  conn = pooled->conn;
+  return lock;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Replays the session state of the editor form on a pooled connection: default schema, autocommit mode and
+ * all SET statements run since the connection was opened (or last synchronized).
+ */
+void SqlEditorForm::replay_session_state(PooledConnectionRef pooled) {
+  sql::Dbc_connection_handler::Ref conn = pooled->conn;
+
+  // A new id means a new session (first connect or reconnect), so everything must be applied again.
+  if (pooled->session_id != conn->id) {
+    pooled->session_id = conn->id;
+    pooled->applied_session_serial = 0;
+    bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlEditorForm::show_pooled_connection, this, pooled));
+  }
+
+  std::vector<std::string> statements;
+  std::string schema;
+  bool autocommit_mode;
+  {
+    MutexLock lock(_connection_pool_mutex);
+    for (auto &entry : _session_statements) {
+      if (entry.serial > pooled->applied_session_serial)
+        statements.push_back(entry.statement);
+    }
+    pooled->applied_session_serial = _session_serial;
+    schema = _usr_dbc_conn->active_schema;
+    autocommit_mode = _usr_dbc_conn->autocommit_mode;
+  }
+
+  if (!statements.empty()) {
+    std::unique_ptr<sql::Statement> stmt(conn->ref->createStatement());
+    for (auto &statement : statements) {
+      try {
+        stmt->execute(statement);
+      } catch (sql::SQLException &exc) {
+        logWarning("Could not replay \"%s\" on pooled connection %lli: %s\n", statement.c_str(), (long long)conn->id,
+                   exc.what());
+      }
+    }
+  }
+
+  if (!schema.empty() && schema != conn->active_schema) {
+    conn->ref->setSchema(schema);
+    conn->active_schema = schema;
+  }
+
+  if (autocommit_mode != conn->autocommit_mode) {
+    conn->ref->setAutoCommit(autocommit_mode);
+    conn->autocommit_mode = conn->ref->getAutoCommit();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the setting changed by a SET statement, used to keep only the last statement per setting.
+ * Statements changing more than one setting are only collapsed with identical ones.
+ */
+static std::string session_setting_for(const std::string &statement) {
+  std::string setting = base::tolower(base::trim(statement));
+  if (base::hasPrefix(setting, "set"))
+    setting = base::trim(setting.substr(3));
+
+  std::string::size_type assignment = setting.find('=');
+  if (assignment != std::string::npos && setting.find(',') == std::string::npos) {
+    setting = base::trim(setting.substr(0, assignment), " \t\r\n:");
+    for (const char *prefix : {"@@session.", "@@local.", "@@", "session ", "local "}) {
+      if (base::hasPrefix(setting, prefix)) {
+        setting = base::trim(setting.substr(strlen(prefix)));
+        break;
+      }
+    }
+  } else if (base::hasPrefix(setting, "names "))
+    setting = "names";
+  else if (base::hasPrefix(setting, "character set "))
+    setting = "character set";
+
+  return setting;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Remembers a session changing statement (SET ...) so it can be replayed on the other pooled connections.
+ * Only the last statement per setting is kept, so this doesn't grow with the number of statements run in the
+ * session. If the statement was run on a pooled connection which was in sync before, that one is not replayed again.
+ */
+void SqlEditorForm::record_session_statement(const std::string &statement, PooledConnectionRef source) {
+  static const std::size_t max_session_statements = 1000;
+
+  if (!connection_pool_enabled())
+    return;
+
+  std::string setting = session_setting_for(statement);
+
+  MutexLock lock(_connection_pool_mutex);
+  bool in_sync = source && source->applied_session_serial == _session_serial;
+
+  for (auto iterator = _session_statements.begin(); iterator != _session_statements.end(); ++iterator) {
+    if (iterator->setting == setting) {
+      _session_statements.erase(iterator);
+      break;
+    }
+  }
+  if (_session_statements.size() >= max_session_statements) {
+    logWarning("Too many session settings to replay on pooled connections, dropping \"%s\"\n",
+               _session_statements.front().statement.c_str());
+    _session_statements.erase(_session_statements.begin());
+  }
+
+  SessionStatement entry = {setting, statement, ++_session_serial};
+  _session_statements.push_back(entry);
+  if (in_sync)
+    source->applied_session_serial = _session_serial;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool SqlEditorForm::is_user_connection(const sql::Dbc_connection_handler::Ref &dbc_conn) {
+  if (!dbc_conn)
+    return false;
+
+  if (dbc_conn == _usr_dbc_conn)
+    return true;
+
+  MutexLock lock(_connection_pool_mutex);
+  for (auto &pooled : _connection_pool) {
+    if (pooled->conn == dbc_conn)
+      return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Shows the connection id of a pooled connection in the tab of the editor holding it. Called in the main thread.
+ */
+void SqlEditorForm::show_pooled_connection(PooledConnectionRef pooled) {
+  if (pooled->owner != nullptr)
+    pooled->owner->set_connection_id(pooled->conn->id);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 db_query_EditorRef SqlEditorForm::grtobj() {
   return wbsql()->get_grt_editor_object(this);
 }
@@ -536,6 +889,8 @@ void SqlEditorForm::reset_keep_alive_thread() {
 }
 
 grt::StringRef SqlEditorForm::do_disconnect() {
+  close_pooled_connections();
+
   if (_usr_dbc_conn->ref.get()) {
     {
       RecMutexLock lock(_usr_dbc_conn_mutex);
@@ -564,6 +919,14 @@ void SqlEditorForm::close() {
     } else {
       auto_save();
 
+      // UIForm::close() can't return anything, so the error is reported like any other failed auto save.
+      std::string error = finish_auto_save();
+      if (!error.empty()) {
+        logError("Final auto save of the workspace failed: %s\n", error.c_str());
+        mforms::Utilities::show_error(_("Error on Auto Save"),
+                                      strfmt(_("An error occurred during auto-save:\n%s"), error.c_str()), _("OK"));
+      }
+
       // Remove auto lock first or renaming the folder will fail.
       delete _autosave_lock;
       std::string new_name(base::strip_extension(_autosave_path) + ".workspace");
@@ -595,6 +958,10 @@ void SqlEditorForm::close() {
     }
     _autosave_lock = 0;
   } else {
+    // The workspace is removed anyway, so a failed write doesn't matter anymore.
+    std::string error = finish_auto_save();
+    if (!error.empty())
+      logWarning("Auto save of the discarded workspace failed: %s\n", error.c_str());
     delete _autosave_lock;
     _autosave_lock = 0;
     if (!_autosave_path.empty())
@@ -719,9 +1086,13 @@ void SqlEditorForm::update_sql_mode_for_editors() {
   }
 }
 
-void SqlEditorForm::cache_sql_mode() {
+/**
+ * Reads the sql_mode of the given session, which is the one that ran the last SET statement. The caller must hold the
+ * lock of that connection.
+ */
+void SqlEditorForm::cache_sql_mode(sql::Dbc_connection_handler::Ref dbc_conn) {
   std::string sql_mode;
-  if (_usr_dbc_conn && get_session_variable(_usr_dbc_conn->ref.get(), "sql_mode", sql_mode)) {
+  if (dbc_conn && get_session_variable(dbc_conn->ref.get(), "sql_mode", sql_mode)) {
     if (sql_mode != _sql_mode) {
       _sql_mode = sql_mode;
       bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlEditorForm::update_sql_mode_for_editors, this));
@@ -729,123 +1100,215 @@ void SqlEditorForm::cache_sql_mode() {
   }
 }
 
-void SqlEditorForm::query_ps_statistics(std::int64_t conn_id, std::map<std::string, std::int64_t> &stats) {
-  static const char *stat_fields[] = {"EVENT_ID",
-                                      "THREAD_ID",
-                                      "TIMER_WAIT",
-                                      "LOCK_TIME",
-                                      "ERRORS",
-                                      "WARNINGS",
-                                      "ROWS_AFFECTED",
-                                      "ROWS_SENT",
-                                      "ROWS_EXAMINED",
-                                      "CREATED_TMP_DISK_TABLES",
-                                      "CREATED_TMP_TABLES",
-                                      "SELECT_FULL_JOIN",
-                                      "SELECT_FULL_RANGE_JOIN",
-                                      "SELECT_RANGE",
-                                      "SELECT_RANGE_CHECK",
-                                      "SELECT_SCAN",
-                                      "SORT_MERGE_PASSES",
-                                      "SORT_RANGE",
-                                      "SORT_ROWS",
-                                      "SORT_SCAN",
-                                      "NO_INDEX_USED",
-                                      "NO_GOOD_INDEX_USED",
-                                      nullptr};
-  RecMutexLock lock(ensure_valid_aux_connection());
+static const char *ps_stat_fields[] = {"EVENT_ID",
+                                       "THREAD_ID",
+                                       "TIMER_WAIT",
+                                       "LOCK_TIME",
+                                       "ERRORS",
+                                       "WARNINGS",
+                                       "ROWS_AFFECTED",
+                                       "ROWS_SENT",
+                                       "ROWS_EXAMINED",
+                                       "CREATED_TMP_DISK_TABLES",
+                                       "CREATED_TMP_TABLES",
+                                       "SELECT_FULL_JOIN",
+                                       "SELECT_FULL_RANGE_JOIN",
+                                       "SELECT_RANGE",
+                                       "SELECT_RANGE_CHECK",
+                                       "SELECT_SCAN",
+                                       "SORT_MERGE_PASSES",
+                                       "SORT_RANGE",
+                                       "SORT_ROWS",
+                                       "SORT_SCAN",
+                                       "NO_INDEX_USED",
+                                       "NO_GOOD_INDEX_USED",
+                                       nullptr};
+
+// Sums up the wait time of equally named stages/waits.
+template <class T>
+static void add_ps_wait_time(std::vector<T> &list, const std::string &name, double wait_time) {
+  for (auto &entry : list) {
+    if (entry.name == name) {
+      entry.wait_time += wait_time;
+      return;
+    }
+  }
 
-  std::auto_ptr<sql::Statement> stmt(_aux_dbc_conn->ref->createStatement());
+  T entry;
+  entry.name = name;
+  entry.wait_time = wait_time;
+  list.push_back(entry);
+}
+
+//--------------------------------------------------------------------------------------------------
 
+/**
+ * Prepares collecting performance schema stats for a script run on the connection with the given id.
+ * Only the thread id and the last statement event id of the connection are determined here, all event data is read
+ * in one go by finish_ps_collection() after the script ran. Returns false if the performance schema is not usable.
+ */
+bool SqlEditorForm::begin_ps_collection(std::int64_t conn_id, PSCollection &collection) {
+  RecMutexLock lock(ensure_valid_aux_connection());
+
+  std::unique_ptr<sql::Statement> stmt(_aux_dbc_conn->ref->createStatement());
   try {
-    std::auto_ptr<sql::ResultSet> result(stmt->executeQuery(base::strfmt(
-      "SELECT st.* FROM performance_schema.events_statements_current st JOIN performance_schema.threads thr"
-      " ON thr.thread_id = st.thread_id WHERE thr.processlist_id = %lli",
+    std::unique_ptr<sql::ResultSet> result(stmt->executeQuery(base::strfmt(
+      "SELECT thr.thread_id, (SELECT IFNULL(MAX(st.event_id), 0) FROM performance_schema.events_statements_current st"
+      " WHERE st.thread_id = thr.thread_id) FROM performance_schema.threads thr WHERE thr.processlist_id = %lli",
       (long long int)conn_id)));
-    while (result->next()) {
-      for (const char **field = stat_fields; *field; ++field) {
-        stats[*field] = result->getInt64(*field);
-      }
+    if (result->next()) {
+      collection.thread_id = result->getInt64(1);
+      collection.last_event_id = result->getInt64(2);
+      return true;
     }
   } catch (sql::SQLException &exc) {
-    logException("Error querying performance_schema.events_statements_current\n", exc);
+    logException("Error querying performance_schema.threads\n", exc);
   }
+  return false;
 }
 
-std::vector<SqlEditorForm::PSStage> SqlEditorForm::query_ps_stages(std::int64_t stmt_event_id) {
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the statement, stage and wait events of the script run started with begin_ps_collection() and assigns them
+ * to the recordsets collected meanwhile. Statements are matched to their events by text, in execution order.
+ * Stages and waits are attributed to the top level statement whose EVENT_ID..END_EVENT_ID range contains them.
+ */
+void SqlEditorForm::finish_ps_collection(PSCollection &collection, GrtThreadedTask::Ref task) {
+  if (collection.statements.empty())
+    return;
+
+  struct StatementEvent {
+    std::string sql_text;
+    std::int64_t event_id;
+    std::int64_t end_event_id;
+    std::map<std::string, std::int64_t> stats;
+    std::vector<PSStage> stages;
+    std::vector<PSWait> waits;
+  };
+  std::vector<StatementEvent> events;
+
   RecMutexLock lock(ensure_valid_aux_connection());
+  std::unique_ptr<sql::Statement> stmt(_aux_dbc_conn->ref->createStatement());
 
-  std::auto_ptr<sql::Statement> stmt(_aux_dbc_conn->ref->createStatement());
-  std::vector<PSStage> stages;
   try {
-    std::auto_ptr<sql::ResultSet> result(stmt->executeQuery(
-      base::strfmt("SELECT st.* FROM performance_schema.events_stages_history_long st WHERE st.nesting_event_id = %lli",
-                   (long long int)stmt_event_id)));
+    // The per-thread history keeps only the last few statements, the long history might be disabled.
+    // Reading all of them (the union removes duplicates) gives the best coverage.
+    std::string conditions =
+      base::strfmt(" WHERE thread_id = %lli AND event_id > %lli", (long long int)collection.thread_id,
+                   (long long int)collection.last_event_id);
+    std::unique_ptr<sql::ResultSet> result(stmt->executeQuery(
+      "SELECT st.* FROM (SELECT * FROM performance_schema.events_statements_current" + conditions +
+      " UNION SELECT * FROM performance_schema.events_statements_history" + conditions +
+      " UNION SELECT * FROM performance_schema.events_statements_history_long" + conditions +
+      ") st WHERE st.nesting_event_type IS NULL OR st.nesting_event_type <> 'STATEMENT' ORDER BY st.event_id"));
     while (result->next()) {
-      double wait_time = (double)result->getInt64("timer_wait") / 1000000000.0; // ps to ms
-      std::string event = result->getString("event_name");
-
-      // rename the stage/sql/Sending data event to something more suitable
-      if (event == "stage/sql/Sending data")
-        event = "executing (storage engine)";
-
-      bool flag = false;
-      for (std::vector<PSStage>::iterator iter = stages.begin(); iter != stages.end(); ++iter) {
-        if (iter->name == event) {
-          flag = true;
-          iter->wait_time += wait_time;
-          break;
-        }
-      }
-
-      if (!flag) {
-        PSStage stage;
-        stage.name = event;
-        stage.wait_time = wait_time;
-        stages.push_back(stage);
-      }
+      StatementEvent event;
+      event.sql_text = result->getString("SQL_TEXT");
+      event.event_id = result->getInt64("EVENT_ID");
+      event.end_event_id = result->getInt64("END_EVENT_ID");
+      for (const char **field = ps_stat_fields; *field; ++field)
+        event.stats[*field] = result->getInt64(*field);
+      events.push_back(event);
     }
   } catch (sql::SQLException &exc) {
-    logException("Error querying performance_schema.event_stages_history\n", exc);
+    logException("Error querying performance_schema statement events\n", exc);
+    return;
   }
 
-  return stages;
-}
+  // Statements still running or without an end id extend to the start of the next statement.
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    if (events[i].end_event_id == 0)
+      events[i].end_event_id = (i + 1 < events.size()) ? events[i + 1].event_id - 1 : INT64_MAX;
+  }
 
-std::vector<SqlEditorForm::PSWait> SqlEditorForm::query_ps_waits(std::int64_t stmt_event_id) {
-  RecMutexLock lock(ensure_valid_aux_connection());
+  if (!events.empty()) {
+    try {
+      std::string range = base::strfmt(" WHERE thread_id = %lli AND event_id BETWEEN %lli AND %lli",
+                                       (long long int)collection.thread_id,
+                                       (long long int)events.front().event_id,
+                                       (long long int)events.back().end_event_id);
+      std::unique_ptr<sql::ResultSet> result(stmt->executeQuery(
+        "SELECT 0 AS kind, event_id, event_name, timer_wait FROM performance_schema.events_stages_history_long" +
+        range + " UNION ALL SELECT 1, event_id, event_name, timer_wait"
+                " FROM performance_schema.events_waits_history_long" +
+        range));
+      while (result->next()) {
+        std::int64_t event_id = result->getInt64(2);
+
+        // Find the last statement starting before the event.
+        auto owner = std::upper_bound(
+          events.begin(), events.end(), event_id,
+          [](std::int64_t id, const StatementEvent &event) { return id < event.event_id; });
+        if (owner == events.begin())
+          continue;
+        --owner;
+        if (event_id > owner->end_event_id)
+          continue;
 
-  std::auto_ptr<sql::Statement> stmt(_aux_dbc_conn->ref->createStatement());
-  std::vector<PSWait> waits;
-  try {
-    std::auto_ptr<sql::ResultSet> result(stmt->executeQuery(
-      base::strfmt("SELECT st.* FROM performance_schema.events_waits_history_long st WHERE st.nesting_event_id = %lli",
-                   (long long int)stmt_event_id)));
-    while (result->next()) {
-      double wait_time = (double)result->getInt64("timer_wait") / 1000000000.0; // ps to ms
-      std::string event = result->getString("event_name");
-      bool flag = false;
-      for (std::vector<PSWait>::iterator iter = waits.begin(); iter != waits.end(); ++iter) {
-        if (iter->name == event) {
-          flag = true;
-          iter->wait_time += wait_time;
-          break;
-        }
+        double wait_time = (double)result->getInt64(4) / 1000000000.0; // ps to ms
+        std::string name = result->getString(3);
+        if (result->getInt(1) == 0) {
+          // rename the stage/sql/Sending data event to something more suitable
+          if (name == "stage/sql/Sending data")
+            name = "executing (storage engine)";
+          add_ps_wait_time(owner->stages, name, wait_time);
+        } else
+          add_ps_wait_time(owner->waits, name, wait_time);
       }
+    } catch (sql::SQLException &exc) {
+      logException("Error querying performance_schema stage and wait events\n", exc);
+    }
+  }
 
-      if (!flag) {
-        PSWait wait;
-        wait.name = event;
-        wait.wait_time = wait_time;
-        waits.push_back(wait);
+  std::size_t next_event = 0;
+  std::size_t last_offset = (std::size_t)-1;
+  StatementEvent *last_match = nullptr;
+  std::vector<std::pair<RecordsetData *, StatementEvent *>> matches;
+  for (auto &statement : collection.statements) {
+    StatementEvent *match = nullptr;
+    if (statement.offset == last_offset)
+      match = last_match; // Another result set of the same statement.
+    else {
+      for (std::size_t i = next_event; i < events.size(); ++i) {
+        // SQL_TEXT is cut off (and may end with an ellipsis) if the statement is longer than the server keeps.
+        std::string sql_text = events[i].sql_text;
+        if (base::hasSuffix(sql_text, "..."))
+          sql_text.resize(sql_text.size() - 3);
+        if (!sql_text.empty() && statement.sql.compare(0, sql_text.size(), sql_text) == 0) {
+          match = &events[i];
+          next_event = i + 1;
+          break;
+        }
       }
     }
-  } catch (sql::SQLException &exc) {
-    logException("Error querying performance_schema.event_waits_history\n", exc);
-  }
-  return waits;
+    last_offset = statement.offset;
+    last_match = match;
+
+    RecordsetData *rdata = dynamic_cast<RecordsetData *>(statement.recordset->client_data());
+    if (rdata)
+      matches.push_back({rdata, match});
+  }
+
+  // The stats panel reads this data in the main thread.
+  task->execute_in_main_thread(
+    [&matches]() {
+      for (auto &match : matches) {
+        if (match.second) {
+          match.first->ps_stat_info = match.second->stats;
+          match.first->ps_stage_info = match.second->stages;
+          match.first->ps_wait_info = match.second->waits;
+        } else
+          match.first->ps_stat_error =
+            "No Performance Schema data was found for this statement. The statement history may have been "
+            "overwritten already.";
+      }
+    },
+    true, false);
 }
 
+//--------------------------------------------------------------------------------------------------
+
 SqlEditorPanel *SqlEditorForm::run_sql_in_scratch_tab(const std::string &sql, bool reuse_if_possible,
                                                       bool start_collapsed) {
   SqlEditorPanel *editor;
@@ -889,13 +1352,24 @@ void logToWorkbenchLog(int messageType, std::string const &msg) {
   }
 }
 
+// The error count of the SQL run executing in the current thread, if any (see do_exec_sql). Runs on pooled
+// connections go on in parallel, each in its own thread.
+static thread_local int *current_exec_sql_error_count = nullptr;
+
+static void count_exec_sql_error(std::atomic<int> &form_error_count) {
+  if (current_exec_sql_error_count != nullptr)
+    ++*current_exec_sql_error_count;
+  else
+    ++form_error_count;
+}
+
 int SqlEditorForm::add_log_message(int messageType, const std::string &msg, const std::string &context,
                                    const std::string &duration) {
   RowId new_log_message_index = _log->add_message(messageType, context, msg, duration);
   _has_pending_log_messages = true;
   refresh_log_messages(false);
   if (messageType == DbSqlEditorLog::ErrorMsg || messageType == DbSqlEditorLog::WarningMsg)
-    _exec_sql_error_count++;
+    count_exec_sql_error(_exec_sql_error_count);
 
   logToWorkbenchLog(messageType, msg);
   return (int)new_log_message_index;
@@ -907,7 +1381,7 @@ void SqlEditorForm::set_log_message(RowId log_message_index, int messageType, co
     _log->set_message(log_message_index, messageType, context, msg, duration);
     _has_pending_log_messages = true;
     if (messageType == DbSqlEditorLog::ErrorMsg || messageType == DbSqlEditorLog::WarningMsg)
-      ++_exec_sql_error_count;
+      count_exec_sql_error(_exec_sql_error_count);
     refresh_log_messages(messageType == DbSqlEditorLog::BusyMsg); // Force refresh only for busy messages.
   }
 
@@ -1277,7 +1751,7 @@ grt::StringRef SqlEditorForm::do_connect(std::shared_ptr<sql::TunnelConnection>
     create_connection(_aux_dbc_conn, _connection, tunnel, auth, _aux_dbc_conn->autocommit_mode, false);
     create_connection(_usr_dbc_conn, _connection, tunnel, auth, _usr_dbc_conn->autocommit_mode, true);
     _serverIsOffline = false;
-    cache_sql_mode();
+    cache_sql_mode(_usr_dbc_conn);
 
     // We need this so later we can get tunnel port
     _tunnel = tunnel;
@@ -1322,6 +1796,7 @@ grt::StringRef SqlEditorForm::do_connect(std::shared_ptr<sql::TunnelConnection>
       std::string value;
       if (_usr_dbc_conn && get_session_variable(_usr_dbc_conn->ref.get(), "lower_case_table_names", value))
         _lower_case_table_names = base::atoi<int>(value, 0);
+      _databaseSymbols.setCaseSensitive(_lower_case_table_names == 0);
 
       parsers::MySQLParserServices::Ref services = parsers::MySQLParserServices::get();
       _work_parser_context =
@@ -1514,6 +1989,15 @@ void SqlEditorForm::close_connection(sql::Dbc_connection_handler::Ref &dbc_conn)
 RecMutexLock SqlEditorForm::ensure_valid_dbc_connection(sql::Dbc_connection_handler::Ref &dbc_conn,
                                                         base::RecMutex &dbc_conn_mutex, bool throw_on_block,
                                                         bool lockOnly) {
+  // Callers not asking for the lock only are about to run a statement. A streamed result set keeps the connection
+  // busy until it is closed, so its query is interrupted first. That goes through the aux connection and must not
+  // happen while holding this connection's lock (a fetch of the next rows might hold it for a while).
+  if (!lockOnly) {
+    sql::Dbc_connection_handler::Ref streaming_conn(dbc_conn);
+    if (streaming_conn)
+      streaming_conn->interrupt_streaming();
+  }
+
   RecMutexLock mutex_lock(dbc_conn_mutex, throw_on_block);
   bool valid = false;
 
@@ -1522,6 +2006,8 @@ RecMutexLock SqlEditorForm::ensure_valid_dbc_connection(sql::Dbc_connection_hand
     if (lockOnly) // this is a special case, we need it in some situations like for example recordset_cdbc
       return mutex_lock;
 
+    dbc_conn->finish_streaming();
+
     try {
       // use connector::isValid to check if server connection is valid
       // this will also ping the server and reconnect if needed
@@ -1531,7 +2017,7 @@ RecMutexLock SqlEditorForm::ensure_valid_dbc_connection(sql::Dbc_connection_hand
       valid = false;
     }
     if (!valid) {
-      bool user_connection = _usr_dbc_conn ? dbc_conn->ref.get_ptr() == _usr_dbc_conn->ref.get_ptr() : false;
+      bool user_connection = is_user_connection(dbc_conn);
 
       if (dbc_conn->autocommit_mode) {
         sql::AuthenticationSet authset;
@@ -1603,12 +2089,17 @@ bool SqlEditorForm::collect_ps_statement_events() const {
 }
 
 void SqlEditorForm::cancel_query() {
+  // With the connection pool enabled the active tab may run its query on its own session.
+  PooledConnectionRef pooled = pooled_connection_for(active_sql_editor_panel());
+  sql::Dbc_connection_handler::Ref dbc_conn = pooled ? pooled->conn : _usr_dbc_conn;
+  GrtThreadedTask::Ref task = pooled ? pooled->task : exec_sql_task;
+
   std::string query_kill_query;
   {
     db_mgmt_RdbmsRef rdbms = db_mgmt_RdbmsRef::cast_from(_connection->driver()->owner());
     SqlFacade::Ref sql_facade = SqlFacade::instance_for_rdbms(rdbms);
     Sql_specifics::Ref sql_specifics = sql_facade->sqlSpecifics();
-    query_kill_query = sql_specifics->query_kill_query(_usr_dbc_conn->id);
+    query_kill_query = sql_specifics->query_kill_query(dbc_conn->id);
   }
   if (query_kill_query.empty())
     return;
@@ -1627,15 +2118,15 @@ void SqlEditorForm::cancel_query() {
         stmt->execute(query_kill_query);
 
         // this can potentially cause threading issues, since connector driver isn't thread-safe
-        // close_connection(_usr_dbc_conn);
+        // close_connection(dbc_conn);
 
         // connection drop doesn't interrupt fetching stage (surprisingly)
         // to workaround that we set special flag and check it periodically during fetching
-        _usr_dbc_conn->is_stop_query_requested = is_running_query();
+        dbc_conn->is_stop_query_requested = pooled ? pooled->running.load() : _is_running_query;
       }
     }
 
-    if (_usr_dbc_conn->is_stop_query_requested) {
+    if (dbc_conn->is_stop_query_requested) {
       bec::GRTManager::get()->replace_status_text("Query Cancelled");
       set_log_message(log_message_index, DbSqlEditorLog::NoteMsg, _("OK - Query cancelled"), STATEMENT,
                       timer.duration_formatted());
@@ -1644,9 +2135,9 @@ void SqlEditorForm::cancel_query() {
                       timer.duration_formatted());
 
     // reconnect but only if in autocommit mode
-    if (_usr_dbc_conn->autocommit_mode) {
+    if (dbc_conn->autocommit_mode) {
       // this will restore connection if it was established previously
-      exec_sql_task->execute_in_main_thread(std::bind(&SqlEditorForm::send_message_keep_alive, this), false, true);
+      task->execute_in_main_thread(std::bind(&SqlEditorForm::send_message_keep_alive, this), false, true);
     }
   }
   CATCH_SQL_EXCEPTION_AND_DISPATCH(STATEMENT, log_message_index, "")
@@ -1663,6 +2154,7 @@ void SqlEditorForm::rollback() {
 void SqlEditorForm::explain_current_statement() {
   SqlEditorPanel *panel = active_sql_editor_panel();
   if (panel) {
+    panel->finish_loading();
     SqlEditorResult *result = panel->add_panel_for_recordset(Recordset::Ref());
     result->set_title("Explain");
 
@@ -1682,15 +2174,44 @@ void SqlEditorForm::exec_sql_retaining_editor_contents(const std::string &sql_sc
   if (!connected())
     throw grt::db_not_connected("Not connected");
 
+  PooledConnectionRef pooled;
+  GrtThreadedTask::Ref task = exec_task_for(editor, pooled);
+
   if (editor) {
     editor->query_started(true);
-    exec_sql_task->finish_cb(std::bind(&SqlEditorPanel::query_finished, editor), true);
-    exec_sql_task->fail_cb(std::bind(&SqlEditorPanel::query_failed, editor, std::placeholders::_1), true);
+    task->finish_cb(std::bind(&SqlEditorPanel::query_finished, editor), true);
+    task->fail_cb(std::bind(&SqlEditorPanel::query_failed, editor, std::placeholders::_1), true);
   }
 
-  exec_sql_task->exec(sync, std::bind(&SqlEditorForm::do_exec_sql, this, weak_ptr_from(this),
-                                      std::shared_ptr<std::string>(new std::string(sql_script)), editor,
-                                      (ExecFlags)(dont_add_limit_clause ? DontAddLimitClause : 0), RecordsetsRef()));
+  task->exec(sync, std::bind(&SqlEditorForm::do_exec_sql, this, weak_ptr_from(this),
+                             std::shared_ptr<std::string>(new std::string(sql_script)), editor,
+                             (ExecFlags)(dont_add_limit_clause ? DontAddLimitClause : 0), RecordsetsRef(),
+                             statement_classifier_context(), pooled));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Returns a copy of the work parser context, used by do_exec_sql to classify statements in its worker thread.
+ * The work context belongs to the main thread, so the copy is made there before the worker starts. Elsewhere
+ * nothing is returned and statements are classified the old way.
+ */
+parsers::MySQLParserContext::Ref SqlEditorForm::statement_classifier_context() {
+  if (!_work_parser_context || !bec::GRTManager::get()->in_main_thread())
+    return parsers::MySQLParserContext::Ref();
+  return parsers::MySQLParserServices::get()->cloneParserContext(_work_parser_context);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the task to run queries for the given editor with. With the connection pool enabled this is the task of
+ * the pooled connection leased by the editor, otherwise (or if the pool is exhausted) the shared exec_sql_task.
+ * Statements not bound to an editor (e.g. COMMIT from the toolbar) go to the session of the active tab.
+ */
+GrtThreadedTask::Ref SqlEditorForm::exec_task_for(SqlEditorPanel *editor, PooledConnectionRef &pooled) {
+  pooled = (editor != nullptr) ? lease_pooled_connection(editor) : pooled_connection_for(active_sql_editor_panel());
+  return pooled ? pooled->task : exec_sql_task;
 }
 
 void SqlEditorForm::run_editor_contents(bool current_statement_only) {
@@ -1707,7 +2228,7 @@ RecordsetsRef SqlEditorForm::exec_sql_returning_results(const std::string &sql_s
   RecordsetsRef rsets(new Recordsets());
 
   do_exec_sql(weak_ptr_from(this), std::shared_ptr<std::string>(new std::string(sql_script)), nullptr,
-              (ExecFlags)(dont_add_limit_clause ? DontAddLimitClause : 0), rsets);
+              (ExecFlags)(dont_add_limit_clause ? DontAddLimitClause : 0), rsets, statement_classifier_context());
 
   return rsets;
 }
@@ -1738,6 +2259,9 @@ bool SqlEditorForm::exec_editor_sql(SqlEditorPanel *editor, bool sync, bool curr
   logDebug("Executing SQL in editor: %s (current statement only: %s)...\n", editor->get_title().c_str(),
            current_statement_only ? "yes" : "no");
 
+  // Statement ranges and the full text are only valid once the file is loaded completely.
+  editor->finish_loading();
+
   std::shared_ptr<std::string> shared_sql;
   if (current_statement_only)
     shared_sql.reset(new std::string(editor->editor_be()->current_statement()));
@@ -1763,18 +2287,21 @@ bool SqlEditorForm::exec_editor_sql(SqlEditorPanel *editor, bool sync, bool curr
     flags = (ExecFlags)(flags | ShowWarnings);
   auto_save();
 
+  PooledConnectionRef pooled;
+  GrtThreadedTask::Ref task = exec_task_for(editor, pooled);
+
   // If we're filling an already existing result panel, we shouldn't close the old result sets.
   editor->query_started(into_result ? true : false);
-  exec_sql_task->finish_cb(std::bind(&SqlEditorPanel::query_finished, editor), true);
-  exec_sql_task->fail_cb(std::bind(&SqlEditorPanel::query_failed, editor, std::placeholders::_1), true);
+  task->finish_cb(std::bind(&SqlEditorPanel::query_finished, editor), true);
+  task->fail_cb(std::bind(&SqlEditorPanel::query_failed, editor, std::placeholders::_1), true);
 
   if (into_result) {
     logDebug2("Running into existing rsets\n");
 
     RecordsetsRef rsets(new Recordsets());
 
-    exec_sql_task->exec(sync, std::bind(&SqlEditorForm::do_exec_sql, this, weak_ptr_from(this), shared_sql,
-                                        (SqlEditorPanel *)nullptr, flags, rsets));
+    task->exec(sync, std::bind(&SqlEditorForm::do_exec_sql, this, weak_ptr_from(this), shared_sql,
+                               (SqlEditorPanel *)nullptr, flags, rsets, statement_classifier_context(), pooled));
 
     if (rsets->size() > 1)
       logError("Statement returns too many resultsets\n");
@@ -1783,8 +2310,8 @@ bool SqlEditorForm::exec_editor_sql(SqlEditorPanel *editor, bool sync, bool curr
   } else {
     logDebug2("Running without considering existing rsets\n");
 
-    exec_sql_task->exec(sync, std::bind(&SqlEditorForm::do_exec_sql, this, weak_ptr_from(this), shared_sql, editor,
-                                        flags, RecordsetsRef()));
+    task->exec(sync, std::bind(&SqlEditorForm::do_exec_sql, this, weak_ptr_from(this), shared_sql, editor, flags,
+                               RecordsetsRef(), statement_classifier_context(), pooled));
   }
 
   return true;
@@ -1794,23 +2321,70 @@ void SqlEditorForm::update_live_schema_tree(const std::string &sql) {
   bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlEditorForm::handle_command_side_effects, this, sql));
 }
 
+/**
+ * Determines the statement type from its first keyword, like Sql_syntax_check::determine_statement_type, but using
+ * only the lexer of the new parser (which reads just the start of a statement). Falls back to the old implementation
+ * if no parser context is available.
+ */
+class StatementTypeClassifier {
+public:
+  StatementTypeClassifier(parsers::MySQLParserContext::Ref context, Sql_syntax_check::Ref fallback)
+    : _context(context), _fallback(fallback) {
+    if (!_context)
+      return;
+
+    _services = parsers::MySQLParserServices::get();
+    static const std::pair<const char *, Sql_syntax_check::Statement_type> keywords[] = {
+      { "CREATE_SYMBOL", Sql_syntax_check::sql_create },     { "ALTER_SYMBOL", Sql_syntax_check::sql_alter },
+      { "DROP_SYMBOL", Sql_syntax_check::sql_drop },         { "INSERT_SYMBOL", Sql_syntax_check::sql_insert },
+      { "DELETE_SYMBOL", Sql_syntax_check::sql_delete },     { "UPDATE_SYMBOL", Sql_syntax_check::sql_update },
+      { "SELECT_SYMBOL", Sql_syntax_check::sql_select },     { "DESC_SYMBOL", Sql_syntax_check::sql_describe },
+      { "DESCRIBE_SYMBOL", Sql_syntax_check::sql_describe }, { "SHOW_SYMBOL", Sql_syntax_check::sql_show },
+      { "USE_SYMBOL", Sql_syntax_check::sql_use },           { "LOAD_SYMBOL", Sql_syntax_check::sql_load },
+      { "SET_SYMBOL", Sql_syntax_check::sql_set },
+    };
+    for (auto &keyword : keywords)
+      _types[_services->tokenFromString(_context, keyword.first)] = keyword.second;
+    _types[0] = Sql_syntax_check::sql_empty;
+  }
+
+  Sql_syntax_check::Statement_type classify(const std::string &statement) {
+    if (!_context)
+      return _fallback->determine_statement_type(statement);
+
+    auto iterator = _types.find(_services->determineFirstTokenType(_context, statement));
+    return iterator == _types.end() ? Sql_syntax_check::sql_unknown : iterator->second;
+  }
+
+private:
+  parsers::MySQLParserContext::Ref _context;
+  parsers::MySQLParserServices::Ref _services = nullptr;
+  Sql_syntax_check::Ref _fallback;
+  std::map<size_t, Sql_syntax_check::Statement_type> _types;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
 grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::string> sql, SqlEditorPanel *editor,
-                                          ExecFlags flags, RecordsetsRef result_list) {
+                                          ExecFlags flags, RecordsetsRef result_list,
+                                          parsers::MySQLParserContext::Ref classifier_context,
+                                          PooledConnectionRef pooled) {
 
   logDebug("Background task for sql execution started\n");
 
   bool use_non_std_delimiter = (flags & NeedNonStdDelimiter) != 0;
   bool dont_add_limit_clause = (flags & DontAddLimitClause) != 0;
-  std::map<std::string, std::int64_t> ps_stats;
-  std::vector<PSStage> ps_stages;
-  std::vector<PSWait> ps_waits;
   bool query_ps_stats = collect_ps_statement_events();
-  std::string query_ps_statement_events_error;
+  PSCollection ps_collection;
   std::string statement;
   int max_query_size_to_log = (int)bec::GRTManager::get()->get_app_option_int("DbSqlEditor:MaxQuerySizeToHistory", 0);
   int limit_rows = 0;
   if (bec::GRTManager::get()->get_app_option_int("SqlEditor:LimitRows") != 0)
     limit_rows = (int)bec::GRTManager::get()->get_app_option_int("SqlEditor:LimitRowsCount", 0);
+  // Streamed results replace the LIMIT clause by a fetch budget, the rest of the rows can be fetched on request.
+  bool stream_results = bec::GRTManager::get()->get_app_option_int("DbSqlEditor:StreamResultsets", 0) != 0;
+  size_t stream_byte_budget =
+    (size_t)bec::GRTManager::get()->get_app_option_int("DbSqlEditor:StreamResultsetMemoryBudget", 64) * 1024 * 1024;
 
   bec::GRTManager::get()->replace_status_text(_("Executing Query..."));
 
@@ -1821,19 +2395,47 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
     return grt::StringRef("");
   }
 
-  // add_log_message() will increment this variable on errors or warnings
-  _exec_sql_error_count = 0;
+  // add_log_message() and set_log_message() count errors and warnings of this run here, the total is published
+  // when the run is done.
+  int error_count = 0;
+  int *outer_error_count = current_exec_sql_error_count;
+  current_exec_sql_error_count = &error_count;
+  base::ScopeExitTrigger publish_error_count([this, &error_count, outer_error_count]() {
+    current_exec_sql_error_count = outer_error_count;
+    _exec_sql_error_count = error_count;
+  });
+
+  // Without a pooled connection all editors share the user connection and the exec_sql_task.
+  sql::Dbc_connection_handler::Ref dbc_conn = pooled ? pooled->conn : _usr_dbc_conn;
+  GrtThreadedTask::Ref task = pooled ? pooled->task : exec_sql_task;
+
+  // Result sets are reloaded and fetched on the session which ran their query.
+  std::function<base::RecMutexLock(sql::Dbc_connection_handler::Ref &, bool)> get_run_connection;
+  if (pooled)
+    get_run_connection =
+      std::bind(&SqlEditorForm::getPooledConnection, this, pooled, std::placeholders::_1, std::placeholders::_2);
+  else
+    get_run_connection =
+      std::bind(&SqlEditorForm::getUserConnection, this, std::placeholders::_1, std::placeholders::_2);
 
   bool interrupted = true;
   sql::Driver *dbc_driver = nullptr;
   try {
-    RecMutexLock use_dbc_conn_mutex(ensure_valid_usr_connection());
+    RecMutexLock use_dbc_conn_mutex(pooled ? ensure_valid_pooled_connection(pooled) : ensure_valid_usr_connection());
 
-    dbc_driver = _usr_dbc_conn->ref->getDriver();
+    dbc_driver = dbc_conn->ref->getDriver();
     dbc_driver->threadInit();
 
-    bool is_running_query = true;
-    AutoSwap<bool> is_running_query_keeper(_is_running_query, is_running_query);
+    if (pooled)
+      pooled->running = true;
+    else
+      _is_running_query = true;
+    base::ScopeExitTrigger is_running_query_keeper([this, pooled]() {
+      if (pooled)
+        pooled->running = false;
+      else
+        _is_running_query = false;
+    });
     update_menu_and_toolbar();
 
     _has_pending_log_messages = false;
@@ -1843,16 +2445,17 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
     Sql_syntax_check::Ref sql_syntax_check = sql_facade->sqlSyntaxCheck();
     Sql_specifics::Ref sql_specifics = sql_facade->sqlSpecifics();
 
+    // Classifies with a copy of the work context made by the caller (see statement_classifier_context()).
+    StatementTypeClassifier statement_classifier(classifier_context, sql_syntax_check);
+
     bool ran_set_sql_mode = false;
     bool logging_queries;
     std::vector<std::pair<std::size_t, std::size_t>> statement_ranges;
     sql_facade->splitSqlScript(sql->c_str(), sql->size(),
                                use_non_std_delimiter ? sql_specifics->non_std_sql_delimiter() : ";", statement_ranges);
 
-    if (statement_ranges.size() > 1) {
-      query_ps_stats = false;
-      query_ps_statement_events_error = "Query stats can only be fetched when a single statement is executed.";
-    }
+    if (query_ps_stats)
+      query_ps_stats = begin_ps_collection(dbc_conn->id, ps_collection);
 
     if (!max_query_size_to_log || max_query_size_to_log >= (int)sql->size()) {
       logging_queries = true;
@@ -1884,7 +2487,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
         if (statement.empty())
           continue;
 
-        Sql_syntax_check::Statement_type statement_type = sql_syntax_check->determine_statement_type(statement);
+        Sql_syntax_check::Statement_type statement_type = statement_classifier.classify(statement);
 
         logDebug3("Determined statement type: %u\n", statement_type);
         if (Sql_syntax_check::sql_empty == statement_type)
@@ -1906,8 +2509,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
           data_storage = Recordset_cdbc_storage::create();
           data_storage->set_gather_field_info(true);
           data_storage->rdbms(rdbms());
-          data_storage->setUserConnectionGetter(
-            std::bind(&SqlEditorForm::getUserConnection, this, std::placeholders::_1, std::placeholders::_2));
+          data_storage->setUserConnectionGetter(get_run_connection);
           data_storage->setAuxConnectionGetter(
             std::bind(&SqlEditorForm::getAuxConnection, this, std::placeholders::_1, std::placeholders::_2));
 
@@ -1915,7 +2517,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
 
           if (!table_name.empty() ||
               sql_facade->parseSelectStatementForEdit(statement, schema_name, table_name, column_names)) {
-            data_storage->schema_name(schema_name.empty() ? _usr_dbc_conn->active_schema : schema_name);
+            data_storage->schema_name(schema_name.empty() ? dbc_conn->active_schema : schema_name);
             data_storage->table_name(table_name);
             logDebug3("Result will be editable\n");
           } else {
@@ -1927,7 +2529,10 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
 
           data_storage->sql_query(statement);
 
-          {
+          // Only for the shared user connection, the storage fetches further rows through it.
+          if (stream_results && !pooled)
+            data_storage->fetch_budget(limit_rows, stream_byte_budget);
+          else {
             bool do_limit = !dont_add_limit_clause && limit_rows > 0;
             data_storage->limit_rows(do_limit);
 
@@ -1945,10 +2550,12 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
           long long updated_rows_count = -1;
           Timer statement_exec_timer(false);
           Timer statement_fetch_timer(false);
-          std::shared_ptr<sql::Statement> dbc_statement(_usr_dbc_conn->ref->createStatement());
+          std::shared_ptr<sql::Statement> dbc_statement(dbc_conn->ref->createStatement());
+          if (data_storage && data_storage->streaming())
+            dbc_statement->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY); // Unbuffered, rows are read as we go.
           bool is_result_set_first = false;
 
-          if (_usr_dbc_conn->is_stop_query_requested)
+          if (dbc_conn->is_stop_query_requested)
             throw std::runtime_error(
               _("Query execution has been stopped, the connection to the DB server was not restarted, any open "
                 "transaction remains open"));
@@ -1968,9 +2575,12 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
             // and killing any intermittent USE commands.
             // Updating the UI during a run of many commands is not useful either.
             if (Sql_syntax_check::sql_use == statement_type)
-              cache_active_schema_name();
-            if (Sql_syntax_check::sql_set == statement_type && statement.find("@sql_mode") != std::string::npos)
-              ran_set_sql_mode = true;
+              cache_active_schema_name(dbc_conn);
+            if (Sql_syntax_check::sql_set == statement_type) {
+              if (statement.find("@sql_mode") != std::string::npos)
+                ran_set_sql_mode = true;
+              record_session_statement(statement, pooled);
+            }
             if (Sql_syntax_check::sql_drop == statement_type)
               update_live_schema_tree(statement);
           } catch (sql::SQLException &e) {
@@ -2042,6 +2652,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
           int resultset_count = 0;
           bool more_results = is_result_set_first;
           bool reuse_log_msg = false;
+          bool rows_pending = false;
           if ((updated_rows_count < 0) || is_multiple_statement) {
             for (std::size_t processed_substatements_count = 0;
                  processed_substatements_count < multiple_statement_count; ++processed_substatements_count) {
@@ -2127,8 +2738,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                       data_storage = Recordset_cdbc_storage::create();
                       data_storage->set_gather_field_info(true);
                       data_storage->rdbms(rdbms());
-                      data_storage->setUserConnectionGetter(std::bind(&SqlEditorForm::getUserConnection, this,
-                                                                      std::placeholders::_1, std::placeholders::_2));
+                      data_storage->setUserConnectionGetter(get_run_connection);
                       data_storage->setAuxConnectionGetter(std::bind(&SqlEditorForm::getAuxConnection, this,
                                                                      std::placeholders::_1, std::placeholders::_2));
                       if (table_name.empty())
@@ -2144,7 +2754,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
 
                     logDebug3("Creation and setup of a new result set...\n");
 
-                    Recordset::Ref rs = Recordset::create(exec_sql_task);
+                    Recordset::Ref rs = Recordset::create(task);
                     rs->is_field_value_truncation_enabled(true);
                     rs->setPreserveRowFilter(
                       bec::GRTManager::get()->get_app_option_int("SqlEditor:PreserveRowFilter") == 1);
@@ -2153,19 +2763,11 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                     rs->generator_query(statement);
 
                     {
-                      if (query_ps_stats) {
-                        query_ps_statistics(_usr_dbc_conn->id, ps_stats);
-                        ps_stages = query_ps_stages(ps_stats["EVENT_ID"]);
-                        ps_waits = query_ps_waits(ps_stats["EVENT_ID"]);
-                        query_ps_stats = false;
-                      }
                       RecordsetData *rdata = new RecordsetData();
                       rdata->duration = statement_exec_timer.duration();
-                      rdata->ps_stat_error = query_ps_statement_events_error;
-                      rdata->ps_stat_info = ps_stats;
-                      rdata->ps_stage_info = ps_stages;
-                      rdata->ps_wait_info = ps_waits;
                       rs->set_client_data(rdata);
+                      if (query_ps_stats)
+                        ps_collection.statements.push_back({statement_range.first, statement, rs});
                     }
 
                     rs->data_storage(data_storage);
@@ -2180,6 +2782,8 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                         editor->add_panel_for_recordset_from_main(rs);
 
                       std::string statement_res_msg = std::to_string(rs->row_count()) + _(" row(s) returned");
+                      if (rs->has_pending_rows())
+                        statement_res_msg.append(_(", more rows available"));
                       if (!last_statement_info->empty())
                         statement_res_msg.append("\n").append(last_statement_info);
 
@@ -2191,9 +2795,12 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                     reuse_log_msg = true;
                   }
                   ++total_result_count;
+                  // A streamed result set is still open, there can't be more results until it is read completely.
+                  if (data_storage && data_storage->has_pending_rows())
+                    rows_pending = true;
                   data_storage.reset();
                 }
-              } while ((more_results = dbc_statement->getMoreResults()));
+              } while (!rows_pending && (more_results = dbc_statement->getMoreResults()));
             }
           }
 
@@ -2205,7 +2812,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
     } // statement range loop
 
     if (results_left) {
-      exec_sql_task->execute_in_main_thread(
+      task->execute_in_main_thread(
         std::bind(&mforms::Utilities::show_warning, _("Result set limit reached"),
                   _("There were more results than "
                     "result tabs could be opened, because the set maximum limit was reached. You can change this "
@@ -2218,12 +2825,14 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
     interrupted = false;
 
   stop_processing_sql_script:
+    if (query_ps_stats)
+      finish_ps_collection(ps_collection, task);
     if (interrupted)
       bec::GRTManager::get()->replace_status_text(_("Query interrupted"));
     // try to minimize the times this is called, since this will change the state of the connection
     // after a user query is ran (eg, it will reset all warnings)
     if (ran_set_sql_mode)
-      cache_sql_mode();
+      cache_sql_mode(dbc_conn);
   }
   CATCH_ANY_EXCEPTION_AND_DISPATCH(statement)
 
@@ -2234,7 +2843,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
 
   update_menu_and_toolbar();
 
-  _usr_dbc_conn->is_stop_query_requested = false;
+  dbc_conn->is_stop_query_requested = false;
 
   return grt::StringRef("");
 }
@@ -2388,7 +2997,21 @@ db_query_ResultsetRef SqlEditorForm::exec_main_query(const std::string &sql, boo
   return db_query_ResultsetRef();
 }
 
+/**
+ * Returns true if a query is running on any connection of this form, including the pooled ones.
+ */
 bool SqlEditorForm::is_running_query() {
+  return _is_running_query || has_busy_pooled_connections();
+}
+
+/**
+ * Returns true if the active editor tab can't run another query, because one is running on the connection it uses.
+ * With the connection pool enabled other tabs can still run queries on their own sessions.
+ */
+bool SqlEditorForm::is_running_query_in_active_editor() {
+  PooledConnectionRef pooled = pooled_connection_for(active_sql_editor_panel());
+  if (pooled)
+    return pooled->running;
   return _is_running_query;
 }
 
@@ -2410,7 +3033,12 @@ void SqlEditorForm::send_message_keep_alive() {
     // ping server and reset connection timeout counter
     // this also checks the connection state and restores it if possible
     ensure_valid_aux_connection();
-    ensure_valid_usr_connection();
+
+    // A streamed result set which is still open keeps the user connection alive anyway. Checking it would end
+    // the stream (nothing else can be sent while it is open), so leave it alone then.
+    RecMutexLock usr_dbc_conn_mutex(ensure_valid_usr_connection(false, true));
+    if (_usr_dbc_conn && !_usr_dbc_conn->close_streamed_result)
+      ensure_valid_usr_connection();
   } catch (const std::exception &) {
   }
 }
@@ -2766,9 +3394,19 @@ void SqlEditorForm::schema_meta_data_refreshed(const std::string &schema_name, b
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void SqlEditorForm::cache_active_schema_name() {
-  std::string schema = _usr_dbc_conn->ref->getSchema();
-  _usr_dbc_conn->active_schema = schema;
+void SqlEditorForm::cache_active_schema_name(sql::Dbc_connection_handler::Ref dbc_conn) {
+  std::string schema = dbc_conn->ref->getSchema();
+  dbc_conn->active_schema = schema;
+
+  if (dbc_conn != _usr_dbc_conn) {
+    // A USE in a pooled session changes the default schema of the whole editor form, as it would with a single
+    // shared session. The other sessions pick it up before their next query.
+    exec_sql_task->execute_in_main_thread(
+      std::bind((void (SqlEditorForm::*)(const std::string &)) & SqlEditorForm::active_schema, this, schema), false,
+      true);
+    return;
+  }
+
   _aux_dbc_conn->active_schema = schema;
 
   exec_sql_task->execute_in_main_thread(std::bind(&SqlEditorForm::update_editor_title_schema, this, schema), false,
@@ -2941,6 +3579,7 @@ bool SqlEditorForm::save_snippet() {
     return false;
   std::string text;
   std::size_t start, end;
+  panel->finish_loading();
   if (panel->editor_be()->selected_range(start, end))
     text = panel->editor_be()->selected_text();
   else
@@ -2966,7 +3605,7 @@ bool SqlEditorForm::can_close() {
 }
 
 bool SqlEditorForm::can_close_(bool interactive) {
-  if (exec_sql_task && exec_sql_task->is_busy()) {
+  if ((exec_sql_task && exec_sql_task->is_busy()) || has_busy_pooled_connections()) {
     bec::GRTManager::get()->replace_status_text(_("Cannot close SQL IDE while being busy"));
     return false;
   }
@@ -44,6 +44,9 @@
 
 #include "mforms/view.h"
 
+#include <atomic>
+#include <thread>
+
 #include "SymbolTable.h"
 
 namespace mforms {
@@ -134,6 +137,7 @@ public:
 
   void cancel_connect();
   virtual void close();
+  std::string finish_auto_save();
   virtual bool is_main_form() {
     return true;
   }
@@ -288,13 +292,24 @@ public:
   bool get_session_variable(sql::Connection *dbc_conn, const std::string &name, std::string &value);
 
 private:
-  void cache_sql_mode();
+  void cache_sql_mode(sql::Dbc_connection_handler::Ref dbc_conn);
   void update_sql_mode_for_editors();
 
-  void query_ps_statistics(std::int64_t conn_id, std::map<std::string, std::int64_t> &stats);
+  // Performance schema stats of one script run, gathered in a single pass after the run.
+  struct PSCollection {
+    struct Statement {
+      std::size_t offset; // Position of the statement in the script, a statement can return several result sets.
+      std::string sql;
+      Recordset::Ref recordset;
+    };
+
+    std::int64_t thread_id = -1;
+    std::int64_t last_event_id = 0; // Last statement event of the connection before the run.
+    std::vector<Statement> statements;
+  };
 
-  std::vector<SqlEditorForm::PSStage> query_ps_stages(std::int64_t stmt_event_id);
-  std::vector<SqlEditorForm::PSWait> query_ps_waits(std::int64_t stmt_event_id);
+  bool begin_ps_collection(std::int64_t conn_id, PSCollection &collection);
+  void finish_ps_collection(PSCollection &collection, GrtThreadedTask::Ref task);
 
 private:
   void create_connection(sql::Dbc_connection_handler::Ref &dbc_conn, db_mgmt_ConnectionRef db_mgmt_conn,
@@ -328,6 +343,41 @@ private:
   base::RecMutexLock getAuxConnection(sql::Dbc_connection_handler::Ref &conn, bool lockOnly = false);
   base::RecMutexLock getUserConnection(sql::Dbc_connection_handler::Ref &conn, bool lockOnly = false);
 
+  // Opt-in pool of additional user connections (DbSqlEditor:ConnectionPoolSize > 0). Each editor tab that runs a
+  // query leases its own session from the pool, so long running queries in one tab don't block the others.
+  struct PooledConnection {
+    sql::Dbc_connection_handler::Ref conn;
+    base::RecMutex mutex;
+    GrtThreadedTask::Ref task;
+    SqlEditorPanel *owner = nullptr;
+    std::size_t applied_session_serial = 0; // Serial of the last session statement replayed.
+    std::int64_t session_id = -1;           // Connection id when the session state was last replayed.
+    std::atomic<bool> running{false};
+  };
+  typedef std::shared_ptr<PooledConnection> PooledConnectionRef;
+
+  // A recorded session changing statement, only the last one per setting is kept.
+  struct SessionStatement {
+    std::string setting;
+    std::string statement;
+    std::size_t serial;
+  };
+
+  bool connection_pool_enabled();
+  PooledConnectionRef pooled_connection_for(SqlEditorPanel *editor);
+  PooledConnectionRef lease_pooled_connection(SqlEditorPanel *editor);
+  void release_pooled_connection(SqlEditorPanel *editor);
+  void close_pooled_connections();
+  void stop_pooled_connection(PooledConnectionRef pooled);
+  bool has_busy_pooled_connections();
+  base::RecMutexLock ensure_valid_pooled_connection(PooledConnectionRef pooled);
+  base::RecMutexLock getPooledConnection(PooledConnectionRef pooled, sql::Dbc_connection_handler::Ref &conn,
+                                         bool lockOnly = false);
+  void replay_session_state(PooledConnectionRef pooled);
+  void record_session_statement(const std::string &statement, PooledConnectionRef source);
+  bool is_user_connection(const sql::Dbc_connection_handler::Ref &dbc_conn);
+  void show_pooled_connection(PooledConnectionRef pooled);
+
   void onCacheAction(bool active);
 
 public:
@@ -351,6 +401,7 @@ public:
 
   void explain_current_statement();
   bool is_running_query();
+  bool is_running_query_in_active_editor();
 
   sql::Authentication::Ref dbc_auth_data() {
     return _dbc_auth;
@@ -361,7 +412,10 @@ private:
   void update_live_schema_tree(const std::string &sql);
 
   grt::StringRef do_exec_sql(Ptr self_ptr, std::shared_ptr<std::string> sql, SqlEditorPanel *editor, ExecFlags flags,
-                             RecordsetsRef result_list);
+                             RecordsetsRef result_list, parsers::MySQLParserContext::Ref classifier_context,
+                             PooledConnectionRef pooled = PooledConnectionRef());
+  parsers::MySQLParserContext::Ref statement_classifier_context();
+  GrtThreadedTask::Ref exec_task_for(SqlEditorPanel *editor, PooledConnectionRef &pooled);
 
   void handle_command_side_effects(const std::string &sql);
 
@@ -433,7 +487,7 @@ public:
                                   base::StringListPtr procedures, base::StringListPtr functions);
 
 private:
-  void cache_active_schema_name();
+  void cache_active_schema_name(sql::Dbc_connection_handler::Ref dbc_conn);
 
 public:
   void request_refresh_schema_tree();
@@ -507,6 +561,16 @@ private:
   base::LockFile *_autosave_lock = nullptr;
   std::string _autosave_path;
 
+  // What was last auto saved where, so that auto save only writes what changed (see save_workspace()).
+  std::string _autosaved_path;
+  std::string _autosaved_schema_tree;
+  std::string _autosaved_tab_order;
+
+  // Editor contents are written by a background thread.
+  std::thread _autosave_thread;
+  std::vector<std::pair<std::string, std::string> > _autosave_contents;
+  std::string _autosave_error;
+
   mforms::DockingPoint *_tabdock = nullptr;
 
   // Set when we triggered a refresh asynchronously.
@@ -526,10 +590,10 @@ private:
   bool _startup_done = false;
   bool _is_running_query = false;
   bool _continueOnError = false;
-  bool _has_pending_log_messages = false;
+  std::atomic<bool> _has_pending_log_messages{false}; // Set from the worker threads of all connections.
 
   double _last_log_message_timestamp;
-  int _exec_sql_error_count;
+  std::atomic<int> _exec_sql_error_count{0}; // Errors and warnings of the last finished run, see do_exec_sql().
 
   std::shared_ptr<SqlEditorTreeController> _live_tree;
 
@@ -553,6 +617,14 @@ private:
   sql::Dbc_connection_handler::Ref _usr_dbc_conn;
   mutable base::RecMutex _usr_dbc_conn_mutex;
 
+  // connections leased to editor tabs when the connection pool is enabled
+  std::vector<PooledConnectionRef> _connection_pool;
+  base::Mutex _connection_pool_mutex;
+
+  // session state (SET statements) to replay on pooled connections, guarded by _connection_pool_mutex
+  std::vector<SessionStatement> _session_statements;
+  std::size_t _session_serial = 0;
+
   sql::Authentication::Ref _dbc_auth;
 
   ServerState _last_server_running_state = UnknownState;
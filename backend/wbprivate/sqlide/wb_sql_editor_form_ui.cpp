@@ -150,11 +150,11 @@ mforms::MenuBar *SqlEditorForm::get_menubar() {
 
     auto item = _menu->find_item("query.cancel");
     if (item != nullptr)
-      item->add_validator([this]() { return is_running_query() && connected(); });
+      item->add_validator([this]() { return is_running_query_in_active_editor() && connected(); });
     item = _menu->find_item("query.execute");
     if (item != nullptr)
       item->add_validator([this]() {
-        return !is_running_query() && connected() &&
+        return !is_running_query_in_active_editor() && connected() &&
                (active_sql_editor_panel() ? active_sql_editor_panel()->get_name() == "db.query.QueryBuffer" : false);
       });
     item = _menu->find_item("query.reconnect");
@@ -162,20 +162,20 @@ mforms::MenuBar *SqlEditorForm::get_menubar() {
       item->add_validator([this]() { return !is_running_query(); });
     item = _menu->find_item("wb.sqlide.executeToTextOutput");
     if (item != nullptr)
-      item->add_validator([this]() { return !is_running_query() && connected(); });
+      item->add_validator([this]() { return !is_running_query_in_active_editor() && connected(); });
     item = _menu->find_item("wb.sqlide.verticalOutput");
     if (item != nullptr)
-      item->add_validator([this]() { return !is_running_query() && connected(); });
+      item->add_validator([this]() { return !is_running_query_in_active_editor() && connected(); });
     item = _menu->find_item("query.execute_current_statement");
     if (item != nullptr)
       item->add_validator([this]() {
-        return !is_running_query() && connected() &&
+        return !is_running_query_in_active_editor() && connected() &&
                (active_sql_editor_panel() ? active_sql_editor_panel()->get_name() == "db.query.QueryBuffer" : false);
       });
     item = _menu->find_item("query.explain_current_statement");
     if (item != nullptr)
       item->add_validator([this]() {
-        return !is_running_query() && connected() &&
+        return !is_running_query_in_active_editor() && connected() &&
                (active_sql_editor_panel() ? active_sql_editor_panel()->get_name() == "db.query.QueryBuffer" : false);
       });
     item = _menu->find_item("query.commit");
@@ -219,6 +219,7 @@ void SqlEditorForm::update_menu_and_toolbar() {
   logDebug2("Updating SQL menu and toolbar\n");
 
   bool running = is_running_query();
+  bool running_in_editor = is_running_query_in_active_editor();
   bool connected = this->connected();
 
   if (_menu) {
@@ -243,13 +244,13 @@ void SqlEditorForm::update_menu_and_toolbar() {
     _toolbar->set_item_enabled("wb.dbsearch", connected);
   }
 
-  set_editor_tool_items_enbled("query.cancel", running && connected);
+  set_editor_tool_items_enbled("query.cancel", running_in_editor && connected);
 
-  set_editor_tool_items_enbled("query.execute", !running && connected);
+  set_editor_tool_items_enbled("query.execute", !running_in_editor && connected);
   set_editor_tool_items_enbled("query.reconnect", !running);
-  set_editor_tool_items_enbled("wb.sqlide.executeToTextOutput", !running && connected);
-  set_editor_tool_items_enbled("query.execute_current_statement", !running && connected);
-  set_editor_tool_items_enbled("query.explain_current_statement", !running && connected);
+  set_editor_tool_items_enbled("wb.sqlide.executeToTextOutput", !running_in_editor && connected);
+  set_editor_tool_items_enbled("query.execute_current_statement", !running_in_editor && connected);
+  set_editor_tool_items_enbled("query.explain_current_statement", !running_in_editor && connected);
 
   set_editor_tool_items_enbled("query.commit", !running && !auto_commit() && connected);
   set_editor_tool_items_enbled("query.rollback", !running && !auto_commit() && connected);
@@ -564,12 +565,16 @@ void SqlEditorForm::handle_history_action(const std::string &action, const std::
     mforms::Utilities::set_clipboard_text(sql);
   else if (action == "append") {
     SqlEditorPanel *panel = active_sql_editor_panel();
-    if (panel)
+    if (panel) {
+      panel->finish_loading();
       panel->editor_be()->append_text(sql);
+    }
   } else if (action == "replace") {
     SqlEditorPanel *panel = active_sql_editor_panel();
-    if (panel)
+    if (panel) {
+      panel->finish_loading();
       panel->editor_be()->sql(sql.c_str());
+    }
   } else
     throw std::invalid_argument("invalid history action " + action);
 }
@@ -22,7 +22,8 @@
  */
 
 #include <pcrecpp.h>
-#include <thread>
+#include <algorithm>
+#include <glib.h>
 
 #include "base/log.h"
 #include "base/string_utilities.h"
@@ -279,6 +280,94 @@ std::string DbSqlEditorContextHelp::createHelpTextFromJson(long version, JsonPar
 
 //----------------- DbSqlEditorContextHelp -----------------------------------------------------------------------------
 
+struct DbSqlEditorContextHelp::HelpFile {
+  GMappedFile *file = nullptr;
+  std::map<std::string, std::pair<size_t, size_t>> topics; // Upper case topic id -> offset + length of its JSON text.
+  std::map<std::string, std::string> content;              // Help text of the topics decoded so far.
+
+  ~HelpFile() {
+    if (file != nullptr)
+      g_mapped_file_unref(file);
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Scans the structure of a help file and collects the ids of the entries in its topic list, along with the position
+ * of their JSON text. Nothing is decoded here, except for the ids. Returns false if the file has no topic list.
+ */
+static bool indexHelpTopics(const char *data, size_t length, std::map<std::string, std::pair<size_t, size_t>> &topics) {
+  static const std::string listKey = "\"topics\"";
+  const char *end = data + length;
+  const char *run = std::search(data, end, listKey.begin(), listKey.end());
+  if (run == end)
+    return false;
+  run = std::find(run + listKey.size(), end, '[');
+  if (run == end)
+    return false;
+
+  int depth = 0; // Object nesting, 1 is the topic object itself.
+  const char *topicStart = nullptr;
+  std::string id;
+  while (++run < end) {
+    switch (*run) {
+      case '"': {
+        const char *stringStart = ++run;
+        while (run < end && *run != '"') {
+          if (*run == '\\')
+            ++run;
+          ++run;
+        }
+        if (run >= end)
+          return false;
+
+        // A member "id" of the topic object itself. Ids don't contain any escape sequence.
+        if (depth == 1 && run - stringStart == 2 && strncmp(stringStart, "id", 2) == 0) {
+          const char *next = run + 1;
+          while (next < end && isspace((unsigned char)*next))
+            ++next;
+          if (next < end && *next == ':') {
+            ++next;
+            while (next < end && isspace((unsigned char)*next))
+              ++next;
+            if (next < end && *next == '"') {
+              const char *valueEnd = std::find(next + 1, end, '"');
+              if (valueEnd == end)
+                return false;
+              id = base::toupper(std::string(next + 1, valueEnd));
+              run = valueEnd;
+            }
+          }
+        }
+        break;
+      }
+
+      case '{':
+        if (++depth == 1)
+          topicStart = run;
+        break;
+
+      case '}':
+        if (--depth == 0) {
+          if (!id.empty())
+            topics[id] = std::make_pair(topicStart - data, run + 1 - topicStart);
+          id.clear();
+        }
+        break;
+
+      case ']':
+        if (depth == 0)
+          return true; // End of the topic list.
+        break;
+    }
+  }
+
+  return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 DbSqlEditorContextHelp::DbSqlEditorContextHelp() {
 
   pageMap = {
@@ -286,65 +375,80 @@ DbSqlEditorContextHelp::DbSqlEditorContextHelp() {
     { "like", "string-comparison-functions" },
     { "auto_increment", "example-auto-increment" },
   };
-
-  loaderThread = std::thread([this]() {
-    std::string dataDir = base::makePath(mforms::App::get()->baseDir(), "modules/data/sqlide");
-    for (long version : { 800, 507, 506, 505 }) {
-      std::string fileName = "help-" + std::to_string(version / 100) + "." + std::to_string(version % 10) + ".json";
-      std::string path = base::makePath(dataDir, fileName);
-      if (!base::file_exists(path)) {
-        logError("Help file not found (%s)\n", path.c_str());
-        continue;
-      }
-
-      try {
-        JsonParser::JsonValue document;
-        JsonParser::JsonReader::readFromFile(path, document);
-
-        std::set<std::string> topics;
-        JsonParser::JsonObject &topicRoot = document;
-        JsonParser::JsonArray &topicList = topicRoot.get("topics");
-        for (JsonParser::JsonObject &topic: topicList) {
-          std::string id = base::toupper(topic.get("id"));
-          topics.insert(id);
-          helpContent[version][id] = createHelpTextFromJson(version, topic);
-        }
-        helpTopics[version] = topics;
-      } catch (JsonParser::ParserException &e) {
-        logError("Could not read help text file (%s)\nError message: %s\n", fileName.c_str(), e.what());
-      } catch (std::bad_cast &e) {
-        logError("Unexpected file format (%s)\nError message: %s\n", fileName.c_str(), e.what());
-      }
-      
-    }
-  });
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 DbSqlEditorContextHelp::~DbSqlEditorContextHelp() {
-  waitForLoading();
+  for (auto &entry : helpFiles)
+    delete entry.second;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * Help files are loaded on first use, so there's nothing to wait for. This only indexes the help files of all server
+ * versions up front.
+ */
 void DbSqlEditorContextHelp::waitForLoading() {
-  if (loaderThread.joinable())
-    loaderThread.join();
+  for (long version : { 800, 507, 506, 505 })
+    helpFileForVersion(version);
 };
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * Returns the help file for the given server version (major * 100 + minor), which is mapped into memory and indexed
+ * when it is used the first time.
+ */
+DbSqlEditorContextHelp::HelpFile *DbSqlEditorContextHelp::helpFileForVersion(long version) {
+  std::lock_guard<std::mutex> lock(helpFilesMutex);
+
+  auto iterator = helpFiles.find(version);
+  if (iterator != helpFiles.end())
+    return iterator->second;
+
+  helpFiles[version] = nullptr;
+  std::string dataDir = base::makePath(mforms::App::get()->baseDir(), "modules/data/sqlide");
+  std::string fileName = "help-" + std::to_string(version / 100) + "." + std::to_string(version % 10) + ".json";
+  std::string path = base::makePath(dataDir, fileName);
+  if (!base::file_exists(path)) {
+    logError("Help file not found (%s)\n", path.c_str());
+    return nullptr;
+  }
+
+  GError *error = nullptr;
+  GMappedFile *file = g_mapped_file_new(path.c_str(), FALSE, &error);
+  if (file == nullptr) {
+    logError("Could not read help text file (%s)\nError message: %s\n", fileName.c_str(), error->message);
+    g_error_free(error);
+    return nullptr;
+  }
+
+  HelpFile *helpFile = new HelpFile();
+  helpFile->file = file;
+  const char *data = g_mapped_file_get_contents(file);
+  if (data == nullptr || !indexHelpTopics(data, g_mapped_file_get_length(file), helpFile->topics)) {
+    logError("Unexpected file format (%s)\n", fileName.c_str());
+    delete helpFile;
+    return nullptr;
+  }
+
+  logDebug2("Indexed %lu help topics in %s\n", (unsigned long)helpFile->topics.size(), fileName.c_str());
+  helpFiles[version] = helpFile;
+  return helpFile;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
  * A quick lookup if the help topic exists actually, without retrieving help text.
  */
 bool DbSqlEditorContextHelp::topicExists(long serverVersion, const std::string &topic) {
-  waitForLoading();
-
-  auto iterator = helpTopics.find(serverVersion / 100);
-  if (iterator == helpTopics.end())
+  HelpFile *helpFile = helpFileForVersion(serverVersion / 100);
+  if (helpFile == nullptr)
     return false;
-  return iterator->second.count(topic) > 0;
+  return helpFile->topics.count(topic) > 0;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -352,15 +456,39 @@ bool DbSqlEditorContextHelp::topicExists(long serverVersion, const std::string &
 bool DbSqlEditorContextHelp::helpTextForTopic(HelpContext *context, const std::string &topic, std::string &text) {
   logDebug2("Looking up help topic: %s\n", topic.c_str());
 
-  if (!loaderThread.joinable() && !topic.empty()) {
-    auto iterator = helpContent.find(context->serverVersion() / 100);
-    if (iterator == helpContent.end())
-      return false;
+  if (topic.empty())
+    return false;
 
-    text = iterator->second[topic];
+  long version = context->serverVersion() / 100;
+  HelpFile *helpFile = helpFileForVersion(version);
+  if (helpFile == nullptr)
+    return false;
+
+  std::lock_guard<std::mutex> lock(helpFilesMutex);
+  auto iterator = helpFile->content.find(topic);
+  if (iterator != helpFile->content.end()) {
+    text = iterator->second;
     return true;
   }
-  return false;
+
+  text.clear();
+  auto position = helpFile->topics.find(topic);
+  if (position != helpFile->topics.end()) {
+    try {
+      JsonParser::JsonValue value;
+      JsonParser::JsonReader::read(
+        std::string(g_mapped_file_get_contents(helpFile->file) + position->second.first, position->second.second),
+        value);
+      text = createHelpTextFromJson(version, value);
+    } catch (JsonParser::ParserException &e) {
+      logError("Could not read help topic %s\nError message: %s\n", topic.c_str(), e.what());
+    } catch (std::bad_cast &e) {
+      logError("Unexpected format of help topic %s\nError message: %s\n", topic.c_str(), e.what());
+    }
+  }
+  helpFile->content[topic] = text;
+
+  return true;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
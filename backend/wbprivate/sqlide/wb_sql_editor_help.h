@@ -23,7 +23,7 @@
 
 #pragma once
 
-#include <thread>
+#include <mutex>
 
 // Helper class to find context sensitive help based on a statement and a position in it.
 
@@ -58,16 +58,19 @@ namespace help {
     std::string helpTopicFromPosition(HelpContext *helpContext, const std::string &query, size_t caretPosition);
 
   protected:
-    std::thread loaderThread;
+    // The help file of a server version, mapped into memory and indexed on first use. Topics are decoded on request.
+    struct HelpFile;
+
+    std::mutex helpFilesMutex;
     std::map<std::string, std::string> pageMap;
-    std::map<long, std::set<std::string>> helpTopics;               // Quick lookup for help topics per server version.
-    std::map<long, std::map<std::string, std::string>> helpContent; // Help text from a topic (also per version).
+    std::map<long, HelpFile *> helpFiles; // Per server version, nullptr if the file could not be read.
 
     DbSqlEditorContextHelp();
     ~DbSqlEditorContextHelp();
 
     std::string createHelpTextFromJson(long version, JsonParser::JsonObject const &json);
     bool topicExists(long serverVersion, const std::string &topic);
+    HelpFile *helpFileForVersion(long version);
   };
 
 } // namespace help
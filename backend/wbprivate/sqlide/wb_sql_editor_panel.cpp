@@ -37,6 +37,7 @@
 #include "mforms/code_editor.h"
 #include "mforms/find_panel.h"
 #include "mforms/filechooser.h"
+#include "mforms/utilities.h"
 
 #include "workbench/wb_command_ui.h"
 
@@ -56,6 +57,19 @@
 
 // 20 MB max file size for auto-restoring
 #define MAX_FILE_SIZE_FOR_AUTO_RESTORE 20000000
+#define LOAD_CHUNK_SIZE 4 * 1024 * 1024
+
+struct SqlEditorPanel::FileLoader {
+  GMappedFile *mapped_file;
+  GIConv converter; // (GIConv)-1 if the file is UTF-8 already.
+  const char *data;
+  size_t length; // Can be less than the file size, if the user chose to ignore conversion errors.
+  size_t position;
+  bool keep_dirty;
+  bool first_chunk;
+  std::string filename;
+  std::function<void()> finished;
+};
 
 DEFAULT_LOG_DOMAIN("SqlEditorPanel");
 
@@ -80,7 +94,12 @@ SqlEditorPanel::SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start
     _tab_action_apply(mforms::SmallButton),
     _tab_action_revert(mforms::SmallButton),
     _tab_action_info("Read Only"),
+    _connection_id(-1),
     _rs_sequence(0),
+    _loader(nullptr),
+    _load_timeout(0),
+    _text_generation(0),
+    _autosaved_generation(-1),
     _busy(false),
     _is_scratch(is_scratch) {
   db_query_QueryEditorRef grtobj(grt::Initialized);
@@ -102,6 +121,9 @@ SqlEditorPanel::SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start
   _editor->set_sql_mode(owner->sql_mode());
   _editor->set_current_schema(owner->active_schema());
   UIForm::scoped_connect(_editor->text_change_signal(), std::bind(&SqlEditorPanel::update_title, this));
+  grtobj->get_data()->complete_text = std::bind(&SqlEditorPanel::finish_loading, this);
+  UIForm::scoped_connect(_editor->get_editor_control()->signal_changed(),
+                         [this](int, int, int, bool) { ++_text_generation; });
 
   add(&_splitter, true, true);
 
@@ -177,6 +199,16 @@ SqlEditorPanel::SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start
 //--------------------------------------------------------------------------------------------------
 
 SqlEditorPanel::~SqlEditorPanel() {
+  if (_loader != nullptr) {
+    mforms::Utilities::cancel_timeout(_load_timeout);
+    if (_loader->converter != (GIConv)-1)
+      g_iconv_close(_loader->converter);
+    g_mapped_file_unref(_loader->mapped_file);
+    delete _loader;
+  }
+  // The GRT object can outlive us.
+  if (grtobj()->get_data() != nullptr)
+    grtobj()->get_data()->complete_text = nullptr;
   _editor->stop_processing();
   _editor->cancel_auto_completion();
 }
@@ -460,19 +492,30 @@ bool SqlEditorPanel::load_autosave(const AutoSaveInfo &info, const std::string &
   item->set_checked(info.word_wrap);
   (*item->signal_activated())(item);
 
-  _editor->get_editor_control()->set_caret_pos(info.caret_pos);
-  _editor->get_editor_control()->send_editor(SCI_SETFIRSTVISIBLELINE, info.first_visible_line, 0);
+  mforms::CodeEditor *code_editor = _editor->get_editor_control();
+  std::function<void()> restore_position = [code_editor, info]() {
+    code_editor->set_caret_pos(info.caret_pos);
+    code_editor->send_editor(SCI_SETFIRSTVISIBLELINE, info.first_visible_line, 0);
+  };
+  if (_loader != nullptr)
+    _loader->finished = restore_position; // Position can be beyond the text loaded so far.
+  else
+    restore_position();
 
   return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Loads the given file into the editor. The file is mapped into memory and converted to UTF-8 in pieces,
+ * which are appended to the editor directly, so there's only the editor's copy of the text in memory.
+ * The first piece is loaded right away, the rest of a large file is loaded in the background while the editor
+ * (read-only meanwhile) already shows the start of the text.
+ */
 SqlEditorPanel::LoadResult SqlEditorPanel::load_from(const std::string &file, const std::string &encoding,
                                                      bool keep_dirty) {
   GError *error = NULL;
-  gchar *data;
-  gsize length;
   gsize file_size = base_get_file_size(file.c_str());
 
   if (file_size > EDITOR_TEXT_LIMIT) {
@@ -492,45 +535,68 @@ SqlEditorPanel::LoadResult SqlEditorPanel::load_from(const std::string &file, co
 
   _orig_encoding = encoding;
 
-  if (!g_file_get_contents(file.c_str(), &data, &length, &error)) {
+  GMappedFile *mapped_file = g_mapped_file_new(file.c_str(), FALSE, &error);
+  if (mapped_file == NULL) {
     logError("Could not read file %s: %s\n", file.c_str(), error->message);
     std::string what = error->message;
     g_error_free(error);
     throw std::runtime_error(what);
   }
 
-  char *utf8_data;
-  std::string original_encoding;
+  // Empty files have no content pointer.
+  const char *data = g_mapped_file_get_contents(mapped_file);
+  size_t length = data != NULL ? g_mapped_file_get_length(mapped_file) : 0;
+  if (data == NULL)
+    data = "";
+
+  std::string charset;
+  size_t valid_length;
   FileCharsetDialog::Result result =
-    FileCharsetDialog::ensure_filedata_utf8(data, length, encoding, file, utf8_data, &original_encoding);
-  if (result == FileCharsetDialog::Cancelled) {
-    g_free(data);
-    return Cancelled;
-  } else if (result == FileCharsetDialog::RunInstead) {
-    g_free(data);
-    return RunInstead;
+    FileCharsetDialog::check_filedata_encoding(data, length, encoding, file, charset, valid_length);
+  if (result != FileCharsetDialog::Accepted) {
+    g_mapped_file_unref(mapped_file);
+    return result == FileCharsetDialog::RunInstead ? RunInstead : Cancelled;
   }
 
-  // if original data was in utf8, utf8_data comes back NULL
-  if (!utf8_data)
-    utf8_data = data;
-  else
-    g_free(data);
+  // A previous load which is still running is replaced by this one.
+  if (_loader != nullptr) {
+    mforms::Utilities::cancel_timeout(_load_timeout);
+    if (_loader->converter != (GIConv)-1)
+      g_iconv_close(_loader->converter);
+    g_mapped_file_unref(_loader->mapped_file);
+    delete _loader;
+    _loader = nullptr;
+  }
+
+  _loader = new FileLoader();
+  _loader->mapped_file = mapped_file;
+  _loader->converter = charset.empty() ? (GIConv)-1 : g_iconv_open("UTF-8", charset.c_str());
+  _loader->data = data;
+  _loader->length = valid_length;
+  _loader->position = 0;
+  _loader->keep_dirty = keep_dirty;
+  _loader->first_chunk = true;
+  _loader->filename = file;
 
   _editor->set_refresh_enabled(true);
-  _editor->sql(utf8_data ? utf8_data : "");
+  _editor->sql("");
 
-  g_free(utf8_data);
+  // Reserve the full size (converted text can be larger, but usually isn't) and don't keep an undo copy of it.
+  mforms::CodeEditor *code_editor = _editor->get_editor_control();
+  code_editor->send_editor(SCI_ALLOCATE, valid_length, 0);
+  code_editor->send_editor(SCI_SETUNDOCOLLECTION, 0, 0);
+  code_editor->set_features(mforms::FeatureReadOnly, true);
 
   if (!keep_dirty) {
-    _editor->get_editor_control()->reset_dirty();
-
     _filename = file;
-    _orig_encoding = original_encoding;
+    _orig_encoding = charset;
 
     set_title(strip_extension(basename(file)));
   }
 
+  if (load_next_chunk())
+    _load_timeout = mforms::Utilities::add_timeout(0.01f, std::bind(&SqlEditorPanel::load_next_chunk, this));
+
   if (!file_mtime(file, _file_timestamp)) {
     logWarning("Can't get timestamp for %s\n", file.c_str());
     _file_timestamp = 0;
@@ -540,6 +606,110 @@ SqlEditorPanel::LoadResult SqlEditorPanel::load_from(const std::string &file, co
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Appends the next piece of the file being loaded to the editor. Returns true if there is more to load.
+ */
+bool SqlEditorPanel::load_next_chunk() {
+  if (_loader == nullptr)
+    return false;
+
+  mforms::CodeEditor *code_editor = _editor->get_editor_control();
+  const char *input = _loader->data + _loader->position;
+  size_t input_length = std::min((size_t)LOAD_CHUNK_SIZE, _loader->length - _loader->position);
+
+  if (_loader->converter == (GIConv)-1) {
+    // Don't cut a UTF-8 sequence in two.
+    if (_loader->position + input_length < _loader->length) {
+      while (input_length > 0 && (input[input_length] & 0xC0) == 0x80)
+        --input_length;
+    }
+    code_editor->append_text(input, input_length);
+    _loader->position += input_length;
+  } else {
+    std::vector<gchar> buffer(LOAD_CHUNK_SIZE);
+    gchar *in = const_cast<gchar *>(input);
+    gsize in_left = input_length;
+    while (in_left > 0) {
+      gchar *out = buffer.data();
+      gsize out_left = buffer.size();
+      // An incomplete sequence at the end of the piece (EINVAL) is converted with the next one.
+      bool failed = g_iconv(_loader->converter, &in, &in_left, &out, &out_left) == (gsize)-1 && errno != E2BIG;
+
+      const gchar *output = buffer.data();
+      size_t output_length = buffer.size() - out_left;
+      if (_loader->first_chunk && output_length >= 3 && strncmp(output, "\xef\xbb\xbf", 3) == 0) {
+        output += 3; // Skip the byte-order-mark.
+        output_length -= 3;
+      }
+      _loader->first_chunk = false;
+      code_editor->append_text(output, output_length);
+
+      if (failed)
+        break;
+    }
+    _loader->position += input_length - in_left;
+
+    // Nothing converted means the rest is an incomplete sequence, which was accepted as conversion error before.
+    if (input_length == in_left)
+      _loader->position = _loader->length;
+  }
+
+  if (_loader->position < _loader->length) {
+    bec::GRTManager::get()->replace_status_text(
+      strfmt(_("Loading %s... %i%%"), base::basename(_loader->filename).c_str(),
+             (int)(100.0 * _loader->position / _loader->length)));
+    return true;
+  }
+
+  _load_timeout = 0;
+  finish_loading();
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Loads whatever is left of the file being loaded and makes the editor editable again.
+ */
+void SqlEditorPanel::finish_loading() {
+  if (_loader == nullptr)
+    return;
+
+  if (_load_timeout != 0) {
+    mforms::Utilities::cancel_timeout(_load_timeout);
+    _load_timeout = 0;
+  }
+
+  // Once all is loaded, load_next_chunk() calls us again for the final steps.
+  if (_loader->position < _loader->length) {
+    while (load_next_chunk())
+      ;
+    return;
+  }
+
+  FileLoader *loader = _loader;
+  _loader = nullptr;
+  if (loader->converter != (GIConv)-1)
+    g_iconv_close(loader->converter);
+  g_mapped_file_unref(loader->mapped_file);
+
+  mforms::CodeEditor *code_editor = _editor->get_editor_control();
+  code_editor->set_eol_mode(mforms::EolLF, true);
+  code_editor->send_editor(SCI_SETUNDOCOLLECTION, 1, 0);
+  code_editor->reset_undo_stack();
+  code_editor->set_features(mforms::FeatureReadOnly, false);
+  if (!loader->keep_dirty)
+    code_editor->reset_dirty();
+
+  bec::GRTManager::get()->replace_status_text(strfmt(_("Loaded %s"), base::basename(loader->filename).c_str()));
+
+  if (loader->finished)
+    loader->finished();
+  delete loader;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void SqlEditorPanel::close() {
   _form->remove_sql_editor(this);
 }
@@ -578,6 +748,8 @@ bool SqlEditorPanel::save() {
   if (_filename.empty())
     return save_as("");
 
+  finish_loading(); // Don't write a partially loaded file.
+
   GError *error = NULL;
 
   // File extension check is already done in FileChooser.
@@ -633,11 +805,24 @@ std::string SqlEditorPanel::autosave_file_suffix() {
 
 //--------------------------------------------------------------------------------------------------
 
-void SqlEditorPanel::auto_save(const std::string &path) {
+/**
+ * Writes the state of this editor to the given auto save directory, but only what changed since the last call.
+ * The editor text itself is not written here, but added to contents, so the caller can write it in the background.
+ */
+void SqlEditorPanel::auto_save(const std::string &path, AutoSaveContents &contents) {
+  // The file is still being loaded, keep the previous auto save state.
+  if (_loader != nullptr)
+    return;
+
+  // Everything must be written once to a new location.
+  bool new_location = path != _autosaved_path;
+  if (new_location) {
+    _autosaved_path = path;
+    _autosaved_info.clear();
+  }
+
   // save info about the file
   {
-    std::wofstream f;
-    openStream(base::makePath(path, _autosave_file_suffix + ".info"), f);
     std::string content;
     if (_is_scratch)
       content += "type=scratch\n";
@@ -666,44 +851,53 @@ void SqlEditorPanel::auto_save(const std::string &path) {
     size_t first_line = _editor->get_editor_control()->send_editor(SCI_GETFIRSTVISIBLELINE, 0, 0);
     content += "first_visible_line=" + std::to_string(first_line) + "\n";
 
-    if (f.good())
-      f << base::string_to_wstring(content);
-    f.close();
+    if (content != _autosaved_info) {
+      std::wofstream f;
+      openStream(base::makePath(path, _autosave_file_suffix + ".info"), f);
+      if (f.good())
+        f << base::string_to_wstring(content);
+      f.close();
+      _autosaved_info = content;
+    }
   }
 
   std::string fn = base::makePath(path, _autosave_file_suffix + ".scratch");
 
   // only save editor contents for scratch areas and unsaved editors
   if (_is_scratch || _filename.empty() || (!_filename.empty() && is_dirty())) {
-    // We don't need to lock the editor as we are in the main thread here
-    // and directly set the file content without detouring to anything that could change the text.
-    GError *error = 0;
-
-    std::pair<const char *, size_t> text = text_data();
-    if (!g_file_set_contents(fn.c_str(), text.first, text.second, &error)) {
-      logError("Could not save snapshot of editor contents to %s: %s\n", fn.c_str(), error->message);
-      std::string msg(strfmt("Could not save snapshot of editor contents to %s: %s", fn.c_str(), error->message));
-      g_error_free(error);
-      throw std::runtime_error(msg);
+    // A partially loaded text would replace the last complete auto save, wait until loading is done.
+    if (!is_loading() && (new_location || _autosaved_generation != _text_generation)) {
+      // The text is written outside of the main thread, so take a copy of it.
+      std::pair<const char *, size_t> text = text_data();
+      contents.push_back(std::make_pair(fn, std::string(text.first, text.second)));
+      _autosaved_generation = _text_generation;
     }
-  } else {
+  } else if (new_location || _autosaved_generation != -1) {
     // delete the autosave file if the file was saved
     try {
       base::remove(fn);
     } catch (std::exception &e) {
       logWarning("Error deleting autosave file %s: %s\n", fn.c_str(), e.what());
     }
+    _autosaved_generation = -1;
   }
 }
 
 //--------------------------------------------------------------------------------------------------
 
 void SqlEditorPanel::delete_auto_save(const std::string &path) {
+  // A write still pending in the background would bring the text file back after it was deleted.
+  std::string error = _form->finish_auto_save();
+  if (!error.empty())
+    logWarning("Auto save failed: %s\n", error.c_str());
+
   // delete the autosave related files
-  try {
-    base::remove(base::makePath(path, _autosave_file_suffix + ".autosave"));
-  } catch (std::exception &exc) {
-    logWarning("Could not delete auto-save file: %s\n", exc.what());
+  for (const char *suffix : {".scratch", ".autosave"}) {
+    try {
+      base::remove(base::makePath(path, _autosave_file_suffix + suffix));
+    } catch (std::exception &exc) {
+      logWarning("Could not delete auto-save file: %s\n", exc.what());
+    }
   }
   try {
     base::remove(base::makePath(path, _autosave_file_suffix + ".info"));
@@ -892,6 +1086,9 @@ mforms::ToolBar *SqlEditorPanel::get_toolbar() {
 //--------------------------------------------------------------------------------------------------
 
 bool SqlEditorPanel::is_dirty() const {
+  // A file being loaded is only dirty if its content didn't come from the file itself (auto save restore).
+  if (_loader != nullptr)
+    return _loader->keep_dirty;
   return _editor->get_editor_control()->is_dirty();
 }
 
@@ -930,7 +1127,17 @@ std::pair<const char *, std::size_t> SqlEditorPanel::text_data() const {
 void SqlEditorPanel::set_title(const std::string &title) {
   _title = title;
   grtobj()->name(_title);
-  mforms::AppView::set_title(title);
+  mforms::AppView::set_title(displayed_title());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Shows which pooled connection this editor uses to run its queries. Pass -1 to remove that info.
+ */
+void SqlEditorPanel::set_connection_id(std::int64_t id) {
+  _connection_id = id;
+  mforms::AppView::set_title(displayed_title());
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -945,7 +1152,18 @@ void SqlEditorPanel::set_filename(const std::string &filename) {
 
 void SqlEditorPanel::update_title() {
   if (!_is_scratch)
-    mforms::AppView::set_title(_title + (is_dirty() ? "*" : ""));
+    mforms::AppView::set_title(displayed_title());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string SqlEditorPanel::displayed_title() {
+  std::string title = _title;
+  if (!_is_scratch && is_dirty())
+    title += "*";
+  if (_connection_id >= 0)
+    title += strfmt(" [#%lli]", (long long)_connection_id);
+  return title;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -81,16 +81,30 @@ class MYSQLWBBACKEND_PUBLIC_FUNC SqlEditorPanel : public mforms::AppView {
 
   std::string _autosave_file_suffix;
 
+  // What was last auto saved where, so that unchanged state isn't written again.
+  std::string _autosaved_path;
+  std::string _autosaved_info;
+  int _text_generation;
+  int _autosaved_generation; // -1 if there's no auto saved text.
+
   time_t _file_timestamp;
 
+  std::int64_t _connection_id; // Id of the pooled connection this editor runs its queries on (-1 if none).
+
   int _rs_sequence;
 
+  // State of a file being loaded piecewise into the editor, see load_from().
+  struct FileLoader;
+  FileLoader *_loader;
+  int _load_timeout;
+
   bool _busy;
   bool _was_empty;
   bool _is_scratch;
 
   mforms::ToolBar *setup_editor_toolbar();
   void update_title();
+  std::string displayed_title();
 
   void dock_result_panel(SqlEditorResult *result);
   void show_find_panel(mforms::CodeEditor *editor, bool show);
@@ -123,6 +137,8 @@ class MYSQLWBBACKEND_PUBLIC_FUNC SqlEditorPanel : public mforms::AppView {
 
   void limit_rows(mforms::ToolBarItem *);
 
+  bool load_next_chunk();
+
 public:
   typedef std::shared_ptr<SqlEditorPanel> Ref;
   SqlEditorPanel(SqlEditorForm *owner, bool is_scratch, bool start_collapsed);
@@ -137,6 +153,7 @@ public:
   virtual void set_title(const std::string &title);
 
   void update_limit_rows();
+  void set_connection_id(std::int64_t id);
 
   SqlEditorForm *owner() {
     return _form;
@@ -177,7 +194,11 @@ public:
   bool save_as(const std::string &file);
   void revert_to_saved();
 
-  void auto_save(const std::string &directory);
+  typedef std::vector<std::pair<std::string, std::string> > AutoSaveContents;
+  void auto_save(const std::string &directory, AutoSaveContents &contents);
+  void reset_auto_save_state() {
+    _autosaved_path.clear();
+  }
   void delete_auto_save(const std::string &directory);
   std::string autosave_file_suffix();
 
@@ -187,6 +208,10 @@ public:
   }
 
   bool is_dirty() const;
+  bool is_loading() const {
+    return _loader != nullptr;
+  }
+  void finish_loading();
   void check_external_file_changes();
 
   std::pair<const char *, std::size_t> text_data() const;
@@ -103,6 +103,7 @@ bool DbSqlEditorSnippets::activate_toolbar_item(const bec::NodeId &selected, con
       SqlEditorForm *editor_form = _sqlide->get_active_sql_editor();
       SqlEditorPanel *panel;
       if (editor_form != NULL && (panel = editor_form->active_sql_editor_panel()) != NULL) {
+        panel->finish_loading(); // The rest of a file being loaded would end up after the snippet.
         if (name == "replace_text") {
           panel->editor_be()->set_refresh_enabled(true);
           panel->editor_be()->sql(script.c_str());
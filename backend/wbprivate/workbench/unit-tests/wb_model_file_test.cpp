@@ -191,6 +191,64 @@ TEST_FUNCTION(13) {
   ensure("4.2 Comment is mydb, ", comment == "mydb");
 }
 
+// Current documents are loaded without building the XML tree, unless they must be repaired at XML level.
+TEST_FUNCTION(14) {
+  std::string tmpDir = TMP_DIR;
+  ModelFile mf(tmpDir);
+  mf.create();
+
+  workbench_DocumentRef doc(grt::Initialized);
+  workbench_physical_ModelRef pmodel(grt::Initialized);
+  pmodel->owner(doc);
+  db_mysql_CatalogRef catalog(grt::Initialized);
+  catalog->owner(pmodel);
+  pmodel->catalog(catalog);
+  doc->physicalModels().insert(pmodel);
+
+  db_mysql_SchemaRef schema(grt::Initialized);
+  schema->owner(catalog);
+  schema->name("schema1");
+  catalog->schemata().insert(schema);
+
+  db_mysql_TableRef table(grt::Initialized);
+  table->owner(schema);
+  table->name("table1");
+  schema->tables().insert(table);
+
+  db_mysql_ColumnRef column(grt::Initialized);
+  column->owner(table);
+  column->name("column1");
+  table->columns().insert(column);
+
+  db_mysql_ForeignKeyRef fk(grt::Initialized);
+  fk->owner(table);
+  fk->name("fk1");
+  fk->columns().insert(column);
+  fk->referencedColumns().insert(column);
+  table->foreignKeys().insert(fk);
+
+  // Without the binary copy the XML document is read.
+  mf.store_document(doc);
+  base::remove(mf.get_path_for(MAIN_DOCUMENT_BINARY_NAME));
+
+  workbench_DocumentRef loaded(mf.retrieve_document());
+  ensure("14.1 Document loaded", loaded.is_valid());
+  ensure("14.2 No load warnings", mf.get_load_warnings().empty());
+  db_TableRef loaded_table(loaded->physicalModels()[0]->catalog()->schemata()[0]->tables()[0]);
+  ensure_equals("14.3 Foreign key column", loaded_table->foreignKeys()[0]->columns().count(), 1U);
+
+  // A foreign key with a missing referenced column is repaired as before.
+  fk->referencedColumns().remove_all();
+  mf.store_document(doc);
+  base::remove(mf.get_path_for(MAIN_DOCUMENT_BINARY_NAME));
+
+  loaded = mf.retrieve_document();
+  ensure("14.4 Document loaded", loaded.is_valid());
+  ensure("14.5 Repair reported", !mf.get_load_warnings().empty());
+  loaded_table = loaded->physicalModels()[0]->catalog()->schemata()[0]->tables()[0];
+  ensure_equals("14.6 Invalid foreign key columns removed", loaded_table->foreignKeys()[0]->columns().count(), 0U);
+}
+
 // Test if opened model can be saved (we ran into an issue with libzip that
 // didn't close the file properly, resulting in inability to save the model)
 TEST_FUNCTION(20) {
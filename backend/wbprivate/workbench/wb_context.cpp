@@ -1422,6 +1422,7 @@ void WBContext::set_default_options(grt::DictRef options) {
   set_default(options, "DbSqlEditor:KeepAliveInterval", 600);            // in seconds
   set_default(options, "DbSqlEditor:ReadTimeOut", 30);                  // in seconds
   set_default(options, "DbSqlEditor:ConnectionTimeOut", 60);             // in seconds
+  set_default(options, "DbSqlEditor:ConnectionPoolSize", 0); // extra connections for concurrent query tabs, 0 = off
   set_default(options, "DbSqlEditor:MaxQuerySizeToHistory", 65536);
   set_default(options, "DbSqlEditor:ContinueOnError", 0); // continue running sql script bypassing failed statements
   set_default(options, "DbSqlEditor:AutocommitMode", 1);  // when enabled, each statement will be committed immediately
@@ -1439,6 +1440,7 @@ void WBContext::set_default_options(grt::DictRef options) {
 
   set_default(options, "DbSqlEditor:Reformatter:UpcaseKeywords", 1);
   set_default(options, "DbSqlEditor::MaxResultsets", 50);
+  set_default(options, "DbSqlEditor:PersistentParseCache", 0); // keep syntax check results across sessions
 
   // Migration
   set_default(options, "Migration:ConnectionTimeOut", 60); // in seconds
@@ -1448,6 +1450,8 @@ void WBContext::set_default_options(grt::DictRef options) {
   set_default(options, "Recordset:FieldValueTruncationThreshold", 256);
   set_default(options, "SqlEditor:LimitRows", 1);
   set_default(options, "SqlEditor:LimitRowsCount", 1000);
+  set_default(options, "DbSqlEditor:StreamResultsets", 0);
+  set_default(options, "DbSqlEditor:StreamResultsetMemoryBudget", 64); // in MB, per result set
   set_default(options, "SqlEditor:PreserveRowFilter", 1);
   set_default(options, "SqlEditor:geographicLocationURL", "http://www.openstreetmap.org/?mlat=%LAT%&mlon=%LON%");
 
@@ -397,6 +397,15 @@ std::string ModelFile::get_path_for(const std::string &file) {
 workbench_DocumentRef ModelFile::retrieve_document() {
   RecMutexLock lock(_mutex);
 
+  workbench_DocumentRef binary_doc(unserialize_binary_document());
+  if (binary_doc.is_valid())
+    return binary_doc;
+
+  workbench_DocumentRef streamed_doc(unserialize_streamed_document());
+  if (streamed_doc.is_valid())
+    return streamed_doc;
+
+  // Older documents are upgraded (and repaired) at XML level, which needs the whole document tree.
   xmlDocPtr xmldoc = grt::GRT::get()->load_xml(get_path_for(MAIN_DOCUMENT_NAME));
 
 retry:
@@ -719,6 +728,121 @@ workbench_DocumentRef ModelFile::unserialize_document(xmlDocPtr xmldoc, const st
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Loads the document from its binary copy, which is only used if it was written together with the current
+ * XML document, in the current document version. Returns an invalid ref if the XML document must be loaded instead.
+ */
+workbench_DocumentRef ModelFile::unserialize_binary_document() {
+  std::string path = get_path_for(MAIN_DOCUMENT_BINARY_NAME);
+  std::string doctype, version, checksum;
+
+  if (!g_file_test(path.c_str(), G_FILE_TEST_EXISTS) ||
+      !grt::GRT::get()->get_binary_metainfo(path, doctype, version, checksum))
+    return workbench_DocumentRef();
+
+  if (doctype != DOCUMENT_FORMAT || version != DOCUMENT_VERSION || checksum.empty() || checksum != document_checksum()) {
+    logDebug("Binary document copy is outdated, loading %s\n", MAIN_DOCUMENT_NAME);
+    return workbench_DocumentRef();
+  }
+
+  try {
+    grt::ValueRef value(grt::GRT::get()->unserialize_binary(path, doctype, version));
+
+    if (!workbench_DocumentRef::can_wrap(value))
+      throw std::runtime_error("Binary document copy does not contain a valid Workbench document.");
+
+    _loaded_version = version;
+    _load_warnings.clear();
+
+    workbench_DocumentRef doc(workbench_DocumentRef::cast_from(value));
+    check_and_fix_inconsistencies(doc, version);
+
+    if (!semantic_check(doc))
+      throw std::logic_error("Invalid model file content.");
+
+    return doc;
+  } catch (std::exception &exc) {
+    logWarning("Could not load binary document copy, loading %s instead: %s\n", MAIN_DOCUMENT_NAME, exc.what());
+  }
+
+  return workbench_DocumentRef();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Loads a document in the current version with the streaming unserializer, which doesn't build the XML tree.
+ * Returns an invalid ref if the document must be upgraded or repaired at XML level, which unserialize_document()
+ * then does on the XML tree. This is also the case if it fails to load, so errors are reported from there.
+ */
+workbench_DocumentRef ModelFile::unserialize_streamed_document() {
+  std::string path = get_path_for(MAIN_DOCUMENT_NAME);
+  std::string doctype, version;
+
+  if (!grt::GRT::get()->get_xml_metainfo(path, doctype, version) || doctype != DOCUMENT_FORMAT ||
+      version != DOCUMENT_VERSION)
+    return workbench_DocumentRef();
+
+  try {
+    grt::ValueRef value(grt::GRT::get()->unserialize(path, doctype, version));
+
+    if (!workbench_DocumentRef::can_wrap(value))
+      throw std::runtime_error("Loaded file does not contain a valid Workbench document.");
+
+    workbench_DocumentRef doc(workbench_DocumentRef::cast_from(value));
+    if (has_xml_inconsistencies(doc, version)) {
+      logDebug("%s must be repaired before loading it\n", MAIN_DOCUMENT_NAME);
+      return workbench_DocumentRef();
+    }
+
+    _loaded_version = version;
+    _load_warnings.clear();
+
+    // Nothing to upgrade in the current version, except for creating a missing data file.
+    doc = attempt_document_upgrade(doc, NULL, version);
+    cleanup_upgrade_data();
+
+    check_and_fix_inconsistencies(doc, version);
+
+    if (!semantic_check(doc))
+      throw std::logic_error("Invalid model file content.");
+
+    return doc;
+  } catch (std::exception &exc) {
+    logWarning("Could not stream %s, loading it as XML tree instead: %s\n", MAIN_DOCUMENT_NAME, exc.what());
+  }
+
+  return workbench_DocumentRef();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the SHA1 checksum of the stored XML document, which ties the binary copy to it.
+ */
+std::string ModelFile::document_checksum() {
+  std::string checksum;
+
+  // Read in chunks, the document isn't needed in memory for this.
+  FILE *f = base_fopen(get_path_for(MAIN_DOCUMENT_NAME).c_str(), "rb");
+  if (f) {
+    GChecksum *sha1 = g_checksum_new(G_CHECKSUM_SHA1);
+    char buffer[64 * 1024];
+    size_t length;
+
+    while ((length = fread(buffer, 1, sizeof(buffer), f)) > 0)
+      g_checksum_update(sha1, (const guchar *)buffer, length);
+
+    if (!ferror(f))
+      checksum = g_checksum_get_string(sha1);
+    g_checksum_free(sha1);
+    fclose(f);
+  }
+  return checksum;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 /**
  * Core save routine for model files. It does a backup of the existing model file of the given name
  * (if there is one). Checks are performed to ensure existing backup files can be removed and existing
@@ -929,6 +1053,15 @@ std::string ModelFile::get_file_contents(const std::string &path) {
 void ModelFile::store_document(const workbench_DocumentRef &doc) {
   grt::GRT::get()->serialize(doc, get_path_for(MAIN_DOCUMENT_NAME), DOCUMENT_FORMAT, DOCUMENT_VERSION);
 
+  // The binary copy is only for faster loading, the XML document stays the reference.
+  std::string binary_path = get_path_for(MAIN_DOCUMENT_BINARY_NAME);
+  try {
+    grt::GRT::get()->serialize_binary(doc, binary_path, DOCUMENT_FORMAT, DOCUMENT_VERSION, document_checksum());
+  } catch (std::exception &exc) {
+    logWarning("Could not store binary document copy: %s\n", exc.what());
+    base_remove(binary_path);
+  }
+
   _dirty = true;
 }
 
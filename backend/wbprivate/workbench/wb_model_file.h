@@ -37,6 +37,7 @@
 
 #define MAIN_DOCUMENT_NAME "document.mwb.xml"
 #define MAIN_DOCUMENT_AUTOSAVE_NAME "document-autosave.mwb.xml"
+#define MAIN_DOCUMENT_BINARY_NAME "document.mwb.grtb"
 
 namespace bec {
   class GRTManager;
@@ -129,6 +130,8 @@ namespace wb {
     boost::signals2::signal<void()> _changed_signal;
 
     workbench_DocumentRef unserialize_document(xmlDocPtr xmldoc, const std::string &path);
+    workbench_DocumentRef unserialize_binary_document();
+    workbench_DocumentRef unserialize_streamed_document();
 
   private:
     bool attempt_xml_document_upgrade(xmlDocPtr xmldoc, const std::string &version);
@@ -140,6 +143,7 @@ namespace wb {
     bool check_and_fix_duplicate_uuid_bug(xmlDocPtr xmldoc);
 
     void check_and_fix_inconsistencies(xmlDocPtr xmldoc, const std::string &version);
+    bool has_xml_inconsistencies(const workbench_DocumentRef &doc, const std::string &version);
 
     void check_and_fix_inconsistencies(const workbench_DocumentRef &doc, const std::string &version);
 
@@ -153,5 +157,6 @@ namespace wb {
   private:
     std::string create_document_dir(const std::string &dir, const std::string &prefix);
     bool semantic_check(workbench_DocumentRef doc);
+    std::string document_checksum();
   };
 };
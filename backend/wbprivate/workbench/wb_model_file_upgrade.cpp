@@ -971,6 +971,33 @@ void ModelFile::check_and_fix_inconsistencies(xmlDocPtr xmldoc, const std::strin
   }
 }
 
+/**
+ * Tells if check_and_fix_inconsistencies() would have changed the XML tree the document was loaded from.
+ * Null column references already make the unserializer fail, so only the column counts are left to check.
+ */
+bool ModelFile::has_xml_inconsistencies(const workbench_DocumentRef &doc, const std::string &version) {
+  std::vector<std::string> ver = base::split(version, ".");
+
+  if (base::atoi<int>(ver[0], 0) != 1)
+    return false;
+
+  grt::ListRef<workbench_physical_Model> models(doc->physicalModels());
+  for (size_t c = models.count(), i = 0; i < c; i++) {
+    db_CatalogRef catalog(models[i]->catalog());
+    for (size_t sc = catalog->schemata().count(), s = 0; s < sc; s++) {
+      grt::ListRef<db_Table> tables(catalog->schemata()[s]->tables());
+      for (size_t tc = tables.count(), t = 0; t < tc; t++) {
+        grt::ListRef<db_ForeignKey> fks(tables[t]->foreignKeys());
+        for (size_t fc = fks.count(), f = 0; f < fc; f++) {
+          if (fks[f]->columns().count() != fks[f]->referencedColumns().count())
+            return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
 void ModelFile::check_and_fix_inconsistencies(const workbench_DocumentRef &doc, const std::string &version) {
   grt::ListRef<workbench_physical_Model> models(doc->physicalModels());
 
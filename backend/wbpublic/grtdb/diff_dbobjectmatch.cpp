@@ -35,6 +35,7 @@
 #include <boost/assign/list_of.hpp>
 #include <algorithm>
 #include <functional>
+#include <thread>
 
 #include "mysql_parser_services.h"
 
@@ -68,6 +69,14 @@ std::string get_qualified_schema_object_old_name(GrtNamedObjectRef object, const
 // Alter OMF
 /////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Catalogs are diffed in parallel per schema and per schema object (as diffed from a catalog).
+ */
+grt::DbObjectMatchAlterOmf::DbObjectMatchAlterOmf() {
+  diff_threads = std::thread::hardware_concurrency();
+  parallel_list_depths = {1, 2};
+}
+
 bool grt::DbObjectMatchAlterOmf::less(const grt::ValueRef& l, const grt::ValueRef& r) const {
   if (l.type() == r.type() && l.type() == ObjectType) {
     if (db_IndexColumnRef::can_wrap(l) && db_IndexColumnRef::can_wrap(r)) {
@@ -203,6 +212,38 @@ bool grt::DbObjectMatchAlterOmf::equal(const ValueRef& l, const ValueRef& r) con
   return std::equal_to<grt::ValueRef>()(l, r);
 }
 
+/**
+ * Hashes the name equal() compares for the given object (or the value itself for anything else).
+ */
+size_t grt::DbObjectMatchAlterOmf::hash(const ValueRef& value) const {
+  std::hash<std::string> stringHash;
+  if (value.type() == ObjectType) {
+    if (db_IndexColumnRef::can_wrap(value))
+      return hash(db_IndexColumnRef::cast_from(value)->referencedColumn());
+    else if (db_mysql_SchemaRef::can_wrap(value))
+      return stringHash(db_mysql_SchemaRef::cast_from(value)->name());
+    else if (GrtNamedObjectRef::can_wrap(value)) {
+      GrtNamedObjectRef object = GrtNamedObjectRef::cast_from(value);
+      if (!object->owner().is_valid())
+        return 0;
+
+      if (strlen(object->oldName().c_str()) > 0)
+        return stringHash(get_qualified_schema_object_old_name(object, case_sensitive));
+      return stringHash(get_qualified_schema_object_name(object, case_sensitive));
+    } else if (GrtObjectRef::can_wrap(value))
+      return stringHash(GrtObjectRef::cast_from(value)->name());
+    else if (ObjectRef::can_wrap(value)) {
+      ObjectRef object = ObjectRef::cast_from(value);
+      if (object.has_member("oldName")) {
+        if (strlen(object.get_string_member("oldName").c_str()) > 0)
+          return stringHash(object.get_string_member("oldName"));
+        return stringHash(object.get_string_member("name"));
+      }
+    }
+  }
+  return value_hash(value);
+}
+
 //--------------------------------------------------------------------------------------------------
 
 bool sqlCompare(const ValueRef obj1, const ValueRef obj2, const std::string& name) {
@@ -799,9 +840,13 @@ void grt::NormalizedComparer::load_rules() {
     std::bind(&column_flags_compare, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 };
 
-bool grt::NormalizedComparer::normalizedComparison(const ValueRef obj1, const ValueRef obj2, const std::string name) {
-  std::list<comparison_rule>& rul_list = rules[name];
-  for (std::list<comparison_rule>::iterator It = rul_list.begin(); It != rul_list.end(); ++It)
+bool grt::NormalizedComparer::normalizedComparison(const ValueRef obj1, const ValueRef obj2,
+                                                   const std::string name) const {
+  // No lookup with operator[], which would insert missing names while other diff threads read the map.
+  std::map<std::string, std::list<comparison_rule> >::const_iterator rul_list = rules.find(name);
+  if (rul_list == rules.end())
+    return false;
+  for (std::list<comparison_rule>::const_iterator It = rul_list->second.begin(); It != rul_list->second.end(); ++It)
     if ((*It)(obj1, obj2, name))
       return true;
   return false;
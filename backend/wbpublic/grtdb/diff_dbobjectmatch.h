@@ -39,8 +39,10 @@ namespace sql {
 namespace grt {
 
   struct WBPUBLICBACKEND_PUBLIC_FUNC DbObjectMatchAlterOmf : public Omf {
+    DbObjectMatchAlterOmf();
     virtual bool less(const ValueRef&, const ValueRef&) const;
     virtual bool equal(const ValueRef&, const ValueRef&) const;
+    virtual size_t hash(const ValueRef&) const;
   };
 
   typedef std::function<bool(const ValueRef obj1, const ValueRef obj2, const std::string name)> comparison_rule;
@@ -63,7 +65,8 @@ namespace grt {
     void add_comparison_rule(const std::string& name, comparison_rule rule) {
       rules[name].push_back(rule);
     };
-    bool normalizedComparison(const ValueRef obj1, const ValueRef obj2, const std::string name);
+    // Only reads the rules, so that it can be used by concurrent diff threads.
+    bool normalizedComparison(const ValueRef obj1, const ValueRef obj2, const std::string name) const;
     grt::DictRef get_options_dict() const;
     bool is_case_sensitive() const {
       return _case_sensitive;
@@ -77,10 +77,17 @@ namespace parsers {
     virtual MySQLParserContext::Ref createParserContext(GrtCharacterSetsRef charsets, GrtVersionRef version,
                                                         const std::string &sqlMode, bool caseSensitive) = 0;
 
+    // Creates a context with the same settings as the given one, e.g. for use in another thread.
+    virtual MySQLParserContext::Ref cloneParserContext(MySQLParserContext::Ref context) = 0;
+
     // Info services.
     virtual size_t tokenFromString(MySQLParserContext::Ref context, const std::string &token) = 0;
     virtual MySQLQueryType determineQueryType(MySQLParserContext::Ref context, const std::string &text) = 0;
 
+    // Lexer-only helper for statement classification: returns the type of the first token which is not whitespace or
+    // a comment (0 if there is none). Compare with the result of tokenFromString().
+    virtual size_t determineFirstTokenType(MySQLParserContext::Ref context, const std::string &text) = 0;
+
     // DB objects.
     virtual size_t parseTable(MySQLParserContext::Ref context, db_mysql_TableRef table, const std::string &sql) = 0;
     virtual size_t parseRoutine(MySQLParserContext::Ref context, db_mysql_RoutineRef routine,
@@ -105,6 +112,26 @@ namespace parsers {
 
     virtual size_t checkSqlSyntax(MySQLParserContext::Ref context, const char *sql, size_t length,
                                   MySQLParseUnit unitType) = 0;
+
+    // Syntax check results are cached per statement. This sets a file to keep them across sessions, new results
+    // are written to it in batches. An empty path writes what is pending and closes the file.
+    virtual void setParseCacheFile(const std::string &path) = 0;
+
+    // Parses a set of typical statements in the background, to warm up the parser caches. Stop before shutdown.
+    virtual void startParserWarmUp() = 0;
+    virtual void stopParserWarmUp() = 0;
+
+    // Parsing first tries the fast SLL prediction mode and falls back to LL. Statement shapes that always need LL
+    // are learned and parsed with LL directly. That profile can be exported and imported again (as text).
+    struct PredictionStatistics {
+      size_t sllAttempts = 0; // Parses which tried SLL first.
+      size_t llFallbacks = 0; // SLL parses which failed for a valid statement and were repeated with LL.
+      size_t llDirect = 0;    // Parses which skipped SLL because of the profile.
+    };
+    virtual std::string exportPredictionProfile() = 0;
+    virtual void importPredictionProfile(const std::string &profile) = 0;
+    virtual PredictionStatistics predictionStatistics(bool reset) = 0;
+
     virtual size_t renameSchemaReferences(MySQLParserContext::Ref context, db_mysql_CatalogRef catalog,
                                           const std::string old_name, const std::string new_name) = 0;
 
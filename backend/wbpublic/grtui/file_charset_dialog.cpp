@@ -36,6 +36,8 @@
 
 #include "grts/structs.db.h"
 
+#include <cerrno>
+
 using namespace mforms;
 using namespace base;
 
@@ -104,15 +106,80 @@ void FileCharsetDialog::run_clicked() {
   end_modal(false);
 }
 
-FileCharsetDialog::Result FileCharsetDialog::ensure_filedata_utf8(const char *data, size_t length,
-                                                                  const std::string &encoding,
-                                                                  const std::string &filename, char *&utf8_data,
-                                                                  std::string *original_encoding) {
+/**
+ * Asks the user for the encoding of the given (non UTF-8) data. A byte order mark in the data is used to suggest
+ * an encoding. Returns an empty string if the user cancelled, in which case result tells whether the file should be
+ * run instead.
+ */
+std::string FileCharsetDialog::ask_for_charset(const char *data, size_t length, const std::string &filename,
+                                               Result &result) {
   // Byte order marks.
   const char *utf16le_bom = "\xff\xfe";
   const char *utf16be_bom = "\xfe\xff";
   const char *utf32le_bom = "\xff\xfe\0\0";
   const char *utf32be_bom = "\0\0\xfe\xff";
+
+  std::string default_encoding = "latin1";
+
+  // Check if there is a byte-order-mark to provide a better suggestion for the source encoding.
+  if (length >= 2) {
+    if (strncmp(data, utf16le_bom, 2) == 0)
+      default_encoding = "UTF-16LE";
+    else if (strncmp(data, utf16be_bom, 2) == 0)
+      default_encoding = "UTF-16BE";
+
+    if (length >= 4) {
+      if (strncmp(data, utf32le_bom, 4) == 0)
+        default_encoding = "UTF-32LE";
+      else if (strncmp(data, utf32be_bom, 4) == 0)
+        default_encoding = "UTF-32BE";
+    }
+  }
+
+  FileCharsetDialog dlg(
+    _("Unknown File Encoding"),
+    strfmt("The file '%s' is not UTF-8 encoded.\n\n"
+           "Please select the encoding of the file and press OK for Workbench to convert and open it.\n"
+           "Note that as Workbench works with UTF-8 text, if you save back to the original file,\n"
+           "its contents will be replaced with the converted data.\n\n"
+           "WARNING: If your file contains binary data, it may become corrupted.\n\n"
+           "Click \"Run SQL Script...\" to execute the file without opening for editing.",
+           filename.c_str()));
+  std::string charset = dlg.run(default_encoding);
+  if (charset.empty())
+    result = dlg._run_clicked ? RunInstead : Cancelled;
+  else
+    result = Accepted;
+  return charset;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Tells the user that the data could not be converted, completely (partial == false) or in part.
+ * Returns ResultOk to go on (ignore the rest for partial conversions, choose another encoding otherwise),
+ * ResultCancel to stop and ResultOther to choose another encoding for partial conversions.
+ */
+static int show_conversion_error(const std::string &charset, const std::string &message, bool partial) {
+  if (!partial)
+    return Utilities::show_error(_("Could not Convert Text Data"),
+                                 strfmt(_("The file contents could not be converted from '%s' to UTF-8:\n%s\n"),
+                                        charset.c_str(), message.c_str()),
+                                 _("Choose Encoding"), _("Cancel"));
+
+  return Utilities::show_error(_("Could not Convert Text Data"),
+                               strfmt(_("Some of the file contents could not be converted from '%s' to UTF-8:\n%s\n"
+                                        "Click Ignore to open the partial file anyway, or choose another encoding."),
+                                      charset.c_str(), message.c_str()),
+                               _("Ignore"), _("Cancel"), _("Choose Encoding"));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+FileCharsetDialog::Result FileCharsetDialog::ensure_filedata_utf8(const char *data, size_t length,
+                                                                  const std::string &encoding,
+                                                                  const std::string &filename, char *&utf8_data,
+                                                                  std::string *original_encoding) {
   const char *utf8_bom = "\xef\xbb\xbf";
 
   size_t utf8_data_length = 0;
@@ -120,44 +187,16 @@ FileCharsetDialog::Result FileCharsetDialog::ensure_filedata_utf8(const char *da
   bool retrying = false;
 retry:
   if (!g_utf8_validate(data, (gssize)length, &end)) {
-    std::string default_encoding = "latin1";
-
-    // Check if there is a byte-order-mark to provide a better suggestion for the source encoding.
-    if (length >= 2) {
-      if (strncmp(data, utf16le_bom, 2) == 0)
-        default_encoding = "UTF-16LE";
-      else if (strncmp(data, utf16be_bom, 2) == 0)
-        default_encoding = "UTF-16BE";
-
-      if (length >= 4) {
-        if (strncmp(data, utf32le_bom, 4) == 0)
-          default_encoding = "UTF-32LE";
-        else if (strncmp(data, utf32be_bom, 4) == 0)
-          default_encoding = "UTF-32BE";
-      }
-    }
-
     std::string charset;
     char *converted;
     gsize bytes_read, bytes_written;
     GError *error = NULL;
 
     if (encoding.empty() || retrying) {
-      FileCharsetDialog dlg(
-        _("Unknown File Encoding"),
-        strfmt("The file '%s' is not UTF-8 encoded.\n\n"
-               "Please select the encoding of the file and press OK for Workbench to convert and open it.\n"
-               "Note that as Workbench works with UTF-8 text, if you save back to the original file,\n"
-               "its contents will be replaced with the converted data.\n\n"
-               "WARNING: If your file contains binary data, it may become corrupted.\n\n"
-               "Click \"Run SQL Script...\" to execute the file without opening for editing.",
-               filename.c_str()));
-      charset = dlg.run(default_encoding);
-      if (charset.empty()) {
-        if (dlg._run_clicked)
-          return RunInstead;
-        return Cancelled;
-      }
+      Result result;
+      charset = ask_for_charset(data, length, filename, result);
+      if (charset.empty())
+        return result;
     } else {
       charset = encoding;
       retrying = true; // in case we fail..
@@ -165,12 +204,7 @@ retry:
 
     converted = g_convert(data, (gssize)length, "UTF-8", charset.c_str(), &bytes_read, &bytes_written, &error);
     if (!converted) {
-      int res;
-
-      res = Utilities::show_error(_("Could not Convert Text Data"),
-                                  strfmt(_("The file contents could not be converted from '%s' to UTF-8:\n%s\n"),
-                                         charset.c_str(), error ? error->message : "Unknown error"),
-                                  _("Choose Encoding"), _("Cancel"));
+      int res = show_conversion_error(charset, error ? error->message : "Unknown error", false);
       if (error)
         g_error_free(error);
 
@@ -181,13 +215,7 @@ retry:
     } else if (bytes_read < length) {
       // Conversion was not complete. We can retry or return at least the partial result which
       // could be converted.
-      int res;
-
-      res = Utilities::show_error(_("Could not Convert Text Data"),
-                                  strfmt(_("Some of the file contents could not be converted from '%s' to UTF-8:\n%s\n"
-                                           "Click Ignore to open the partial file anyway, or choose another encoding."),
-                                         charset.c_str(), error ? error->message : "Unknown error"),
-                                  _("Ignore"), _("Cancel"), _("Choose Encoding"));
+      int res = show_conversion_error(charset, error ? error->message : "Unknown error", true);
       if (error)
         g_error_free(error);
       if (res == ResultOk) {
@@ -222,3 +250,76 @@ retry:
 
   return Accepted;
 }
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Runs the conversion of the given data from charset to UTF-8, without keeping the result. Returns the number
+ * of bytes which could be converted.
+ */
+static size_t check_conversion(const char *data, size_t length, const std::string &charset, std::string &message) {
+  GIConv converter = g_iconv_open("UTF-8", charset.c_str());
+  if (converter == (GIConv)-1) {
+    message = strfmt(_("Conversion from %s is not supported"), charset.c_str());
+    return 0;
+  }
+
+  gchar buffer[0x10000];
+  gchar *input = const_cast<gchar *>(data);
+  gsize input_left = length;
+  while (input_left > 0) {
+    gchar *output = buffer;
+    gsize output_left = sizeof(buffer);
+    if (g_iconv(converter, &input, &input_left, &output, &output_left) == (gsize)-1 && errno != E2BIG) {
+      message = g_strerror(errno);
+      break;
+    }
+  }
+  g_iconv_close(converter);
+
+  return length - input_left;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Like ensure_filedata_utf8, but without converting the data, for callers which convert large data in pieces.
+ * Returns the encoding to convert from in charset, which is empty if the data is valid UTF-8 already.
+ * valid_length receives the number of bytes which can be converted. It is less than length only if the user
+ * decided to ignore conversion errors.
+ */
+FileCharsetDialog::Result FileCharsetDialog::check_filedata_encoding(const char *data, size_t length,
+                                                                     const std::string &encoding,
+                                                                     const std::string &filename,
+                                                                     std::string &charset, size_t &valid_length) {
+  valid_length = length;
+  charset.clear();
+  if (g_utf8_validate(data, (gssize)length, NULL))
+    return Accepted;
+
+  bool retrying = false;
+  while (true) {
+    if (encoding.empty() || retrying) {
+      Result result;
+      charset = ask_for_charset(data, length, filename, result);
+      if (charset.empty())
+        return result;
+    } else
+      charset = encoding;
+    retrying = true;
+
+    std::string message;
+    valid_length = check_conversion(data, length, charset, message);
+    if (valid_length == length)
+      return Accepted;
+
+    int res = show_conversion_error(charset, message, valid_length > 0);
+    if (valid_length == 0) {
+      if (res != ResultOk)
+        return Cancelled;
+    } else if (res == ResultOk)
+      return Accepted;
+    else if (res == ResultCancel)
+      return Cancelled;
+  }
+}
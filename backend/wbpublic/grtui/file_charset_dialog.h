@@ -47,9 +47,15 @@ class WBPUBLICBACKEND_PUBLIC_FUNC FileCharsetDialog : public mforms::Form {
 public:
   enum Result { Cancelled, Accepted, RunInstead };
 
+private:
+  static std::string ask_for_charset(const char *data, size_t length, const std::string &filename, Result &result);
+
+public:
   std::string run(const std::string &default_encoding);
 
   static Result ensure_filedata_utf8(const char *data, size_t length, const std::string &encoding,
                                      const std::string &filename, char *&utf8_data,
                                      std::string *original_encoding = nullptr);
+  static Result check_filedata_encoding(const char *data, size_t length, const std::string &encoding,
+                                        const std::string &filename, std::string &charset, size_t &valid_length);
 };
@@ -57,6 +57,8 @@ void db_query_QueryBuffer::insertionPoint(const grt::IntegerRef &value) {
 
 grt::StringRef db_query_QueryBuffer::script() const {
   if (_data) {
+    if (_data->complete_text)
+      _data->complete_text();
     MySQLEditor::Ref editor(_data->editor.lock());
     return grt::StringRef(editor->sql());
   }
@@ -65,6 +67,8 @@ grt::StringRef db_query_QueryBuffer::script() const {
 
 grt::StringRef db_query_QueryBuffer::currentStatement() const {
   if (_data) {
+    if (_data->complete_text)
+      _data->complete_text();
     MySQLEditor::Ref editor(_data->editor.lock());
     return grt::StringRef(editor->current_statement());
   }
@@ -123,6 +127,8 @@ grt::IntegerRef db_query_QueryBuffer::selectionStart() const {
 
 grt::IntegerRef db_query_QueryBuffer::replaceContents(const std::string &text) {
   if (_data) {
+    if (_data->complete_text)
+      _data->complete_text();
     MySQLEditor::Ref editor(_data->editor.lock());
     editor->set_refresh_enabled(true);
     editor->sql(text.c_str());
@@ -132,6 +138,8 @@ grt::IntegerRef db_query_QueryBuffer::replaceContents(const std::string &text) {
 
 grt::IntegerRef db_query_QueryBuffer::replaceSelection(const std::string &text) {
   if (_data) {
+    if (_data->complete_text)
+      _data->complete_text();
     MySQLEditor::Ref editor(_data->editor.lock());
     editor->set_selected_text(text);
   }
@@ -25,6 +25,8 @@
 
 #include <grts/structs.db.query.h>
 
+#include <functional>
+
 class MySQLEditor;
 
 class WBPUBLICBACKEND_PUBLIC_FUNC db_query_QueryBuffer::ImplData {
@@ -35,4 +37,8 @@ public:
 
   db_query_QueryBuffer *self;
   std::weak_ptr<MySQLEditor> editor;
+
+  // Set by owners which fill the editor in the background (e.g. when loading a file), to complete the text
+  // before it is read through this object.
+  std::function<void()> complete_text;
 };
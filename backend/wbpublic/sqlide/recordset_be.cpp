@@ -85,6 +85,7 @@ Recordset::Recordset()
   _toolbar = NULL;
   _client_data = NULL;
   _context_menu = 0;
+  _fetching_rows = false;
   _id = g_atomic_int_get(&next_id);
   g_atomic_int_inc(&next_id);
 
@@ -100,6 +101,7 @@ Recordset::Recordset(GrtThreadedTask::Ref parent_task)
   _toolbar = NULL;
   _client_data = NULL;
   _context_menu = 0;
+  _fetching_rows = false;
   _id = g_atomic_int_get(&next_id);
   g_atomic_int_inc(&next_id);
 
@@ -655,6 +657,116 @@ void Recordset::scroll_rows_frame_backward() {
   }
 }
 
+/**
+ * Returns true if the data storage holds back rows of a streamed result set, which can be fetched with
+ * fetch_more_rows().
+ */
+bool Recordset::has_pending_rows() {
+  return _data_storage && _data_storage->has_pending_rows();
+}
+
+/**
+ * Fetches the next batch of rows of a streamed result set. The rows are read from the server in the background and
+ * added to the recordset in the main thread when they arrived.
+ */
+void Recordset::fetch_more_rows() {
+  if (!has_pending_rows() || _fetching_rows)
+    return;
+
+  // New rows get ids after the fetched ones, so fetching more would collide with them.
+  if (has_pending_changes()) {
+    task->send_msg(grt::ErrorMsg, ERRMSG_PENDING_CHANGES, _("Fetch More Rows"));
+    return;
+  }
+
+  _fetching_rows = true;
+  std::shared_ptr<Fetched_rows> rows(new Fetched_rows());
+  task->exec(false, std::bind(&Recordset::do_fetch_more_rows, this, weak_ptr_from(this),
+                              Recordset_data_storage_Ptr(_data_storage), rows));
+}
+
+grt::StringRef Recordset::do_fetch_more_rows(Ptr self_ptr, Recordset_data_storage_Ptr data_storage_ptr,
+                                             std::shared_ptr<Fetched_rows> rows) {
+  RETVAL_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, self_ptr, self, grt::StringRef(""))
+  {
+    Recordset_data_storage_Ref data_storage = data_storage_ptr.lock();
+    try {
+      if (data_storage)
+        data_storage->do_read_pending_rows(this, *rows);
+    }
+    CATCH_AND_DISPATCH_EXCEPTION(false, "Fetch more rows")
+  }
+
+  // The data swap db and the UI belong to the main thread.
+  task->execute_in_main_thread(std::bind(&Recordset::add_fetched_rows, this, self_ptr, data_storage_ptr, rows), false,
+                               true);
+  return grt::StringRef("");
+}
+
+void Recordset::add_fetched_rows(Ptr self_ptr, Recordset_data_storage_Ptr data_storage_ptr,
+                                 std::shared_ptr<Fetched_rows> rows) {
+  RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, self_ptr, self)
+  _fetching_rows = false;
+  RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset_data_storage, data_storage_ptr, data_storage)
+
+  {
+    base::RecMutexLock data_mutex(_data_mutex);
+    std::shared_ptr<sqlite::connection> data_swap_db = this->data_swap_db();
+    try {
+      data_storage->store_fetched_rows(this, data_swap_db.get(), *rows);
+    }
+    CATCH_AND_DISPATCH_EXCEPTION(false, "Fetch more rows")
+
+    {
+      sqlite::query q(*data_swap_db, "select coalesce(max(id)+1, 0) from `data`");
+      if (q.emit()) {
+        std::shared_ptr<sqlite::result> rs = BoostHelper::convertPointer(q.get_result());
+        _min_new_rowid = rs->get_int(0);
+      }
+      _next_new_rowid = _min_new_rowid;
+    }
+
+    rebuild_data_index(data_swap_db.get(), true, false);
+  }
+
+  // All rows read, this closes the result set without interrupting anything on the server.
+  if (!data_storage->has_pending_rows()) {
+    data_storage->close_pending_rows();
+    rebuild_toolbar();
+  }
+
+  refresh_ui();
+  if (rows_changed)
+    rows_changed();
+}
+
+/**
+ * Stops reading a streamed result set without fetching the remaining rows. The rows read so far are kept.
+ */
+void Recordset::stop_fetching_rows() {
+  // A fetch in progress owns the result set until its rows are added.
+  if (!has_pending_rows() || _fetching_rows)
+    return;
+
+  _data_storage->close_pending_rows();
+  rebuild_toolbar();
+  refresh_ui();
+}
+
+/**
+ * Notification from the data storage that its streamed result set was closed, e.g. because another statement needed
+ * the connection. Resets the fetch actions in the main thread.
+ */
+void Recordset::pending_rows_closed() {
+  task->execute_in_main_thread(std::bind(&Recordset::update_fetch_actions, this, weak_ptr_from(this)), false, true);
+}
+
+void Recordset::update_fetch_actions(Ptr self_ptr) {
+  RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, self_ptr, self)
+  rebuild_toolbar();
+  refresh_ui();
+}
+
 int Recordset::limit_rows_count() {
   return (_data_storage ? _data_storage->limit_rows_count() : 0);
 }
@@ -1351,6 +1463,9 @@ std::string Recordset::status_text() {
       skipped_row_count_text = strfmt(" after %i skipped", limit_rows_offset);
   }
 
+  if (has_pending_rows())
+    limit_text += ", more rows available";
+
   std::stringstream out;
   out << "Fetched " << real_row_count() << " records" << skipped_row_count_text << limit_text;
   std::string status_text = out.str();
@@ -1467,6 +1582,17 @@ void Recordset::rebuild_toolbar() {
       item->signal_activated()->connect(std::bind(&Recordset::scroll_rows_frame_forward, this));
     }
 
+    if (has_pending_rows()) {
+      _toolbar->add_separator_item();
+      add_toolbar_label_item(_toolbar, "Fetch rows:");
+      item = add_toolbar_action_item(_toolbar, im, "record_fetch_next.png", "record_fetch_more",
+                                     "Fetch the next rows of the streamed result set");
+      item->signal_activated()->connect(std::bind(&Recordset::fetch_more_rows, this));
+      item = add_toolbar_action_item(_toolbar, im, "record_fetch_stop.png", "record_fetch_stop",
+                                     "Stop fetching and close the streamed result set");
+      item->signal_activated()->connect(std::bind(&Recordset::stop_fetching_rows, this));
+    }
+
     if (_inserts_editor /* && !is_readonly()*/) {
       _toolbar->add_separator_item();
       add_toolbar_label_item(_toolbar, "Apply changes:");
@@ -1514,6 +1640,10 @@ void Recordset::register_default_actions() {
   _action_list.register_action("record_fetch_all", std::bind(&Recordset::toggle_limit_rows, this));
 
   _action_list.register_action("record_refresh", std::bind(&Recordset::refresh, this));
+
+  _action_list.register_action("record_fetch_more", std::bind(&Recordset::fetch_more_rows, this));
+
+  _action_list.register_action("record_fetch_stop", std::bind(&Recordset::stop_fetching_rows, this));
 }
 
 class DataEditorSelector : public boost::static_visitor<BinaryDataEditor *> {
@@ -185,6 +185,23 @@ public:
   void scroll_rows_frame_forward();
   void scroll_rows_frame_backward();
 
+  // Rows read from a streamed result set, before they are stored in the data swap db.
+  typedef std::vector<std::vector<sqlite::variant_t> > Fetched_rows;
+
+  bool has_pending_rows();
+  void fetch_more_rows();
+  void stop_fetching_rows();
+  void pending_rows_closed(); // Called by the data storage (from any thread) when its streamed result set was closed.
+
+private:
+  bool _fetching_rows;
+
+  grt::StringRef do_fetch_more_rows(Ptr self_ptr, Recordset_data_storage_Ptr data_storage_ptr,
+                                    std::shared_ptr<Fetched_rows> rows);
+  void add_fetched_rows(Ptr self_ptr, Recordset_data_storage_Ptr data_storage_ptr,
+                        std::shared_ptr<Fetched_rows> rows);
+  void update_fetch_actions(Ptr self_ptr);
+
 public:
   mforms::ContextMenu *get_context_menu();
 
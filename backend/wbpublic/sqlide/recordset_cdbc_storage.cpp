@@ -29,6 +29,7 @@
 #include "grtsqlparser/sql_facade.h"
 #include "base/string_utilities.h"
 #include "base/sqlstring.h"
+#include "base/log.h"
 #include <sqlite/query.hpp>
 #include <algorithm>
 #include <ctype.h>
@@ -37,11 +38,55 @@ using namespace bec;
 using namespace grt;
 using namespace base;
 
+DEFAULT_LOG_DOMAIN("Recordset")
+
 Recordset_cdbc_storage::Recordset_cdbc_storage()
-  : Recordset_sql_storage(), _reloadable(true), _gather_field_info(false) {
+  : Recordset_sql_storage(), _reloadable(true), _gather_field_info(false), _fetch_row_budget(0), _fetch_byte_budget(0) {
 }
 
 Recordset_cdbc_storage::~Recordset_cdbc_storage() {
+  close_pending_rows();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Interrupts the query of a streamed result set on the server. Closing an unbuffered result set otherwise
+ * reads (and drops) all its remaining rows first, which can take very long for big results.
+ */
+static void kill_streamed_query(
+  const std::function<base::RecMutexLock(sql::Dbc_connection_handler::Ref &, bool)> &get_aux_connection,
+  std::int64_t connection_id) {
+  if (!get_aux_connection || connection_id < 0)
+    return;
+
+  try {
+    sql::Dbc_connection_handler::Ref aux_conn;
+    base::RecMutexLock aux_lock(get_aux_connection(aux_conn, false));
+    std::unique_ptr<sql::Statement> stmt(aux_conn->ref->createStatement());
+    stmt->execute(strfmt("KILL QUERY %lli", (long long)connection_id));
+  } catch (std::exception &exc) {
+    logWarning("Could not interrupt streamed query: %s\n", exc.what());
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Locks the user connection for running a statement on it. A streamed result set still open on the connection is
+ * interrupted before the lock is taken (the KILL goes through the aux connection) and closed afterwards.
+ */
+base::RecMutexLock Recordset_cdbc_storage::lock_user_connection(sql::Dbc_connection_handler::Ref &conn) {
+  {
+    base::RecMutexLock lock(_getUserConnection(conn, true));
+  }
+  if (conn)
+    conn->interrupt_streaming();
+
+  base::RecMutexLock lock(
+    _getUserConnection(conn, true)); // we can't perform full connection check, hence we use the simple one
+  conn->finish_streaming();
+  return lock;
 }
 
 class FetchVar : public boost::static_visitor<sqlite::variant_t> {
@@ -239,9 +284,11 @@ size_t Recordset_cdbc_storage::determine_pkey_columns_alt(Recordset::Column_name
 }
 
 void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connection *data_swap_db) {
+  // A reload starts over, so whatever is left from a previous streamed read is dropped.
+  close_pending_rows();
+
   sql::Dbc_connection_handler::Ref conn;
-  base::RecMutexLock lock(
-    _getUserConnection(conn, true)); // we can't perform full connection check, hence we use the simple one
+  base::RecMutexLock lock(lock_user_connection(conn));
 
   Recordset_sql_storage::do_unserialize(recordset, data_swap_db);
 
@@ -268,6 +315,8 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
     // if (!_schema_name.empty()) //! default schema is to be set for connector
     //  stmt->execute(strfmt("use `%s`", _schema_name.c_str()));
     // stmt->setFetchSize(100); //! setFetchSize is not implemented. param value to be customized.
+    if (streaming())
+      stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY); // Unbuffered, rows are read as we go.
     stmt->execute(sql_query);
     rs.reset(stmt->getResultSet());
   }
@@ -423,40 +472,61 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
   // editor)
   std::vector<bool> null_value_columns(editable_col_count);
   {
-    bool are_null_columns_possible = recordset->optimized_blob_fetching() && _reloadable && rowid_col_count;
+    // Not while streaming, fetching a blob later on would have to close the streamed result set.
+    bool are_null_columns_possible =
+      recordset->optimized_blob_fetching() && _reloadable && rowid_col_count && !streaming();
     for (ColumnId col = 0; editable_col_count > col; ++col)
       null_value_columns[col] = are_null_columns_possible && sqlide::is_var_blob(real_column_types[col]);
   }
 
   // data
+  std::shared_ptr<PendingRows> pending(new PendingRows());
+  pending->conn = conn;
+  pending->stmt = stmt;
+  pending->rs = rs;
+  pending->editable_col_count = editable_col_count;
+  pending->pkey_columns = _pkey_columns;
+  pending->null_value_columns = null_value_columns;
+
   {
     sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db, false);
 
     create_data_swap_tables(data_swap_db, column_names, column_types);
-
-    FetchVar fetch_var(rs.get());
-    Var_vector row_values(editable_col_count + rowid_col_count);
-
     std::list<std::shared_ptr<sqlite::command> > insert_commands =
       prepare_data_swap_record_add_statement(data_swap_db, column_names);
-    // XXX this will fetch all records before displaying them, which will result in a huge unnecessary lag in the UI
-    while (rs->next()) {
-      for (ColumnId n = 0; editable_col_count > n; ++n) {
-        if (rs->isNull((int)n + 1) || null_value_columns[n]) {
-          row_values[n] = sqlite::null_t();
-        } else {
-          sqlite::variant_t index = (int)n + 1;
-          row_values[n] = boost::apply_visitor(fetch_var, column_types[n], index);
-        }
-      }
-      for (ColumnId n = 0; rowid_col_count > n; ++n) // copy original value of pk field(s)
-        row_values[editable_col_count + n] = row_values[_pkey_columns[n]];
-      add_data_swap_record(insert_commands, row_values);
-
-      if (conn->is_stop_query_requested)
-        throw std::runtime_error(
-          _("Query execution has been stopped, the connection to the DB server was not restarted, any open transaction "
-            "remains open"));
+    if (!fetch_rows(*pending, recordset,
+                    [&](const Var_vector &row_values) { add_data_swap_record(insert_commands, row_values); })) {
+      // The budget is used up before the end of the result set. Keep it open for fetching more rows later on.
+      // Whoever needs the connection next interrupts the query (so the rest is not transferred) and closes it.
+      _pending_rows = pending;
+      std::weak_ptr<PendingRows> weak_pending(pending);
+      std::weak_ptr<Recordset> weak_recordset = weak_ptr_from(recordset);
+      auto get_aux_connection = _getAuxConnection;
+      conn->set_streaming(
+        [weak_pending, weak_recordset]() {
+          std::shared_ptr<PendingRows> pending = weak_pending.lock();
+          if (pending && pending->rs) {
+            try {
+              pending->rs->close();
+              pending->stmt->close();
+            } catch (sql::SQLException &) {
+              // ignore, the connection might have been closed already
+            }
+            pending->rs.reset();
+            pending->stmt.reset();
+
+            // The recordset's fetch actions are no longer applicable.
+            if (std::shared_ptr<Recordset> recordset = weak_recordset.lock())
+              recordset->pending_rows_closed();
+          }
+        },
+        [weak_pending, get_aux_connection]() {
+          std::shared_ptr<PendingRows> pending = weak_pending.lock();
+          if (pending && pending->rs && !pending->complete && !pending->interrupted) {
+            pending->interrupted = true;
+            kill_streamed_query(get_aux_connection, pending->conn->id);
+          }
+        });
     }
 
     transaction_guarder.commit();
@@ -467,11 +537,116 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
     _pkey_columns[rowid_col] = col;
 }
 
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads rows from the result set in the given pending state and passes them to add_row, until either the end of the
+ * result set or the fetch budget (if any) is reached. Returns true if all rows have been read.
+ */
+bool Recordset_cdbc_storage::fetch_rows(PendingRows &pending, Recordset *recordset,
+                                        const std::function<void(const Var_vector &)> &add_row) {
+  Recordset::Column_types &column_types = get_column_types(recordset);
+
+  ColumnId editable_col_count = pending.editable_col_count;
+  ColumnId rowid_col_count = pending.pkey_columns.size();
+  sql::ResultSet *rs = pending.rs.get();
+
+  FetchVar fetch_var(rs);
+  Var_vector row_values(editable_col_count + rowid_col_count);
+
+  size_t fetched_rows = 0;
+  size_t fetched_bytes = 0;
+  // XXX this will fetch all records before displaying them, which will result in a huge unnecessary lag in the UI
+  // (unless a fetch budget is set)
+  for (;;) {
+    if ((_fetch_row_budget > 0 && fetched_rows >= _fetch_row_budget) ||
+        (_fetch_byte_budget > 0 && fetched_bytes >= _fetch_byte_budget))
+      return false;
+
+    if (!rs->next()) {
+      pending.complete = true;
+      break;
+    }
+
+    for (ColumnId n = 0; editable_col_count > n; ++n) {
+      if (rs->isNull((int)n + 1) || pending.null_value_columns[n]) {
+        row_values[n] = sqlite::null_t();
+      } else {
+        sqlite::variant_t index = (int)n + 1;
+        row_values[n] = boost::apply_visitor(fetch_var, column_types[n], index);
+        if (const std::string *value = boost::get<std::string>(&row_values[n]))
+          fetched_bytes += value->size();
+        else if (const sqlite::blob_ref_t *value = boost::get<sqlite::blob_ref_t>(&row_values[n]))
+          fetched_bytes += *value ? (*value)->size() : 0;
+        else
+          fetched_bytes += sizeof(sqlite::variant_t);
+      }
+    }
+    for (ColumnId n = 0; rowid_col_count > n; ++n) // copy original value of pk field(s)
+      row_values[editable_col_count + n] = row_values[pending.pkey_columns[n]];
+    add_row(row_values);
+    ++fetched_rows;
+
+    if (pending.conn->is_stop_query_requested)
+      throw std::runtime_error(
+        _("Query execution has been stopped, the connection to the DB server was not restarted, any open transaction "
+          "remains open"));
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool Recordset_cdbc_storage::has_pending_rows() {
+  return _pending_rows && _pending_rows->rs && !_pending_rows->complete;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Stops reading a streamed result set. Unless all rows were read already, the query is interrupted on the server
+ * (via the aux connection), so that the remaining rows don't need to be transferred. The session itself stays intact.
+ */
+void Recordset_cdbc_storage::close_pending_rows() {
+  std::shared_ptr<PendingRows> pending = _pending_rows;
+  _pending_rows.reset();
+  if (!pending || !pending->rs)
+    return;
+
+  // Not while holding the connection lock, which a fetch in progress might keep for a while.
+  pending->conn->interrupt_streaming();
+
+  // The connection still refers to this result set, its closer does the actual work and clears the blocker.
+  if (_getUserConnection) {
+    sql::Dbc_connection_handler::Ref conn;
+    base::RecMutexLock lock(_getUserConnection(conn, true));
+    pending->conn->finish_streaming();
+  } else
+    pending->conn->finish_streaming();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the next batch of rows from a streamed result set. Called from a worker thread, the rows are stored in the
+ * data swap db by the caller afterwards.
+ */
+void Recordset_cdbc_storage::do_read_pending_rows(Recordset *recordset, Recordset::Fetched_rows &rows) {
+  std::shared_ptr<PendingRows> pending = _pending_rows;
+  if (!pending || !pending->rs || pending->complete)
+    return;
+
+  sql::Dbc_connection_handler::Ref conn;
+  base::RecMutexLock lock(_getUserConnection(conn, true));
+
+  fetch_rows(*pending, recordset, [&rows](const Var_vector &row_values) { rows.push_back(row_values); });
+}
+
 void Recordset_cdbc_storage::do_fetch_blob_value(Recordset *recordset, sqlite::connection *data_swap_db, RowId rowid,
                                                  ColumnId column, sqlite::variant_t &blob_value) {
   sql::Dbc_connection_handler::Ref conn;
-  base::RecMutexLock lock(
-    _getUserConnection(conn, true)); // we can't perform full connection check, hence we use the simple one
+  base::RecMutexLock lock(lock_user_connection(conn));
 
   Recordset::Column_names &column_names = get_column_names(recordset);
   Recordset::Column_types &column_types = get_column_types(recordset);
@@ -536,8 +711,7 @@ public:
 
 void Recordset_cdbc_storage::run_sql_script(const Sql_script &sql_script, bool skip_transaction) {
   sql::Dbc_connection_handler::Ref conn;
-  base::RecMutexLock lock(
-    _getUserConnection(conn, true)); // we can't perform full connection check, hence we use the simple one
+  base::RecMutexLock lock(lock_user_connection(conn));
 
   float progress_state = 0.f;
   float progress_state_inc = sql_script.statements.empty() ? 1.f : 1.f / sql_script.statements.size();
@@ -27,6 +27,8 @@
 #include "sqlide/recordset_sql_storage.h"
 #include "cppdbc.h"
 
+#include <atomic>
+
 class WBPUBLICBACKEND_PUBLIC_FUNC Recordset_cdbc_storage : public Recordset_sql_storage {
 public:
   struct FieldInfo {
@@ -91,6 +93,22 @@ public:
     return _field_info;
   }
 
+  // Streaming mode: rows are read from an unbuffered result set until the budget is exhausted. The result set is then
+  // kept open, so the remaining rows can be fetched on request. A budget of 0 means no limit.
+  void fetch_budget(size_t max_rows, size_t max_bytes) {
+    _fetch_row_budget = max_rows;
+    _fetch_byte_budget = max_bytes;
+  }
+  bool streaming() const {
+    return _fetch_row_budget > 0 || _fetch_byte_budget > 0;
+  }
+
+  virtual bool has_pending_rows();
+  virtual void close_pending_rows();
+
+protected:
+  virtual void do_read_pending_rows(Recordset *recordset, Recordset::Fetched_rows &rows);
+
 private:
   std::function<base::RecMutexLock(sql::Dbc_connection_handler::Ref &, bool)> _getAuxConnection;
   std::function<base::RecMutexLock(sql::Dbc_connection_handler::Ref &, bool)> _getUserConnection;
@@ -101,6 +119,24 @@ private:
   bool _reloadable; // whether can be reloaded using stored sql query
   bool _gather_field_info;
 
+  // State of a streamed result set which was not read completely yet.
+  struct PendingRows {
+    sql::Dbc_connection_handler::Ref conn;
+    std::shared_ptr<sql::Statement> stmt;
+    std::shared_ptr<sql::ResultSet> rs;
+    ColumnId editable_col_count;
+    std::vector<ColumnId> pkey_columns; // Source columns of the copied pk values.
+    std::vector<bool> null_value_columns;
+    std::atomic<bool> complete{false}; // All rows have been read, closing needs no KILL QUERY.
+    bool interrupted = false;          // KILL QUERY was sent already (guarded by the connection's streaming lock).
+  };
+  std::shared_ptr<PendingRows> _pending_rows;
+  size_t _fetch_row_budget;
+  size_t _fetch_byte_budget;
+
+  base::RecMutexLock lock_user_connection(sql::Dbc_connection_handler::Ref &conn);
+  bool fetch_rows(PendingRows &pending, Recordset *recordset, const std::function<void(const Var_vector &)> &add_row);
+
   size_t determine_pkey_columns(Recordset::Column_names &column_names, Recordset::Column_types &column_types,
                                 Recordset::Column_types &real_column_types);
   size_t determine_pkey_columns_alt(Recordset::Column_names &column_names, Recordset::Column_types &column_types,
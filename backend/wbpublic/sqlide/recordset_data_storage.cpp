@@ -194,6 +194,16 @@ void Recordset_data_storage::add_data_swap_record(std::list<std::shared_ptr<sqli
   }
 }
 
+void Recordset_data_storage::store_fetched_rows(Recordset *recordset, sqlite::connection *data_swap_db,
+                                                const Recordset::Fetched_rows &rows) {
+  sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db, false);
+  std::list<std::shared_ptr<sqlite::command> > insert_commands =
+    prepare_data_swap_record_add_statement(data_swap_db, get_column_names(recordset));
+  for (const Var_vector &values : rows)
+    add_data_swap_record(insert_commands, values);
+  transaction_guarder.commit();
+}
+
 void Recordset_data_storage::update_data_swap_record(sqlite::connection *data_swap_db, RowId rowid, ColumnId column,
                                                      const sqlite::variant_t &value) {
   size_t partition = Recordset::data_swap_db_column_partition(column);
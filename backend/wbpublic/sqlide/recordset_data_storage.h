@@ -90,6 +90,20 @@ public:
     return true;
   }
 
+  // Storages reading from a streamed result set may hold back rows beyond their fetch budget.
+  virtual bool has_pending_rows() {
+    return false;
+  }
+  virtual void close_pending_rows() {
+  }
+
+protected:
+  // Reads the next batch of held back rows. Runs in a worker thread, the rows are stored by store_fetched_rows()
+  // in the main thread afterwards.
+  virtual void do_read_pending_rows(Recordset *recordset, Recordset::Fetched_rows &rows) {
+  }
+  void store_fetched_rows(Recordset *recordset, sqlite::connection *data_swap_db, const Recordset::Fetched_rows &rows);
+
 public:
   static void create_data_swap_tables(sqlite::connection *data_swap_db, Recordset::Column_names &column_names,
                                       Recordset::Column_types &column_types);
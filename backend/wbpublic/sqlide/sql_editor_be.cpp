@@ -45,10 +45,25 @@
 #include "SymbolTable.h"
 
 #include "sql_editor_be.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <mutex>
+#include <thread>
 
 DEFAULT_LOG_DOMAIN("MySQL editor");
 
+// The maximum number of entries shown in the auto completion list.
+#define AC_MAX_ENTRIES 1000
+
+// Syntax checks are spread over several threads (each with an own parser context) if at least that many statements
+// must be checked.
+#define SYNTAX_CHECK_PARALLEL_MIN_STATEMENTS 16
+#define SYNTAX_CHECK_MAX_THREADS 4
+
+// Interval (in seconds) in which intermediate results of a running syntax check are shown.
+#define SYNTAX_CHECK_PUBLISH_INTERVAL 0.25
+
 using namespace bec;
 using namespace grt;
 using namespace base;
@@ -78,7 +93,7 @@ public:
 
   // Entries determined the last time we started auto completion. The actually shown list
   // is derived from these entries filtered by the current input.
-  std::vector<std::pair<int, std::string>> codeCompletionCandidates;
+  CompletionCandidateIndex codeCompletionCandidates;
 
   base::RecMutex _sql_checker_mutex;
   MySQLParseUnit parseUnit; // The type of query we want to limit our parsing to.
@@ -99,7 +114,13 @@ public:
   std::set<size_t> _statement_marker_lines;
   base::RecMutex _sql_statement_borders_mutex;
 
-  std::vector<StatementRange> _statementRanges;
+  StatementRangeList _statements;
+  size_t _splitGeneration; // Incremented on each split, so a running check can tell its ranges are outdated.
+
+  // Byte range of the text visible in the editor when the last check was triggered. Statements in it are
+  // checked first.
+  size_t _viewportStart;
+  size_t _viewportEnd;
 
   bool _is_refresh_enabled;   // whether FE control is permitted to replace its
                               // contents from BE
@@ -136,6 +157,49 @@ public:
     _toolbar = nullptr;
     _last_typed_char = 0;
     _updating_statement_markers = false;
+
+    _splitGeneration = 0;
+    _viewportStart = 0;
+    _viewportEnd = 0;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Adds a text change to the region which must be split again.
+   */
+  void register_change(size_t position, size_t length, bool added, size_t textLength) {
+    base::RecMutexLock lock(_sql_statement_borders_mutex);
+    _statements.register_change(position, length, added, textLength);
+    _splitting_required = true;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Marks all statements as unchecked, e.g. after the server version or sql mode changed.
+   */
+  void invalidate_checks() {
+    base::RecMutexLock lock(_sql_statement_borders_mutex);
+    for (auto &check : _statements.checks())
+      check.checked = false;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Builds the error list for the markers from the per statement results. Must be called with the statement
+   * borders mutex locked.
+   */
+  void collect_errors() {
+    _recognition_errors.clear();
+    const std::vector<StatementRange> &ranges = _statements.ranges();
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      for (auto error : _statements.checks()[i].errors) {
+        error.charOffset += ranges[i].start;
+        _recognition_errors.push_back(error);
+      }
+    }
   }
 
   //--------------------------------------------------------------------------------------------------------------------
@@ -152,13 +216,13 @@ public:
 
       base::RecMutexLock lock(_sql_statement_borders_mutex);
 
-      _statementRanges.clear();
+      ++_splitGeneration;
       if (parseUnit == MySQLParseUnit::PuGeneric) {
         double start = timestamp();
-        services->determineStatementRanges(_textInfo.first, _textInfo.second, ";", _statementRanges);
+        _statements.split(_textInfo.first, _textInfo.second);
         logDebug3("Splitting ended after %f ticks\n", timestamp() - start);
       } else
-        _statementRanges.push_back({ 0, 0, _textInfo.second });
+        _statements.assign_single(_textInfo.second);
     }
   }
 
@@ -246,6 +310,11 @@ MySQLEditor::MySQLEditor(MySQLParserContext::Ref syntax_check_context, MySQLPars
                            std::placeholders::_3, std::placeholders::_4));
   scoped_connect(d->codeEditor->signal_marker_changed(),
                  std::bind(&MySQLEditor::Private::marker_changed, d, std::placeholders::_1, std::placeholders::_2));
+  scoped_connect(d->codeEditor->signal_auto_completion(),
+                 [](mforms::AutoCompletionEventType type, int, const std::string &text) {
+                   if (type == mforms::AutoCompletionSelection)
+                     CompletionCandidateIndex::recordUsage(text);
+                 });
 
   setup_auto_completion();
   setup_editor_menu();
@@ -546,6 +615,7 @@ void MySQLEditor::append_text(const std::string &text) {
 void MySQLEditor::sql(const char *sql) {
   d->codeEditor->set_text(sql);
   d->_splitting_required = true;
+  d->_statements.reset();
   d->_statement_marker_lines.clear();
   d->codeEditor->set_eol_mode(mforms::EolLF, true);
 }
@@ -621,6 +691,7 @@ std::string MySQLEditor::sql_mode() {
 void MySQLEditor::set_sql_mode(const std::string &value) {
   d->sqlMode = value;
   d->parserContext->updateSqlMode(value);
+  d->invalidate_checks();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -665,6 +736,7 @@ void MySQLEditor::setServerVersion(GrtVersionRef version) {
   d->codeEditor->set_language(lang);
 
   d->parserContext->updateServerVersion(version);
+  d->invalidate_checks();
   start_sql_processing();
 }
 
@@ -698,6 +770,7 @@ void MySQLEditor::restrict_content_to(ContentType type) {
       d->parseUnit = MySQLParseUnit::PuGeneric;
       break;
   }
+  d->_statements.reset();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -719,8 +792,8 @@ void MySQLEditor::text_changed(int position, int length, int lines_changed, bool
     update_auto_completion(text);
   }
 
-  d->_splitting_required = true;
   d->_textInfo = d->codeEditor->get_text_ptr();
+  d->register_change(position, length, added, d->_textInfo.second);
   if (d->_is_sql_check_enabled)
     d->_current_delay_timer =
       bec::GRTManager::get()->run_every(std::bind(&MySQLEditor::start_sql_processing, this), 0.001);
@@ -745,6 +818,8 @@ void MySQLEditor::char_added(int char_code) {
 void MySQLEditor::dwell_event(bool started, size_t position, int x, int y) {
   if (started) {
     if (d->codeEditor->indicator_at(position) == mforms::RangeIndicatorError) {
+      base::RecMutexLock lock(d->_sql_statement_borders_mutex);
+
       // TODO: sort by position and do a binary search.
       for (size_t i = 0; i < d->_recognition_errors.size(); ++i) {
         ParserErrorInfo entry = d->_recognition_errors[i];
@@ -781,6 +856,16 @@ bool MySQLEditor::start_sql_processing() {
   d->_stop_processing = false;
 
   d->codeEditor->set_status_text("");
+
+  {
+    base::RecMutexLock lock(d->_sql_statement_borders_mutex);
+    size_t firstLine = (size_t)d->codeEditor->send_editor(
+      SCI_DOCLINEFROMVISIBLE, d->codeEditor->send_editor(SCI_GETFIRSTVISIBLELINE, 0, 0), 0);
+    size_t lineCount = (size_t)d->codeEditor->send_editor(SCI_LINESONSCREEN, 0, 0);
+    d->_viewportStart = d->codeEditor->position_from_line(firstLine);
+    d->_viewportEnd = d->codeEditor->position_from_line(firstLine + lineCount + 1);
+  }
+
   if (d->_textInfo.first != nullptr && d->_textInfo.second > 0)
     d->_current_work_timer_id = ThreadedTimer::get()->add_task(
       TimerTimeSpan, 0.05, true, std::bind(&MySQLEditor::do_statement_split_and_check, this, std::placeholders::_1));
@@ -800,18 +885,77 @@ bool MySQLEditor::do_statement_split_and_check(int id) {
 
   base::RecMutexLock lock(d->_sql_checker_mutex);
 
-  // Now do error checking for each of the statements, collecting error
-  // positions for later markup.
-  for (auto &range : d->_statementRanges) {
-    if (d->_stop_processing)
-      return false;
-
-    if (d->services->checkSqlSyntax(d->parserContext, d->_textInfo.first + range.start, range.length, d->parseUnit) > 0) {
-      std::vector<ParserErrorInfo> errors = d->parserContext->errorsWithOffset(range.start);
-      d->_recognition_errors.insert(d->_recognition_errors.end(), errors.begin(), errors.end());
+  // Now do error checking for each of the statements not checked yet (the splitter keeps the results for
+  // statements which did not change). Statements in the visible part of the editor come first.
+  std::vector<size_t> pending;
+  std::vector<StatementRange> pendingRanges;
+  size_t viewportCount = 0;
+  size_t generation;
+  {
+    base::RecMutexLock borders_lock(d->_sql_statement_borders_mutex);
+    generation = d->_splitGeneration;
+    const std::vector<StatementRange> &ranges = d->_statements.ranges();
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      if (d->_statements.checks()[i].checked)
+        continue;
+
+      const StatementRange &range = ranges[i];
+      if (range.start < d->_viewportEnd && range.start + range.length >= d->_viewportStart) {
+        pending.insert(pending.begin() + viewportCount, i);
+        pendingRanges.insert(pendingRanges.begin() + viewportCount++, range);
+      } else {
+        pending.push_back(i);
+        pendingRanges.push_back(range);
+      }
     }
   }
 
+  size_t threadCount = 1;
+  if (pending.size() >= SYNTAX_CHECK_PARALLEL_MIN_STATEMENTS)
+    threadCount = std::max<size_t>(1, std::min<size_t>(SYNTAX_CHECK_MAX_THREADS, std::thread::hardware_concurrency()));
+
+  bool outdated = false;
+  size_t done = 0;
+  size_t viewportRemaining = viewportCount;
+  double lastPublish = timestamp();
+
+  // Intermediate results are shown once the visible statements are done and then in regular intervals.
+  StatementRangeList::check_statements(
+    d->parserContext, d->parseUnit, d->_textInfo.first, pendingRanges, threadCount,
+    [&](size_t index, std::vector<ParserErrorInfo> &errors) {
+      if (d->_stop_processing)
+        return false;
+
+      base::RecMutexLock borders_lock(d->_sql_statement_borders_mutex);
+      if (generation != d->_splitGeneration) {
+        outdated = true; // Text changed meanwhile, a new run will follow.
+        return false;
+      }
+      d->_statements.checks()[pending[index]].errors.swap(errors);
+      d->_statements.checks()[pending[index]].checked = true;
+
+      ++done;
+      bool publish = (index < viewportCount && --viewportRemaining == 0) ||
+                     timestamp() - lastPublish > SYNTAX_CHECK_PUBLISH_INTERVAL;
+      if (publish && done < pending.size()) {
+        lastPublish = timestamp();
+        d->collect_errors();
+        bec::GRTManager::get()->run_once_when_idle(this, std::bind(&MySQLEditor::update_error_markers, this));
+      }
+      return true;
+    });
+
+  if (d->_stop_processing || outdated)
+    return false;
+
+  // Collect the error positions for later markup.
+  {
+    base::RecMutexLock borders_lock(d->_sql_statement_borders_mutex);
+    if (generation != d->_splitGeneration)
+      return false;
+    d->collect_errors();
+  }
+
   bec::GRTManager::get()->run_once_when_idle(this, std::bind(&MySQLEditor::update_error_markers, this));
 
   return false;
@@ -836,7 +980,7 @@ void *MySQLEditor::splitting_done() {
   std::set<size_t> insert_candidates;
 
   std::set<size_t> lines;
-  for (auto &range : d->_statementRanges)
+  for (auto &range : d->_statements.ranges())
     lines.insert(d->codeEditor->line_from_position(range.start));
 
   std::set_difference(lines.begin(), lines.end(), d->_statement_marker_lines.begin(), d->_statement_marker_lines.end(),
@@ -868,17 +1012,23 @@ void *MySQLEditor::update_error_markers() {
 
   std::set<size_t> lines;
 
+  // The list can be updated by a running syntax check, so work on a copy.
+  std::vector<ParserErrorInfo> errors;
+  {
+    base::RecMutexLock lock(d->_sql_statement_borders_mutex);
+    errors = d->_recognition_errors;
+  }
+
   d->codeEditor->remove_indicator(mforms::RangeIndicatorError, 0, d->codeEditor->text_length());
-  if (d->_recognition_errors.size() > 0) {
-    if (d->_recognition_errors.size() == 1)
+  if (errors.size() > 0) {
+    if (errors.size() == 1)
       d->codeEditor->set_status_text(_("1 error found"));
     else
-      d->codeEditor->set_status_text(base::strfmt(_("%lu errors found"), (unsigned long)d->_recognition_errors.size()));
+      d->codeEditor->set_status_text(base::strfmt(_("%lu errors found"), (unsigned long)errors.size()));
 
-    for (size_t i = 0; i < d->_recognition_errors.size(); ++i) {
-      d->codeEditor->show_indicator(mforms::RangeIndicatorError, d->_recognition_errors[i].charOffset,
-                                   d->_recognition_errors[i].length);
-      lines.insert(d->codeEditor->line_from_position(d->_recognition_errors[i].charOffset));
+    for (size_t i = 0; i < errors.size(); ++i) {
+      d->codeEditor->show_indicator(mforms::RangeIndicatorError, errors[i].charOffset, errors[i].length);
+      lines.insert(d->codeEditor->line_from_position(errors[i].charOffset));
     }
   } else
     d->codeEditor->set_status_text("");
@@ -1228,9 +1378,9 @@ void MySQLEditor::show_auto_completion(bool auto_choose_single) {
     caretOffset = g_utf8_pointer_to_offset(line_text.c_str(), line_text.c_str() + caretOffset);
   }
 
-  d->codeCompletionCandidates = d->services->getCodeCompletionCandidates(
+  d->codeCompletionCandidates.assign(d->services->getCodeCompletionCandidates(
     d->autocompletionContext, { caretOffset, caretLine }, statement, d->currentSchema, make_keywords_uppercase(),
-    d->symbolTable);
+    d->symbolTable));
 
   update_auto_completion(getWrittenPart(caretPosition));
 }
@@ -1251,13 +1401,8 @@ std::vector<std::pair<int, std::string>> MySQLEditor::update_auto_completion(con
   if (!typed_part.empty()) {
     gchar *prefix = g_utf8_casefold(typed_part.c_str(), -1);
 
-    std::vector<std::pair<int, std::string>> filteredEntries;
-    for (auto &entry : d->codeCompletionCandidates) {
-      gchar *folded = g_utf8_casefold(entry.second.c_str(), -1);
-      if (g_str_has_prefix(folded, prefix))
-        filteredEntries.push_back(entry);
-      g_free(folded);
-    }
+    std::vector<std::pair<int, std::string>> filteredEntries =
+      d->codeCompletionCandidates.match(typed_part, AC_MAX_ENTRIES);
 
     switch (filteredEntries.size()) {
       case 0:
@@ -1285,16 +1430,16 @@ std::vector<std::pair<int, std::string>> MySQLEditor::update_auto_completion(con
 
     return filteredEntries;
   } else {
-    if (!d->codeCompletionCandidates.empty()) {
+    std::vector<std::pair<int, std::string>> entries = d->codeCompletionCandidates.match("", AC_MAX_ENTRIES);
+    if (!entries.empty()) {
       logDebug2("Showing auto completion popup\n");
-      d->codeEditor->auto_completion_show(0, d->codeCompletionCandidates);
+      d->codeEditor->auto_completion_show(0, entries);
     } else {
       logDebug2("Nothing to autocomplete - hiding popup if it was active\n");
       d->codeEditor->auto_completion_cancel();
     }
+    return entries;
   }
-
-  return d->codeCompletionCandidates;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -1345,14 +1490,15 @@ bool MySQLEditor::get_current_statement_range(size_t &start, size_t &end, bool s
   RecMutexLock sql_statement_borders_mutex(d->_sql_statement_borders_mutex);
   d->split_statements_if_required();
 
-  if (d->_statementRanges.empty())
+  const std::vector<StatementRange> &ranges = d->_statements.ranges();
+  if (ranges.empty())
     return false;
 
-  typedef std::vector<StatementRange>::iterator RangeIterator;
+  typedef std::vector<StatementRange>::const_iterator RangeIterator;
 
   size_t caret_position = d->codeEditor->get_caret_pos();
-  RangeIterator low = d->_statementRanges.begin();
-  RangeIterator high = d->_statementRanges.end() - 1;
+  RangeIterator low = ranges.begin();
+  RangeIterator high = ranges.end() - 1;
   while (low < high) {
     RangeIterator middle = low + (high - low + 1) / 2;
     if (middle->start > caret_position)
@@ -1365,7 +1511,7 @@ bool MySQLEditor::get_current_statement_range(size_t &start, size_t &end, bool s
     }
   }
 
-  if (low == d->_statementRanges.end())
+  if (low == ranges.end())
     return false;
 
   // If we are between two statements (in white spaces) then the algorithm above
@@ -1373,7 +1519,7 @@ bool MySQLEditor::get_current_statement_range(size_t &start, size_t &end, bool s
   if (strict) {
     if (low->start + low->length < caret_position)
       ++low;
-    if (low == d->_statementRanges.end())
+    if (low == ranges.end())
       return false;
   }
 
@@ -1417,3 +1563,368 @@ void MySQLEditor::register_file_drop_for(mforms::DropDelegate *target) {
 }
 
 //----------------------------------------------------------------------------------------------------------------------
+
+//----------------- CompletionCandidateIndex ---------------------------------------------------------------------------
+
+namespace {
+  struct CompletionUsage {
+    size_t count = 0;
+    size_t lastUse = 0; // Value of the usage clock at the last use.
+  };
+
+  std::mutex usageMutex;
+  std::map<std::string, CompletionUsage> usages; // Keyed by the folded name.
+  size_t usageClock = 0;
+
+  std::string foldName(const std::string &name) {
+    gchar *folded = g_utf8_casefold(name.c_str(), -1);
+    std::string result = folded;
+    g_free(folded);
+    return result;
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CompletionCandidateIndex::assign(const Candidates &candidates) {
+  _candidates = candidates;
+
+  _sortedNames.clear();
+  _sortedNames.reserve(_candidates.size());
+  for (size_t i = 0; i < _candidates.size(); ++i)
+    _sortedNames.push_back({ foldName(_candidates[i].second), i });
+  std::sort(_sortedNames.begin(), _sortedNames.end());
+
+  _lastPrefix.clear();
+  _rangeStart = 0;
+  _rangeEnd = _sortedNames.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const CompletionCandidateIndex::Candidates &CompletionCandidateIndex::candidates() const {
+  return _candidates;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+CompletionCandidateIndex::Candidates CompletionCandidateIndex::match(const std::string &prefix, size_t limit) {
+  std::string folded = foldName(prefix);
+
+  // While the user keeps typing the new range is within the previous one.
+  size_t start = 0;
+  size_t end = _sortedNames.size();
+  if (folded.compare(0, _lastPrefix.size(), _lastPrefix) == 0) {
+    start = _rangeStart;
+    end = _rangeEnd;
+  }
+
+  typedef std::pair<std::string, size_t> Entry;
+  auto first = std::lower_bound(_sortedNames.begin() + start, _sortedNames.begin() + end, folded,
+                                [](const Entry &entry, const std::string &value) { return entry.first < value; });
+  auto last = std::upper_bound(first, _sortedNames.begin() + end, folded,
+                               [](const std::string &value, const Entry &entry) {
+                                 return entry.first.compare(0, value.size(), value) > 0;
+                               });
+  _lastPrefix = folded;
+  _rangeStart = first - _sortedNames.begin();
+  _rangeEnd = last - _sortedNames.begin();
+
+  // Rank the matches: often and recently used names first, otherwise in the original order.
+  // The score is the usage count plus a bonus for the last few picks.
+  std::vector<std::pair<size_t, size_t>> ranked; // Score + index in _candidates.
+  ranked.reserve(_rangeEnd - _rangeStart);
+  {
+    std::lock_guard<std::mutex> lock(usageMutex);
+    for (auto iterator = first; iterator != last; ++iterator) {
+      size_t score = 0;
+      if (!usages.empty()) {
+        auto usage = usages.find(iterator->first);
+        if (usage != usages.end()) {
+          size_t age = usageClock - usage->second.lastUse;
+          score = usage->second.count + (age < 10 ? 10 - age : 0);
+        }
+      }
+      ranked.push_back({ score, iterator->second });
+    }
+  }
+
+  auto compare = [](const std::pair<size_t, size_t> &lhs, const std::pair<size_t, size_t> &rhs) {
+    if (lhs.first != rhs.first)
+      return lhs.first > rhs.first;
+    return lhs.second < rhs.second;
+  };
+  limit = std::min(limit, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(), compare);
+
+  Candidates result;
+  result.reserve(limit);
+  for (size_t i = 0; i < limit; ++i)
+    result.push_back(_candidates[ranked[i].second]);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CompletionCandidateIndex::recordUsage(const std::string &name) {
+  std::lock_guard<std::mutex> lock(usageMutex);
+  CompletionUsage &usage = usages[foldName(name)];
+  ++usage.count;
+  usage.lastUse = ++usageClock;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Checks that the last statement found in the text between start and end was closed by a delimiter and
+ * is followed only by whitespace and comments, which the splitter skips.
+ */
+static bool endsCleanly(const char *text, size_t start, size_t end, const std::vector<StatementRange> &ranges) {
+  size_t position = start;
+  if (!ranges.empty()) {
+    position = start + ranges.back().start + ranges.back().length;
+    if (position >= end || text[position] != ';')
+      return false;
+    ++position;
+  }
+
+  while (position < end) {
+    unsigned char c = text[position];
+    if (c <= ' ')
+      ++position;
+    else if (c == '#' || (c == '-' && position + 2 < end && text[position + 1] == '-' &&
+                          (text[position + 2] == ' ' || text[position + 2] == '\t' || text[position + 2] == '\n'))) {
+      const char *lineEnd = static_cast<const char *>(memchr(text + position, '\n', end - position));
+      if (lineEnd == nullptr)
+        return false;
+      position = lineEnd - text + 1;
+    } else if (c == '/' && position + 2 < end && text[position + 1] == '*' && text[position + 2] != '!') {
+      static const char closing[] = "*/";
+      const char *commentEnd = std::search(text + position + 2, text + end, closing, closing + 2);
+      if (commentEnd == text + end)
+        return false;
+      position = commentEnd - text + 2;
+    } else
+      return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Quick check for the DELIMITER keyword (in any letter case) in the given text. This may also find the word in
+ * comments or identifiers, which only means we split more than needed.
+ */
+static bool hasDelimiterCommand(const char *text, size_t length) {
+  static const char keyword[] = "delimiter";
+  if (length < sizeof(keyword) - 1)
+    return false;
+
+  for (const char *run = text, *last = text + length - (sizeof(keyword) - 1); run <= last; ++run) {
+    if ((*run | 0x20) != 'd')
+      continue;
+
+    const char *kw = keyword + 1;
+    const char *next = run + 1;
+    while (*kw != '\0' && (*next | 0x20) == *kw) {
+      ++next;
+      ++kw;
+    }
+    if (*kw == '\0')
+      return true;
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+StatementRangeList::StatementRangeList() : _services(MySQLParserServices::get()) {
+  reset();
+  clear_changes(0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatementRangeList::reset() {
+  _fullSplitRequired = true;
+  _hasDelimiterCommands = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatementRangeList::register_change(size_t position, size_t length, bool added, size_t textLength) {
+  size_t tail = textLength - std::min(textLength, added ? position + length : position);
+  _changeStart = std::min(_changeStart, position);
+  _changeTail = std::min(_changeTail, tail);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatementRangeList::split(const char *text, size_t length) {
+  if (!split_incrementally(text, length)) {
+    _ranges.clear();
+    _services->determineStatementRanges(text, length, ";", _ranges);
+    _checks.assign(_ranges.size(), StatementCheck());
+    _hasDelimiterCommands = hasDelimiterCommand(text, length);
+    _fullSplitRequired = false;
+  }
+  clear_changes(length);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatementRangeList::assign_single(size_t length) {
+  _ranges.assign(1, { 0, 0, length });
+  _checks.assign(1, StatementCheck());
+  reset(); // The ranges of a single statement are no base for an incremental split.
+  clear_changes(length);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const std::vector<StatementRange> &StatementRangeList::ranges() const {
+  return _ranges;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<StatementRangeList::StatementCheck> &StatementRangeList::checks() {
+  return _checks;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatementRangeList::check_statements(MySQLParserContext::Ref context, MySQLParseUnit unit, const char *text,
+                                          const std::vector<StatementRange> &statements, size_t threadCount,
+                                          const CheckResultHandler &handler) {
+  MySQLParserServices::Ref services = MySQLParserServices::get();
+  threadCount = std::max<size_t>(1, std::min(threadCount, statements.size()));
+
+  std::vector<MySQLParserContext::Ref> contexts = { context };
+  for (size_t i = 1; i < threadCount; ++i)
+    contexts.push_back(services->cloneParserContext(context));
+
+  // Each thread takes the next statement until all are done.
+  std::atomic<size_t> next(0);
+  std::atomic<bool> stopped(false);
+  auto check = [&](MySQLParserContext::Ref threadContext) {
+    while (!stopped) {
+      size_t index = next++;
+      if (index >= statements.size())
+        break;
+
+      std::vector<ParserErrorInfo> errors;
+      if (services->checkSqlSyntax(threadContext, text + statements[index].start, statements[index].length, unit) > 0)
+        errors = threadContext->errorsWithOffset(0);
+      if (!handler(index, errors))
+        stopped = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < threadCount; ++i)
+    threads.push_back(std::thread(check, contexts[i]));
+  check(contexts[0]);
+  for (auto &thread : threads)
+    thread.join();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Re-splits only the statements touched by the changes since the last split. Scanning starts after the
+ * delimiter of the last statement before the change and stops at the first unchanged statement following it,
+ * provided nothing but whitespace and comments lie between the last rescanned delimiter and that statement
+ * (so the splitter state there is the same as in the last run).
+ * Returns false if this is not possible and all text must be split again.
+ */
+bool StatementRangeList::split_incrementally(const char *text, size_t length) {
+  if (_fullSplitRequired || _hasDelimiterCommands || _ranges.empty())
+    return false;
+
+  if (_changeStart == std::string::npos || _changeStart + _changeTail > length || _changeTail > _splitLength)
+    return false;
+
+  std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(length) - static_cast<std::ptrdiff_t>(_splitLength);
+  size_t oldTailStart = _splitLength - _changeTail;
+
+  // The first statement whose text or delimiter is at or after the change.
+  auto first = std::lower_bound(_ranges.begin(), _ranges.end(), _changeStart,
+                                [](const StatementRange &range, size_t position) {
+                                  return range.start + range.length < position;
+                                });
+  // Restart after a delimiter, the text before is unchanged and the splitter starts clean there.
+  while (first != _ranges.begin()) {
+    size_t end = (first - 1)->start + (first - 1)->length;
+    if (end < _changeStart && text[end] == ';')
+      break;
+    --first;
+  }
+  size_t restart = 0;
+  size_t restartLine = 0;
+  if (first != _ranges.begin()) {
+    restart = (first - 1)->start + (first - 1)->length + 1;
+    restartLine = (first - 1)->line + std::count(text + (first - 1)->start, text + restart, '\n');
+  }
+
+  // Statements starting in the unchanged tail can be kept, if the rescan ends cleanly before one of them.
+  auto next = std::lower_bound(_ranges.begin(), _ranges.end(), oldTailStart,
+                               [](const StatementRange &range, size_t position) { return range.start < position; });
+
+  std::vector<StatementRange> window;
+  size_t windowEnd;
+  for (int attempts = 0;; ++attempts) {
+    if (attempts == 3) // Don't rescan the window over and over again.
+      next = _ranges.end();
+    windowEnd = (next != _ranges.end()) ? next->start + delta : length;
+
+    if (hasDelimiterCommand(text + restart, windowEnd - restart))
+      return false;
+
+    window.clear();
+    _services->determineStatementRanges(text + restart, windowEnd - restart, ";", window);
+    // The splitter never takes the first character of its input as delimiter, so a kept statement must not
+    // start with one.
+    if (next == _ranges.end() || (text[windowEnd] != ';' && endsCleanly(text, restart, windowEnd, window)))
+      break;
+    ++next;
+  }
+
+  for (auto &range : window) {
+    range.line += restartLine;
+    range.start += restart;
+  }
+
+  std::ptrdiff_t lineDelta = 0;
+  if (next != _ranges.end())
+    lineDelta = static_cast<std::ptrdiff_t>(restartLine + std::count(text + restart, text + windowEnd, '\n')) -
+                static_cast<std::ptrdiff_t>(next->line);
+
+  size_t firstIndex = first - _ranges.begin();
+  size_t nextIndex = next - _ranges.begin();
+  for (auto iterator = next; iterator != _ranges.end(); ++iterator) {
+    iterator->start += delta;
+    iterator->line += lineDelta;
+  }
+
+  _ranges.erase(_ranges.begin() + firstIndex, _ranges.begin() + nextIndex);
+  _ranges.insert(_ranges.begin() + firstIndex, window.begin(), window.end());
+  _checks.erase(_checks.begin() + firstIndex, _checks.begin() + nextIndex);
+  _checks.insert(_checks.begin() + firstIndex, window.size(), StatementCheck());
+
+  logDebug3("Incremental split: %lu statement(s) replaced by %lu\n", (unsigned long)(nextIndex - firstIndex),
+            (unsigned long)window.size());
+  return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void StatementRangeList::clear_changes(size_t length) {
+  _changeStart = std::string::npos;
+  _changeTail = std::string::npos;
+  _splitLength = length;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include "base/trackable.h"
 
 #ifndef _WIN32
+#include <functional>
 #include <memory>
 #include <set>
 
@@ -60,6 +61,90 @@ namespace parsers {
   class SymbolTable;
 }
 
+/**
+ * The candidates of a code completion run, indexed by their (case folded) names for fast prefix lookups while the
+ * user keeps typing. Matches are ranked by how often and how recently they were picked from the completion list,
+ * otherwise they keep their original order.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC CompletionCandidateIndex {
+public:
+  typedef std::vector<std::pair<int, std::string>> Candidates;
+
+  void assign(const Candidates &candidates);
+  const Candidates &candidates() const;
+
+  // Returns at most limit candidates which start with the given prefix (case insensitively).
+  Candidates match(const std::string &prefix, size_t limit);
+
+  // Usage info is shared by all editors.
+  static void recordUsage(const std::string &name);
+
+private:
+  Candidates _candidates;
+  std::vector<std::pair<std::string, size_t>> _sortedNames; // Folded name + index in _candidates, sorted by name.
+
+  // The range in _sortedNames of the last match, for quick narrowing as the prefix grows.
+  std::string _lastPrefix;
+  size_t _rangeStart = 0;
+  size_t _rangeEnd = 0;
+};
+
+/**
+ * The statement ranges of a script together with the syntax check state of each statement. After an edit only the
+ * statements around the changed region are split again, check results for all other statements are kept.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC StatementRangeList {
+public:
+  // Error offsets are relative to the statement start, so entries can be kept when statements before them change.
+  struct StatementCheck {
+    bool checked = false;
+    std::vector<parsers::ParserErrorInfo> errors;
+  };
+
+  StatementRangeList();
+
+  // Makes the next split a full one, e.g. for new content.
+  void reset();
+
+  // Adds a text change to the region which must be split again. Position and length are those of the change
+  // notification, textLength is the size of the text after the change.
+  void register_change(size_t position, size_t length, bool added, size_t textLength);
+
+  // Splits the text, incrementally if possible.
+  void split(const char *text, size_t length);
+
+  // Uses the entire text as a single statement (for restricted content).
+  void assign_single(size_t length);
+
+  const std::vector<parsers::StatementRange> &ranges() const;
+  std::vector<StatementCheck> &checks();
+
+  // Receives the errors of the statement with the given index. Returning false stops the check.
+  typedef std::function<bool(size_t index, std::vector<parsers::ParserErrorInfo> &errors)> CheckResultHandler;
+
+  // Syntax checks the given statements in that order, spread over up to threadCount threads (each using an own
+  // copy of the parser context). The handler is called from these threads.
+  static void check_statements(parsers::MySQLParserContext::Ref context, MySQLParseUnit unit,
+                               const char *text, const std::vector<parsers::StatementRange> &statements,
+                               size_t threadCount, const CheckResultHandler &handler);
+
+private:
+  parsers::MySQLParserServices::Ref _services;
+  std::vector<parsers::StatementRange> _ranges;
+  std::vector<StatementCheck> _checks;
+
+  // Edits since the last split, merged into a single changed region. Text before _changeStart and the
+  // last _changeTail bytes of the text are the same as at the last split.
+  size_t _changeStart;
+  size_t _changeTail;
+  size_t _splitLength;        // Text length at the last split.
+  bool _fullSplitRequired;    // Incremental splitting is only possible after a full split.
+  bool _hasDelimiterCommands; // A DELIMITER command changes the splitting for all following text.
+
+  bool split_incrementally(const char *text, size_t length);
+  void clear_changes(size_t length);
+};
+
 /**
  * The legacy MySQL editor class.
  */
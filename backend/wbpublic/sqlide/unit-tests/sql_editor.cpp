@@ -65,6 +65,145 @@ TEST_FUNCTION(1) {
 	}
 }
 
+/**
+ * Applies an edit the way the code editor reports it (a removal followed by an insertion) and splits the text again.
+ * The resulting ranges must be the same as those of a full split.
+ */
+static void edit_and_compare(StatementRangeList &list, std::string &text, size_t position, size_t removed,
+                             const std::string &inserted, const std::string &message) {
+  if (removed > 0) {
+    text.erase(position, removed);
+    list.register_change(position, removed, false, text.size());
+  }
+  if (!inserted.empty()) {
+    text.insert(position, inserted);
+    list.register_change(position, inserted.size(), true, text.size());
+  }
+  list.split(text.c_str(), text.size());
+
+  std::vector<parsers::StatementRange> expected;
+  parsers::MySQLParserServices::get()->determineStatementRanges(text.c_str(), text.size(), ";", expected);
+
+  const std::vector<parsers::StatementRange> &ranges = list.ranges();
+  ensure_equals(message + ": statement count", ranges.size(), expected.size());
+  ensure_equals(message + ": check count", list.checks().size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    std::string entry = message + ": statement " + std::to_string(i);
+    ensure_equals(entry + " line", ranges[i].line, expected[i].line);
+    ensure_equals(entry + " start", ranges[i].start, expected[i].start);
+    ensure_equals(entry + " length", ranges[i].length, expected[i].length);
+  }
+}
+
+TEST_FUNCTION(2) {
+  // Incremental splitting must give the same ranges as splitting the entire text.
+  std::string text =
+    "select 1;\n"
+    "select * from t1 where a = 'x;y';\n"
+    "-- comment ;\n"
+    "insert into t2 values (1, 2);\n"
+    "/* block ; */ update t3 set b = 2;\n"
+    "\n"
+    "select 3";
+
+  StatementRangeList list;
+  list.split(text.c_str(), text.size());
+  edit_and_compare(list, text, 0, 0, "", "2.1 initial split");
+
+  // Changes inside a statement.
+  edit_and_compare(list, text, text.find("1;"), 0, " + 1", "2.2 insert in statement");
+  edit_and_compare(list, text, text.find(" where"), 16, "", "2.3 delete in statement");
+  edit_and_compare(list, text, text.find("(1, 2)") + 2, 0, ";", "2.4 insert delimiter");
+  edit_and_compare(list, text, text.find("(1;") + 2, 1, "", "2.5 delete delimiter");
+  edit_and_compare(list, text, text.find("update"), 0, "'", "2.6 open string");
+  edit_and_compare(list, text, text.find("'update"), 1, "", "2.7 close string");
+  edit_and_compare(list, text, text.find("values"), 15, "x; select 9;\n", "2.8 replace across delimiter");
+
+  // Delimiter changes.
+  edit_and_compare(list, text, text.find("/* block"), 0, "delimiter $$\nselect 4$$\ndelimiter ;\n",
+                   "2.9 add delimiter command");
+  edit_and_compare(list, text, text.find("select 4"), 8, "select 5", "2.10 edit after delimiter command");
+  edit_and_compare(list, text, text.find("delimiter $$"), 36, "", "2.11 remove delimiter command");
+
+  // Changes at the start and at the end of the buffer.
+  edit_and_compare(list, text, 0, 0, "select 0;\n", "2.12 insert at start");
+  edit_and_compare(list, text, 0, 3, "", "2.13 delete at start");
+  edit_and_compare(list, text, 0, 0, "  ", "2.14 whitespace at start");
+  edit_and_compare(list, text, text.size(), 0, " from dual;", "2.15 append delimiter");
+  edit_and_compare(list, text, text.size(), 0, "\nselect 6", "2.16 append statement");
+  edit_and_compare(list, text, text.size() - 4, 4, "", "2.17 delete at end");
+  edit_and_compare(list, text, text.size() - 12, 12, "", "2.18 delete delimiter at end");
+  edit_and_compare(list, text, 0, text.size(), "select 7;", "2.19 replace all");
+}
+
+TEST_FUNCTION(3) {
+  // Checking statements in parallel must give the same errors as checking them one after the other.
+  std::string text;
+  for (size_t i = 0; i < 40; ++i) {
+    std::string number = std::to_string(i);
+    switch (i % 5) {
+      case 0:
+        text += "select a, b from t" + number + " where a > " + number + ";\n";
+        break;
+      case 1:
+        text += "selec " + number + ";\n";
+        break;
+      case 2:
+        text += "insert into t values (" + number + ", 'a;b');\n";
+        break;
+      case 3:
+        text += "update t set a = where b = " + number + ";\n";
+        break;
+      default:
+        text += "create table t" + number + " (a int primary key, b varchar(20));\n";
+        break;
+    }
+  }
+
+  StatementRangeList list;
+  list.split(text.c_str(), text.size());
+  const std::vector<parsers::StatementRange> &ranges = list.ranges();
+  ensure_equals("3.1 statement count", ranges.size(), 40U);
+
+  parsers::MySQLParserServices::Ref services = parsers::MySQLParserServices::get();
+  parsers::MySQLParserContext::Ref context =
+    services->createParserContext(rdbms->characterSets(), bec::parse_version("8.0.16"), "", 1);
+
+  std::vector<std::vector<parsers::ParserErrorInfo>> sequential(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (services->checkSqlSyntax(context, text.c_str() + ranges[i].start, ranges[i].length,
+                                 MySQLParseUnit::PuGeneric) > 0)
+      sequential[i] = context->errorsWithOffset(0);
+  }
+
+  // Each index is only reported once, so the threads don't need to synchronize the result list.
+  std::vector<std::vector<parsers::ParserErrorInfo>> parallel(ranges.size());
+  std::vector<size_t> reported(ranges.size());
+  StatementRangeList::check_statements(context, MySQLParseUnit::PuGeneric, text.c_str(), ranges, 4,
+                                       [&](size_t index, std::vector<parsers::ParserErrorInfo> &errors) {
+                                         parallel[index].swap(errors);
+                                         ++reported[index];
+                                         return true;
+                                       });
+
+  size_t failing = 0;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    std::string entry = "3.2 statement " + std::to_string(i);
+    ensure_equals(entry + " reported", reported[i], 1U);
+    ensure_equals(entry + " error count", parallel[i].size(), sequential[i].size());
+    for (size_t j = 0; j < sequential[i].size(); ++j) {
+      ensure_equals(entry + " message", parallel[i][j].message, sequential[i][j].message);
+      ensure_equals(entry + " char offset", parallel[i][j].charOffset, sequential[i][j].charOffset);
+      ensure_equals(entry + " line", parallel[i][j].line, sequential[i][j].line);
+      ensure_equals(entry + " offset", parallel[i][j].offset, sequential[i][j].offset);
+      ensure_equals(entry + " length", parallel[i][j].length, sequential[i][j].length);
+    }
+    if (!sequential[i].empty())
+      ++failing;
+  }
+  ensure_equals("3.3 statements with errors", failing, 16U);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -25,6 +25,7 @@
 
 
 #include "code-completion/mysql-code-completion.h"
+#include "code-completion/CodeCompletionCore.h"
 #include "mysql/MySQLRecognizerCommon.h"
 #include "mysql/MySQLLexer.h"
 #include "mysql/MySQLParser.h"
@@ -295,6 +296,142 @@ TEST_FUNCTION(20) {
   ensure_equals("Test 20.15", candidates[2].second, "myisam");
 }
 
+// Symbol lookup by name and type, as used by the code completion.
+TEST_FUNCTION(30) {
+  SymbolTable symbols;
+  SchemaSymbol *schema = symbols.addNewSymbol<SchemaSymbol>(nullptr, "Sakila");
+  TableSymbol *table = symbols.addNewSymbol<TableSymbol>(schema, "Film");
+  StoredRoutineSymbol *routine1 = symbols.addNewSymbol<StoredRoutineSymbol>(schema, "routine1", nullptr);
+  symbols.addNewSymbol<ViewSymbol>(schema, "view1");
+  RoutineSymbol *routine2 = symbols.addNewSymbol<RoutineSymbol>(schema, "routine2", nullptr);
+  ColumnSymbol *column = symbols.addNewSymbol<ColumnSymbol>(table, "Title", nullptr);
+
+  // Schema and table names depend on the server settings, other names are always case insensitive.
+  ensure("30.1", symbols.resolve("Sakila") == schema);
+  ensure("30.2", symbols.resolve("sakila") == nullptr);
+  ensure("30.3", schema->resolve("film") == nullptr);
+  ensure("30.4", table->resolve("TITLE") == column);
+  ensure("30.5", schema->resolve("ROUTINE2") == routine2);
+  symbols.setCaseSensitive(false);
+  ensure("30.6", symbols.resolve("sakila") == schema);
+  ensure("30.7", schema->resolve("film") == table);
+
+  // Sub types are included, in definition order.
+  std::vector<RoutineSymbol *> routines = schema->getSymbolsOfType<RoutineSymbol>();
+  ensure_equals("30.8", routines.size(), 2U);
+  ensure("30.9", routines[0] == routine1 && routines[1] == routine2);
+  ensure_equals("30.10", schema->getSymbolsOfType<ScopedSymbol>().size(), 4U);
+  ensure("30.11", schema->getSymbolsOfType<ColumnSymbol>().empty());
+
+  schema->removeSymbol(routine1);
+  ensure("30.12", schema->resolve("routine1") == nullptr);
+  ensure("30.13", schema->resolve("routine2") == routine2);
+  routines = symbols.getSymbolsOfType<RoutineSymbol>(schema);
+  ensure_equals("30.14", routines.size(), 1U);
+  ensure("30.15", routines[0] == routine2);
+
+  schema->clear();
+  ensure("30.16", schema->resolve("view1") == nullptr);
+  ensure("30.17", schema->getSymbolsOfType<Symbol>().empty());
+}
+
+// Prefix matching and ranking of completion candidates.
+TEST_FUNCTION(31) {
+  CompletionCandidateIndex index;
+  index.assign({ { 1, "SELECT" }, { 2, "film" }, { 3, "Film_id" }, { 4, "fk" }, { 5, "actor" }, { 6, "FILM" } });
+
+  CompletionCandidateIndex::Candidates candidates = index.match("", 100);
+  ensure_equals("31.1", candidates.size(), 6U);
+  ensure_equals("31.2", candidates[0].second, "SELECT");
+
+  // Case insensitive, in the original order.
+  candidates = index.match("f", 100);
+  ensure_equals("31.3", candidates.size(), 4U);
+  ensure_equals("31.4", candidates[0].second, "film");
+  ensure_equals("31.5", candidates[1].second, "Film_id");
+  ensure_equals("31.6", candidates[2].second, "fk");
+  ensure_equals("31.7", candidates[3].second, "FILM");
+
+  candidates = index.match("fil", 2);
+  ensure_equals("31.8", candidates.size(), 2U);
+  ensure_equals("31.9", candidates[0].second, "film");
+  ensure("31.10", index.match("x", 100).empty());
+  ensure_equals("31.11", index.match("A", 100).size(), 1U);
+
+  // Used entries come first.
+  CompletionCandidateIndex::recordUsage("fk");
+  CompletionCandidateIndex::recordUsage("FILM_ID");
+  CompletionCandidateIndex::recordUsage("film_id");
+  candidates = index.match("f", 100);
+  ensure_equals("31.12", candidates[0].second, "Film_id");
+  ensure_equals("31.13", candidates[1].second, "fk");
+  ensure_equals("31.14", candidates[2].second, "film");
+}
+
+// Limits for the candidate collection.
+TEST_FUNCTION(32) {
+  ANTLRInputStream input("select a from t1 where ");
+  MySQLLexer lexer(&input);
+  CommonTokenStream tokens(&lexer);
+  MySQLParser parser(&tokens);
+  lexer.serverVersion = 50717;
+  parser.serverVersion = 50717;
+
+  ErrorListener errorListener;
+  parser.removeErrorListeners();
+  parser.addErrorListener(&errorListener);
+  ParserRuleContext *context = parser.query();
+  size_t caretIndex = tokens.size() - 1;
+
+  CodeCompletionCore c3(&parser);
+  CandidatesCollection candidates = c3.collectCandidates(caretIndex, context);
+  ensure("32.1", candidates.complete);
+  ensure("32.2", !candidates.tokens.empty());
+  ensure("32.3", c3.statistics().rulesProcessed > 0);
+  ensure("32.4", c3.statistics().statesProcessed > 0);
+
+  std::atomic<bool> cancel(true);
+  c3.cancelFlag = &cancel;
+  candidates = c3.collectCandidates(caretIndex, context);
+  ensure("32.5", !candidates.complete);
+  ensure("32.6", candidates.tokens.empty());
+  ensure_equals("32.7", c3.statistics().statesProcessed, 0U);
+}
+
+// Follow sets depend on the grammar predicates and so on the server version.
+TEST_FUNCTION(33) {
+  auto collect = [](long serverVersion) {
+    ANTLRInputStream input("");
+    MySQLLexer lexer(&input);
+    CommonTokenStream tokens(&lexer);
+    MySQLParser parser(&tokens);
+    lexer.serverVersion = serverVersion;
+    parser.serverVersion = serverVersion;
+
+    ErrorListener errorListener;
+    parser.removeErrorListeners();
+    parser.addErrorListener(&errorListener);
+    ParserRuleContext *context = parser.query();
+
+    CodeCompletionCore c3(&parser);
+    return c3.collectCandidates(tokens.size() - 1, context).tokens;
+  };
+
+  // 8.0 first, so its follow sets exist already when 5.7 is collected.
+  std::map<size_t, TokenList> candidates = collect(80016);
+  ensure("33.1", candidates.count(MySQLLexer::SELECT_SYMBOL) > 0);
+  ensure("33.2", candidates.count(MySQLLexer::CLONE_SYMBOL) > 0);
+  ensure("33.3", candidates.count(MySQLLexer::IMPORT_SYMBOL) > 0);
+
+  candidates = collect(50717);
+  ensure("33.4", candidates.count(MySQLLexer::SELECT_SYMBOL) > 0);
+  ensure("33.5", candidates.count(MySQLLexer::CLONE_SYMBOL) == 0);
+  ensure("33.6", candidates.count(MySQLLexer::IMPORT_SYMBOL) == 0);
+
+  candidates = collect(80016);
+  ensure("33.7", candidates.count(MySQLLexer::CLONE_SYMBOL) > 0);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -824,6 +824,11 @@ mforms::View *PreferencesForm::create_sqlide_page() {
 
     entry = otable->add_entry_option("DbSqlEditor:ConnectionTimeOut", _("DBMS connection time out (in seconds):"),
                                      _("Maximum time to wait before a connection attempt is aborted."));
+
+    entry = otable->add_entry_option("DbSqlEditor:ConnectionPoolSize", _("Max. connections for concurrent query tabs:"),
+                                     _("Number of additional connections a SQL editor may open, so that queries in "
+                                       "different tabs run concurrently, each on its own session. "
+                                       "Set to 0 to run all tabs on a single shared connection."));
     box->add(otable, false, true);
   }
 
@@ -899,6 +904,16 @@ mforms::View *PreferencesForm::create_general_editor_page() {
       vbox->add(check, false);
     }
 
+    {
+      mforms::CheckBox *check = new_checkbox_option("DbSqlEditor:PersistentParseCache");
+      check->set_text(_("Keep Syntax Check Results Across Sessions"));
+      check->set_tooltip(
+        _("Store the syntax check results of statements in a file in the user data folder, so that unchanged "
+          "statements don't need to be checked again after a restart.\n"
+          "Changing this option takes effect after a restart."));
+      vbox->add(check, false);
+    }
+
     {
       mforms::Box *tbox = mforms::manage(new mforms::Box(true));
       tbox->set_spacing(4);
@@ -1207,6 +1222,28 @@ mforms::View *PreferencesForm::create_query_page() {
       tbox->add(entry, false, false);
     }
 
+    {
+      mforms::CheckBox *check = new_checkbox_option("DbSqlEditor:StreamResultsets");
+      check->set_text(_("Stream Results"));
+      check->set_tooltip(
+        _("Instead of appending a LIMIT clause, read the rows of a select query as they arrive and stop when the "
+          "row limit or the memory budget is reached. The remaining rows can then be fetched on request.\n"
+          "The connection stays busy while the result is open, running another statement closes it."));
+      vbox->add(check, false);
+    }
+
+    {
+      mforms::Box *tbox = mforms::manage(new mforms::Box(true));
+      tbox->set_spacing(4);
+      vbox->add(tbox, false);
+
+      tbox->add(new_label(_("Memory Budget for Streamed Results (in MB):"), true), false, false);
+      mforms::TextEntry *entry = new_entry_option("DbSqlEditor:StreamResultsetMemoryBudget", false);
+      entry->set_size(50, -1);
+      entry->set_tooltip(_("Approximate amount of field data to read at once from a streamed result set."));
+      tbox->add(entry, false, false);
+    }
+
     {
       mforms::Box *tbox = mforms::manage(new mforms::Box(true));
       tbox->set_spacing(4);
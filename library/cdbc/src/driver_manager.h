@@ -27,7 +27,9 @@
 #include "cppdbc_public_interface.h"
 
 #include <cppconn/driver.h>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <set>
 
 #include "grts/structs.db.mgmt.h"
@@ -206,6 +208,43 @@ namespace sql {
     std::string ssl_cipher;
     bool autocommit_mode;
     bool is_stop_query_requested;
+
+    // Set while a streamed (unbuffered) result set is still open on this connection. Nothing else can be run on
+    // the connection before that result is closed. Must only be used while holding the connection's lock.
+    std::function<void()> close_streamed_result;
+
+    // Stops the query of an open streamed result set on the server, so closing it doesn't have to read all remaining
+    // rows. Works through another connection and can therefore (and should) be used without the connection's lock.
+    std::function<void()> interrupt_streamed_query;
+
+    void set_streaming(const std::function<void()> &close, const std::function<void()> &interrupt) {
+      std::lock_guard<std::mutex> lock(streaming_mutex);
+      close_streamed_result = close;
+      interrupt_streamed_query = interrupt;
+    }
+
+    // The interrupt runs under streaming_mutex, so it cannot overlap with the closing of the result set and hit a
+    // query started afterwards.
+    void interrupt_streaming() {
+      std::lock_guard<std::mutex> lock(streaming_mutex);
+      if (interrupt_streamed_query)
+        interrupt_streamed_query();
+    }
+
+    void finish_streaming() {
+      if (close_streamed_result) {
+        std::function<void()> close_result = close_streamed_result;
+        {
+          std::lock_guard<std::mutex> lock(streaming_mutex);
+          close_streamed_result = std::function<void()>();
+          interrupt_streamed_query = std::function<void()>();
+        }
+        close_result();
+      }
+    }
+
+  private:
+    std::mutex streaming_mutex;
   };
 } // namespace sql
 
@@ -37,7 +37,7 @@
 
 #include "grts/structs.h"
 
-// DEFAULT_LOG_DOMAIN("Diff module") currently unused
+DEFAULT_LOG_DOMAIN("Diff module")
 
 namespace grt {
 
@@ -51,17 +51,13 @@ namespace grt {
 #endif
   }
 
-  //#define LOG_DIFF_TIME
   std::shared_ptr<DiffChange> diff_make(const ValueRef &source, const ValueRef &target, const Omf *omf,
                                         bool dont_clone_values) {
-#ifdef LOG_DIFF_TIME
     time_t start = timestamp();
-#endif
     std::shared_ptr<DiffChange> result = GrtDiff(omf, dont_clone_values).diff(source, target, omf);
-#ifdef LOG_DIFF_TIME
-    logDebug2("Diff took %li ticks\n", timestamp() - start);
-    printf("Diff took %li ticks\n", timestamp() - start);
-#endif
+
+    unsigned int threads = omf != nullptr && !omf->parallel_list_depths.empty() ? omf->diff_threads : 0;
+    logDebug2("Diff took %li ms (%u threads)\n", (long)(timestamp() - start), threads > 1 ? threads : 1);
     return result;
   }
 
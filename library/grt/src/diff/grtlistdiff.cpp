@@ -31,6 +31,16 @@
 
 #include <memory>
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+DEFAULT_LOG_DOMAIN("Diff module")
+
+// Lists with less items found in both source and target are not diffed in parallel.
+#define PARALLEL_DIFF_MIN_ITEMS 4
 
 namespace grt {
   // typedef ListDifference<ValueRef, internal::List::raw_iterator, internal::List::raw_iterator> GrtListDifference;
@@ -57,13 +67,176 @@ namespace grt {
     }
   };
 
-  struct OmfEqPred : public std::binary_function<ValueRef, ValueRef, bool> { // functor for operator<
+  /**
+   * Finds the items of a list which are equal to a given value (as determined by an omf). Only items with the same
+   * hash as the value are compared, which makes matching the items of two lists linear instead of quadratic.
+   */
+  class ListItemIndex {
+  public:
+    enum { npos = internal::List::npos };
+
+    ListItemIndex(const BaseListRef &list, const Omf *omf) : _list(list), _omf(omf) {
+      _hashes.reserve(list.count());
+      for (size_t i = 0; i < list.count(); ++i) {
+        _hashes.push_back(omf->hash(list.get(i)));
+        _buckets[_hashes.back()].push_back(i);
+      }
+    }
+
+    size_t hash(size_t index) const {
+      return _hashes[index];
+    }
+
+    /**
+     * Returns the index of the first item (before limit) that is equal to the given value (which has the given hash),
+     * or npos if there's none. Items are compared with the value as second parameter, like a find_if() would.
+     */
+    size_t find(const ValueRef &value, size_t hash, size_t limit = npos) const {
+      auto bucket = _buckets.find(hash);
+      if (bucket == _buckets.end())
+        return npos;
+
+      for (size_t index : bucket->second) {
+        if (index >= limit)
+          break;
+        if (_omf->equal(_list.get(index), value))
+          return index;
+      }
+      return npos;
+    }
+
+  private:
+    const BaseListRef &_list;
     const Omf *_omf;
-    OmfEqPred(const Omf *omf) : _omf(omf) {
+    std::vector<size_t> _hashes;
+    std::unordered_map<size_t, std::vector<size_t> > _buckets; // Item indexes per hash, ascending.
+  };
+
+  /**
+   * The threads diffing list items in parallel. The outermost list diffed in parallel creates the pool and all lists
+   * nested in it use it as well. A thread waiting for its tasks runs queued tasks meanwhile, so nested use can't
+   * deadlock and the calling thread does its share of the work.
+   */
+  class DiffThreadPool {
+  public:
+    explicit DiffThreadPool(size_t thread_count) : _stopped(false) {
+      for (size_t i = 0; i < thread_count; ++i)
+        _threads.push_back(std::thread(&DiffThreadPool::work, this));
     }
-    bool operator()(const ValueRef &_Left, const ValueRef &_Right) const {
-      return _omf->equal(_Left, _Right);
+
+    ~DiffThreadPool() {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+      }
+      _condition.notify_all();
+      for (auto &thread : _threads)
+        thread.join();
+    }
+
+    /**
+     * Runs the given tasks and returns when all of them are finished. The first exception thrown by a task is
+     * rethrown then.
+     */
+    void run(const std::vector<std::function<void()> > &tasks) {
+      Batch batch;
+      batch.remaining = tasks.size();
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      for (auto &task : tasks)
+        _queue.push_back({ &task, &batch });
+      _condition.notify_all();
+
+      while (batch.remaining > 0) {
+        if (_queue.empty()) {
+          _condition.wait(lock);
+          continue;
+        }
+
+        Task task = _queue.front();
+        _queue.pop_front();
+        lock.unlock();
+        execute(task);
+        lock.lock();
+      }
+
+      if (batch.error)
+        std::rethrow_exception(batch.error);
     }
+
+  private:
+    struct Batch {
+      size_t remaining = 0;
+      std::exception_ptr error;
+    };
+
+    struct Task {
+      const std::function<void()> *function;
+      Batch *batch;
+    };
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Task> _queue;
+    std::vector<std::thread> _threads;
+    bool _stopped;
+
+    void execute(const Task &task) {
+      std::exception_ptr error;
+      try {
+        (*task.function)();
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (error && !task.batch->error)
+          task.batch->error = error;
+        --task.batch->remaining;
+      }
+      _condition.notify_all();
+    }
+
+    void work() {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while (true) {
+        if (!_queue.empty()) {
+          Task task = _queue.front();
+          _queue.pop_front();
+          lock.unlock();
+          execute(task);
+          lock.lock();
+        } else if (_stopped)
+          return;
+        else
+          _condition.wait(lock);
+      }
+    }
+  };
+
+  // The nesting depth of the list currently diffed in this thread and the pool used for parallel list diffs.
+  static thread_local size_t current_list_depth = 0;
+  static thread_local DiffThreadPool *current_pool = nullptr;
+
+  /**
+   * Sets the list depth and thread pool of the current thread, for its lifetime.
+   */
+  class DiffThreadState {
+  public:
+    DiffThreadState(size_t depth, DiffThreadPool *pool) : _depth(current_list_depth), _pool(current_pool) {
+      current_list_depth = depth;
+      current_pool = pool;
+    }
+
+    ~DiffThreadState() {
+      current_list_depth = _depth;
+      current_pool = _pool;
+    }
+
+  private:
+    size_t _depth;
+    DiffThreadPool *_pool;
   };
 
   /**
@@ -142,6 +315,9 @@ namespace grt {
     default_omf def_omf;
     std::vector<std::shared_ptr<ListItemChange> > changes;
     const Omf *comparer = omf ? omf : &def_omf;
+    DiffThreadState list_state(current_list_depth + 1, current_pool);
+    ListItemIndex source_items(source, comparer);
+    ListItemIndex target_items(target, comparer);
     ValueRef prev_value;
     // This is indexes of source's elements that exist in both target and source
     // in order of element appearance in target
@@ -149,45 +325,51 @@ namespace grt {
     // will become the same as target's
     TIndexContainer source_indexes;  // new indexes for already existing elements
     TIndexContainer ordered_indexes; // ordered indexes list for set_difference
+    TIndexContainer target_matches(source.count(), ListItemIndex::npos); // target index for each of ordered_indexes
     for (size_t target_idx = 0; target_idx < target.count();
          ++target_idx) { // look for something that exists in target but not in source, it should be added
       const ValueRef v = target.get(target_idx);
-      internal::List::raw_const_iterator It_Dup = find_if(
-        target.content().raw_begin(), target.content().raw_begin() + target_idx, std::bind2nd(OmfEqPred(comparer), v));
-      if (It_Dup != target.content().raw_begin() + target_idx)
+      size_t hash = target_items.hash(target_idx);
+      if (target_items.find(v, hash, target_idx) != ListItemIndex::npos)
         continue;
-      internal::List::raw_const_iterator It =
-        find_if(source.content().raw_begin(), source.content().raw_end(), std::bind2nd(OmfEqPred(comparer), v));
-      if (It == source.content().raw_end())
+      size_t source_idx = source_items.find(v, hash);
+      if (source_idx == ListItemIndex::npos)
         changes.push_back(std::shared_ptr<ListItemChange>(new ListItemAddedChange(v, prev_value, target_idx)));
       else // item exists in both target and source, save indexes
-        source_indexes.push_back(source.get_index(*It));
+        source_indexes.push_back(source_idx);
       prev_value = v;
     };
 
     for (size_t source_idx = 0; source_idx < source.count();
          ++source_idx) { // look for something that exists in source but not in target, it should be removed
       const ValueRef v = source.get(source_idx);
+      size_t hash = source_items.hash(source_idx);
 
       // This shouldn't happend actually, since lists are expected to be unique
       // But in case of caseless compare we may have non-unique lists
       // so just skip it
-      internal::List::raw_const_iterator It_Dup = find_if(
-        source.content().raw_begin(), source.content().raw_begin() + source_idx, std::bind2nd(OmfEqPred(comparer), v));
-      if (It_Dup != source.content().raw_begin() + source_idx)
+      if (source_items.find(v, hash, source_idx) != ListItemIndex::npos)
         continue;
 
-      internal::List::raw_const_iterator It =
-        find_if(target.content().raw_begin(), target.content().raw_end(), std::bind2nd(OmfEqPred(comparer), v));
-      if (It == target.content().raw_end()) {
+      size_t target_idx = target_items.find(v, hash);
+      if (target_idx == ListItemIndex::npos) {
 #ifdef DEBUG_DIFF
         logInfo("Removing %s from list\n", grt::ObjectRef::cast_from(v)->get_string_member("name").c_str());
         if (grt::ObjectRef::cast_from(v)->get_string_member("name") == "fk_tblClientApp_base_tblClient_base1_idx")
           dump_value(target);
 #endif
         changes.push_back(std::shared_ptr<ListItemChange>(new ListItemRemovedChange(v, source_idx)));
-      } else
+      } else {
         ordered_indexes.push_back(source_idx);
+        target_matches[source_idx] = target_idx;
+      }
+    };
+
+    // The index of the first target element matching the given source element (npos if there's none).
+    auto target_match = [&](size_t source_idx) {
+      if (target_matches[source_idx] != ListItemIndex::npos)
+        return target_matches[source_idx];
+      return target_items.find(source.get(source_idx), source_items.hash(source_idx));
     };
 
     //  return changes.empty()? NULL : new MultiChange(ListModified, changes);// No ListItemOrderChange
@@ -198,25 +380,55 @@ namespace grt {
     std::set_difference(ordered_indexes.begin(), ordered_indexes.end(), stable_elements.rbegin(),
                         stable_elements.rend(), moved_elements.begin());
     for (TIndexContainer::iterator It = moved_elements.begin(); It != moved_elements.end(); ++It) {
-      internal::List::raw_const_iterator It_target = find_if(target.content().raw_begin(), target.content().raw_end(),
-                                                             std::bind2nd(OmfEqPred(comparer), source.get(*It)));
-      prev_value = It_target == target.content().raw_begin() ? ValueRef() : *(It_target - 1);
+      size_t target_idx = target_match(*It);
+      prev_value = target_idx == 0 ? ValueRef() : target.get(target_idx - 1);
       std::shared_ptr<ListItemOrderChange> orderchange(
-        new ListItemOrderChange(source.get(*It), *It_target, omf, prev_value, target.get_index(*It_target)));
+        new ListItemOrderChange(source.get(*It), target.get(target_idx), omf, prev_value, target_idx));
       //    if (!orderchange->subchanges()->empty())
       changes.push_back(orderchange);
     }
 
-    for (TIndexContainer::iterator It = stable_elements.begin(); It != stable_elements.end(); ++It) {
-      internal::List::raw_const_iterator It_target = find_if(target.content().raw_begin(), target.content().raw_end(),
-                                                             std::bind2nd(OmfEqPred(comparer), source.get(*It)));
-      if (It_target != target.content().raw_end()) {
-        std::shared_ptr<ListItemChange> change =
-          create_item_modified_change(source.get(*It), *It_target, omf, target.get_index(*It_target));
-        if (change)
-          changes.push_back(change);
+    // Items in both lists are diffed independently of each other, so that can be done in parallel. The results are
+    // collected per item, which keeps the order of the changes the same in any case.
+    std::vector<std::shared_ptr<ListItemChange> > item_changes(stable_elements.size());
+    auto diff_item = [&](size_t i) {
+      size_t target_idx = target_match(stable_elements[i]);
+      if (target_idx != ListItemIndex::npos)
+        item_changes[i] =
+          create_item_modified_change(source.get(stable_elements[i]), target.get(target_idx), omf, target_idx);
+    };
+
+    if (comparer->diff_threads > 1 && stable_elements.size() >= PARALLEL_DIFF_MIN_ITEMS &&
+        comparer->parallel_list_depths.count(current_list_depth) > 0) {
+      std::unique_ptr<DiffThreadPool> pool;
+      if (current_pool == nullptr) {
+        pool.reset(new DiffThreadPool(comparer->diff_threads - 1));
+        logDebug2("Started %u threads for parallel diffing\n", comparer->diff_threads - 1);
       }
+      DiffThreadState pool_state(current_list_depth, pool ? pool.get() : current_pool);
+
+      // Tasks run in other threads, which must continue with the list depth and pool of this one.
+      size_t depth = current_list_depth;
+      DiffThreadPool *task_pool = current_pool;
+      std::vector<std::function<void()> > tasks;
+      tasks.reserve(stable_elements.size());
+      for (size_t i = 0; i < stable_elements.size(); ++i) {
+        tasks.push_back([&diff_item, depth, task_pool, i]() {
+          DiffThreadState task_state(depth, task_pool);
+          diff_item(i);
+        });
+      }
+      logDebug3("Diffing %lu items of a list at depth %lu in parallel\n", (unsigned long)tasks.size(),
+                (unsigned long)current_list_depth);
+      current_pool->run(tasks);
+    } else {
+      for (size_t i = 0; i < stable_elements.size(); ++i)
+        diff_item(i);
     }
+
+    for (auto &change : item_changes)
+      if (change)
+        changes.push_back(change);
     ChangeSet retval;
     std::sort(changes.begin(), changes.end(), diffPred);
     for (std::vector<std::shared_ptr<ListItemChange> >::const_iterator It = changes.begin(); It != changes.end(); ++It)
@@ -463,6 +463,10 @@ void GRT::end_loading_metaclasses(bool check_class_binding) {
   // register GRT object classes
   internal::ClassRegistry::get_instance()->register_all();
 
+  // build the member tables for slot based member access, now that all members are bound
+  for (std::map<std::string, MetaClass *>::iterator iter = _metaclasses.begin(); iter != _metaclasses.end(); ++iter)
+    iter->second->build_member_slots();
+
   if (check_class_binding) {
     // check if there are any metaclasses with unbound members
     for (std::map<std::string, MetaClass *>::iterator iter = _metaclasses.begin(); iter != _metaclasses.end(); ++iter) {
@@ -597,6 +601,10 @@ void GRT::get_xml_metainfo(xmlDocPtr doc, std::string &doctype_ret, std::string
   base::xml::getXMLDocMetainfo(doc, doctype_ret, version_ret);
 }
 
+bool GRT::get_xml_metainfo(const std::string &path, std::string &doctype_ret, std::string &version_ret) {
+  return internal::Unserializer::read_xml_metainfo(path, doctype_ret, version_ret);
+}
+
 ValueRef GRT::unserialize_xml(xmlDocPtr doc, const std::string &source_path) {
   internal::Unserializer unser(_check_serialized_crc);
 
@@ -616,6 +624,28 @@ ValueRef GRT::unserialize_xml_data(const std::string &data) {
   return internal::Unserializer(_check_serialized_crc).unserialize_xmldata(data.data(), data.size());
 }
 
+void GRT::serialize_binary(const ValueRef &value, const std::string &path, const std::string &doctype,
+                           const std::string &version, const std::string &source_checksum) {
+  internal::BinarySerializer().save_to_file(value, path, doctype, version, source_checksum);
+}
+
+ValueRef GRT::unserialize_binary(const std::string &path, std::string &doctype_ret, std::string &version_ret) {
+  internal::BinaryUnserializer unser(_check_serialized_crc);
+
+  if (!g_file_test(path.c_str(), G_FILE_TEST_EXISTS))
+    throw os_error(path);
+  try {
+    return unser.load_from_file(path, &doctype_ret, &version_ret);
+  } catch (std::exception &exc) {
+    throw grt_runtime_error("Error unserializing GRT data from " + path, exc.what());
+  }
+}
+
+bool GRT::get_binary_metainfo(const std::string &path, std::string &doctype_ret, std::string &version_ret,
+                              std::string &source_checksum_ret) {
+  return internal::BinaryUnserializer::read_metainfo(path, doctype_ret, version_ret, source_checksum_ret);
+}
+
 //--------------------------------------------------------------------------------
 
 void GRT::add_module_loader(ModuleLoader *loader) {
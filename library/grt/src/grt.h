@@ -1955,6 +1955,14 @@ namespace grt {
     */
     template <typename TPred>
     bool foreach_member(TPred pred) {
+      if (!_member_slots.empty()) {
+        for (std::vector<MemberSlot>::const_iterator slot = _member_slots.begin(); slot != _member_slots.end(); ++slot) {
+          if (!pred(slot->member))
+            return false;
+        }
+        return true;
+      }
+
       // set of already seen members (only overridden ones)
       std::set<std::string> seen;
       MetaClass *mc = this;
@@ -2077,6 +2085,24 @@ namespace grt {
     ValueRef call_method(internal::Object *object, const std::string &name, const BaseListRef &args);
     ValueRef call_method(internal::Object *object, const Method *method, const BaseListRef &args);
 
+    /** Member slots.
+     * Each member of the class, including inherited ones, has a slot in a flattened member table, in
+     * foreach_member order. The tables are built by GRT::end_loading_metaclasses. Slots are only valid for the
+     * class they were looked up in, so resolve them once per class and use them for repeated generic access.
+     */
+    static const size_t invalid_slot = (size_t)-1;
+
+    size_t member_slot(const std::string &member) const;
+    size_t member_slot_count() const {
+      return _member_slots.size();
+    }
+    const Member *member_slot_info(size_t slot) const {
+      return _member_slots[slot].member;
+    }
+
+    ValueRef get_slot_value(const internal::Object *object, size_t slot) const;
+    void set_slot_value(internal::Object *object, size_t slot, const ValueRef &value, bool force = false);
+
     ObjectRef allocate();
 
   public:
@@ -2108,6 +2134,7 @@ namespace grt {
     }
 
     void set_member_internal(internal::Object *object, const std::string &name, const ValueRef &value, bool force);
+    void build_member_slots();
 
   public: // for use by Objects during registration
     void bind_allocator(Allocator alloc);
@@ -2139,6 +2166,14 @@ namespace grt {
     SignalList _signals;
     ValidatorList _validators;
 
+    struct MemberSlot {
+      const Member *member;         //< the topmost definition of the member
+      const Member *implementation; //< the definition whose property gets the value
+      const Member *setter;         //< the definition whose property sets the value (NULL if there is none)
+    };
+    std::vector<MemberSlot> _member_slots;
+    std::unordered_map<std::string, size_t> _member_slot_indices;
+
     unsigned int _crc32;
 
     bool _bound;
@@ -2483,12 +2518,19 @@ namespace grt {
 
     xmlDocPtr load_xml(const std::string &path);
     void get_xml_metainfo(xmlDocPtr doc, std::string &doctype_ret, std::string &version_ret);
+    bool get_xml_metainfo(const std::string &path, std::string &doctype_ret, std::string &version_ret);
     ValueRef unserialize_xml(xmlDocPtr doc, const std::string &source_path);
 
     std::string serialize_xml_data(const ValueRef &value, const std::string &doctype = "",
                                    const std::string &version = "", bool list_objects_as_links = false);
     ValueRef unserialize_xml_data(const std::string &data);
 
+    void serialize_binary(const ValueRef &value, const std::string &path, const std::string &doctype = "",
+                          const std::string &version = "", const std::string &source_checksum = "");
+    ValueRef unserialize_binary(const std::string &path, std::string &doctype_ret, std::string &version_ret);
+    bool get_binary_metainfo(const std::string &path, std::string &doctype_ret, std::string &version_ret,
+                             std::string &source_checksum_ret);
+
     // globals
 
     inline ValueRef root() const {
@@ -185,6 +185,9 @@ bool MetaClass::foreach_validator(const ObjectRef &obj, const Validator::Tag &ta
 }
 
 bool MetaClass::has_member(const std::string &member) const {
+  if (!_member_slots.empty())
+    return _member_slot_indices.find(member) != _member_slot_indices.end();
+
   if (_members.find(member) == _members.end()) {
     if (_parent)
       return _parent->has_member(member);
@@ -691,6 +694,12 @@ void MetaClass::set_member_value(internal::Object *object, const std::string &na
 
 void MetaClass::set_member_internal(internal::Object *object, const std::string &name, const ValueRef &value,
                                     bool force) {
+  size_t slot = member_slot(name);
+  if (slot != invalid_slot) {
+    set_slot_value(object, slot, value, force);
+    return;
+  }
+
   MetaClass *mc = this;
   MemberList::const_iterator mem, end;
   bool found = false;
@@ -720,6 +729,10 @@ void MetaClass::set_member_internal(internal::Object *object, const std::string
 }
 
 ValueRef MetaClass::get_member_value(const internal::Object *object, const std::string &name) {
+  size_t slot = member_slot(name);
+  if (slot != invalid_slot)
+    return get_slot_value(object, slot);
+
   MetaClass *mc = this;
   MemberList::const_iterator mem, end;
   do {
@@ -739,6 +752,74 @@ ValueRef MetaClass::get_member_value(const internal::Object *object, const MetaC
   return member->property->get(object);
 }
 
+size_t MetaClass::member_slot(const std::string &member) const {
+  std::unordered_map<std::string, size_t>::const_iterator iter = _member_slot_indices.find(member);
+  if (iter == _member_slot_indices.end())
+    return invalid_slot;
+  return iter->second;
+}
+
+ValueRef MetaClass::get_slot_value(const internal::Object *object, size_t slot) const {
+  const Member *mem = _member_slots[slot].implementation;
+  if (mem->property == NULL)
+    throw bad_item(mem->name);
+
+  return mem->property->get(object);
+}
+
+void MetaClass::set_slot_value(internal::Object *object, size_t slot, const ValueRef &value, bool force) {
+  const Member *mem = _member_slots[slot].setter;
+  if (mem == NULL)
+    throw grt::read_only_item(_name + "." + _member_slots[slot].member->name);
+
+  if (mem->read_only && !force) {
+    if (mem->type.base.type == ListType || mem->type.base.type == DictType)
+      throw grt::read_only_item(_name + "." + mem->name + " (which is a container)");
+    throw grt::read_only_item(_name + "." + mem->name);
+  }
+  mem->property->set(object, value);
+}
+
+/**
+ * Builds the flattened member table of the class. Must be called again if members of the class or its parents
+ * are changed or bound afterwards.
+ */
+void MetaClass::build_member_slots() {
+  _member_slots.clear();
+  _member_slot_indices.clear();
+
+  foreach_member([this](const Member *member) {
+    // Values are read through the original definition of an overridden member, as in get_member_value.
+    const MetaClass *mc = this;
+    MemberList::const_iterator mem, end;
+    do {
+      mem = mc->_members.find(member->name);
+      end = mc->_members.end();
+
+      mc = mc->_parent;
+    } while (mc && (mem == end || mem->second.overrides));
+    const Member *implementation = &mem->second;
+
+    // They are written through the first definition with a setter, which is not necessarily the same one.
+    mc = this;
+    do {
+      mem = mc->_members.find(member->name);
+      end = mc->_members.end();
+
+      mc = mc->_parent;
+    } while (mc && (mem == end || mem->second.overrides || mem->second.property == NULL ||
+                    !mem->second.property->has_setter()));
+    const Member *setter = NULL;
+    if (mem != end && mem->second.property != NULL && mem->second.property->has_setter())
+      setter = &mem->second;
+
+    MemberSlot slot = {member, implementation, setter};
+    _member_slot_indices[member->name] = _member_slots.size();
+    _member_slots.push_back(slot);
+    return true;
+  });
+}
+
 ValueRef MetaClass::call_method(internal::Object *object, const std::string &name, const BaseListRef &args) {
   MetaClass *mc = this;
   MethodList::const_iterator mem, end;
@@ -760,6 +841,10 @@ ValueRef MetaClass::call_method(internal::Object *object, const Method *method,
 }
 
 const MetaClass::Member *MetaClass::get_member_info(const std::string &member) const {
+  size_t slot = member_slot(member);
+  if (slot != invalid_slot)
+    return _member_slots[slot].member;
+
   const MetaClass *mc = this;
   MemberList::const_iterator mem, end;
   do {
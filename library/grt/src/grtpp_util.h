@@ -224,10 +224,38 @@ namespace grt {
     //_dontdiff_mask will hold mask to allow selective bypass of ceratin fields
     // 1 always diff, 2 diff only vs db, 4 diff only vs live object
     unsigned int dontdiff_mask;
-    Omf() : case_sensitive(true), skip_routine_definer(false), dontdiff_mask(1){};
+    // Parallel diffing: the items of lists at the given nesting depths (1 for lists which are members of the diffed
+    // value, like the schemata of a catalog, 2 for lists in their items, like the tables of a schema, etc.)
+    // are diffed by up to diff_threads threads. With less than 2 threads everything is diffed in the calling thread.
+    unsigned int diff_threads;
+    std::set<size_t> parallel_list_depths;
+    Omf() : case_sensitive(true), skip_routine_definer(false), dontdiff_mask(1), diff_threads(0){};
     virtual ~Omf(){};
     virtual bool less(const ValueRef &, const ValueRef &) const = 0;
     virtual bool equal(const ValueRef &, const ValueRef &) const = 0;
+
+    // Returns the same hash for all values equal() considers equal, so that list items can be matched by hashing
+    // instead of comparing all pairs. It only needs to hold for values of the same list (which are of the same kind).
+    // The default puts all values into one bucket, which means pairwise comparison.
+    virtual size_t hash(const ValueRef &) const {
+      return 0;
+    }
+
+    // A hash matching ValueRef::operator==, i.e. by value for simple types and by identity otherwise.
+    static size_t value_hash(const ValueRef &value) {
+      switch (value.type()) {
+        case IntegerType:
+          return std::hash<IntegerRef::storage_type>()(*IntegerRef::cast_from(value));
+        case DoubleType: {
+          DoubleRef::storage_type number = *DoubleRef::cast_from(value);
+          return number == 0 ? 0 : std::hash<DoubleRef::storage_type>()(number); // 0.0 and -0.0 are equal.
+        }
+        case StringType:
+          return std::hash<std::string>()(*StringRef::cast_from(value));
+        default:
+          return std::hash<const void *>()(value.valueptr());
+      }
+    }
   };
 
   struct default_omf : public Omf {
@@ -257,6 +285,14 @@ namespace grt {
     virtual bool equal(const ValueRef &l, const ValueRef &r) const {
       return peq(l, r);
     };
+    virtual size_t hash(const ValueRef &value) const {
+      if (value.type() == ObjectType && ObjectRef::can_wrap(value)) {
+        ObjectRef object = ObjectRef::cast_from(value);
+        if (object->has_member("name"))
+          return std::hash<std::string>()(object->get_string_member("name"));
+      }
+      return value_hash(value);
+    };
   };
 
   MYSQLGRT_PUBLIC
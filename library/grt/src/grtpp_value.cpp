@@ -936,11 +936,12 @@ void Object::__set_id(const std::string& id) {
   _id = id;
 }
 
-bool process_reset_references_for_member(const MetaClass::Member* m, Object* obj) {
-  if (m && !m->calculated && !grt::is_simple_type(m->type.base.type)) {
+static void process_reset_references_for_member(MetaClass* meta, size_t slot, Object* obj) {
+  const MetaClass::Member* m = meta->member_slot_info(slot);
+  if (!m->calculated && !grt::is_simple_type(m->type.base.type)) {
     // g_log("grt", G_LOG_LEVEL_DEBUG, "\tprocess_reset_references_for_member'%s':'%s':'%s'", obj->class_name().c_str(),
     // obj->id().c_str(), m->name.c_str());
-    grt::ValueRef member_value = obj->get_member(m->name);
+    grt::ValueRef member_value = meta->get_slot_value(obj, slot);
     if (member_value.is_valid()) {
       // if the member is owned, then recursively reset references in it
       if (m->owned_object)
@@ -948,48 +949,77 @@ bool process_reset_references_for_member(const MetaClass::Member* m, Object* obj
 
       obj->signal_changed()->disconnect_all_slots();
       // set the member value to null
-      obj->get_metaclass()->set_member_internal(obj, m->name, grt::ValueRef(), true);
+      meta->set_slot_value(obj, slot, grt::ValueRef(), true);
     }
   }
-  return true;
 }
 
 void Object::reset_references() {
   // g_log("grt", G_LOG_LEVEL_DEBUG, "Object::reset_references for '%s':'%s'", class_name().c_str(), id().c_str());
-  _metaclass->foreach_member(std::bind(&process_reset_references_for_member, std::placeholders::_1, this));
+  if (_metaclass->member_slot_count() > 0) {
+    for (size_t count = _metaclass->member_slot_count(), slot = 0; slot < count; slot++)
+      process_reset_references_for_member(_metaclass, slot, this);
+  } else {
+    // the member table is only built by GRT::end_loading_metaclasses
+    _metaclass->foreach_member([this](const MetaClass::Member* m) {
+      if (!m->calculated && !grt::is_simple_type(m->type.base.type)) {
+        grt::ValueRef member_value = get_member(m->name);
+        if (member_value.is_valid()) {
+          if (m->owned_object)
+            member_value.valueptr()->reset_references();
+
+          signal_changed()->disconnect_all_slots();
+          _metaclass->set_member_internal(this, m->name, grt::ValueRef(), true);
+        }
+      }
+      return true;
+    });
+  }
 }
 
 void Object::init() {
 }
 
-static bool mark_global_(const MetaClass::Member* member, const Object* obj) {
-  if (is_container_type(member->type.base.type)) {
-    ValueRef value(obj->get_member(member->name));
-    if (value.is_valid())
-      value.mark_global();
+static void mark_members_global(MetaClass* meta, const Object* obj, bool mark) {
+  if (meta->member_slot_count() > 0) {
+    for (size_t count = meta->member_slot_count(), slot = 0; slot < count; slot++) {
+      if (is_container_type(meta->member_slot_info(slot)->type.base.type)) {
+        ValueRef value(meta->get_slot_value(obj, slot));
+        if (value.is_valid()) {
+          if (mark)
+            value.mark_global();
+          else
+            value.unmark_global();
+        }
+      }
+    }
+  } else {
+    // the member table is only built by GRT::end_loading_metaclasses
+    meta->foreach_member([obj, mark](const MetaClass::Member* member) {
+      if (is_container_type(member->type.base.type)) {
+        ValueRef value(obj->get_member(member->name));
+        if (value.is_valid()) {
+          if (mark)
+            value.mark_global();
+          else
+            value.unmark_global();
+        }
+      }
+      return true;
+    });
   }
-  return true;
 }
 
 void Object::mark_global() const {
   _is_global++;
   if (_is_global == 1)
-    _metaclass->foreach_member(std::bind(&mark_global_, std::placeholders::_1, this));
-}
-
-static bool unmark_global_(const MetaClass::Member* member, const Object* obj) {
-  if (is_container_type(member->type.base.type)) {
-    ValueRef value(obj->get_member(member->name));
-    if (value.is_valid())
-      value.unmark_global();
-  }
-  return true;
+    mark_members_global(_metaclass, this, true);
 }
 
 void Object::unmark_global() const {
   _is_global--;
   if (_is_global == 0)
-    _metaclass->foreach_member(std::bind(&unmark_global_, std::placeholders::_1, this));
+    mark_members_global(_metaclass, this, false);
 }
 
 bool Object::equals(const Value* o) const {
@@ -29,6 +29,8 @@
 #include <libxml/parser.h>
 
 #include <glib.h>
+#include <cstring>
+#include <functional>
 
 #include "base/log.h"
 #include "base/file_functions.h"
@@ -40,10 +42,10 @@
 
 DEFAULT_LOG_DOMAIN("serializer")
 
-static xmlNodePtr new_int_node(xmlNodePtr node, const char *name, int value) {
+static xmlNodePtr new_int_node(xmlNodePtr node, const char *name, long long value) {
   char buffer[32];
 
-  g_snprintf(buffer, sizeof(buffer), "%i", value);
+  g_snprintf(buffer, sizeof(buffer), "%lli", value);
 
   return new_node(node, name, buffer);
 }
@@ -72,10 +74,10 @@ xmlDocPtr internal::Serializer::create_xmldoc_for_value(const ValueRef &value, c
   return doc;
 }
 
-internal::Serializer::Serializer() {
+internal::Serializer::Serializer() : _writer(NULL), _text_saver(NULL), _text_node(NULL) {
 }
 
-static int base_xmlSaveFile(const char *filename, xmlDocPtr doc) {
+static int base_xmlSaveFile(const char *filename, const std::function<int(const char *)> &save) {
   char *local_filename;
   int result;
   FILE *file;
@@ -89,7 +91,7 @@ static int base_xmlSaveFile(const char *filename, xmlDocPtr doc) {
   if (file != NULL) {
     char *tempName = g_strdup_printf("%s.tmp", local_filename);
 
-    result = xmlSaveFormatFile(tempName, doc, 1);
+    result = save(tempName);
     fclose(file);
 
     if (result > 0) {
@@ -99,7 +101,7 @@ static int base_xmlSaveFile(const char *filename, xmlDocPtr doc) {
     };
     g_free(tempName);
   } else
-    result = xmlSaveFormatFile(local_filename, doc, 1);
+    result = save(local_filename);
 
   g_free(local_filename);
 
@@ -122,15 +124,22 @@ static int base_xmlSaveFile(const char *filename, xmlDocPtr doc) {
  ****************************************************************************/
 void internal::Serializer::save_to_xml(const ValueRef &value, const std::string &path, const std::string &doctype,
                                        const std::string &docversion, bool list_objects_as_links) {
-  xmlDocPtr doc;
-
-  doc = create_xmldoc_for_value(value, doctype, docversion, list_objects_as_links);
+  int result = base_xmlSaveFile(path.c_str(), [&](const char *filename) {
+    xmlOutputBufferPtr output = xmlOutputBufferCreateFilename(filename, NULL, 0);
+    if (output == NULL)
+      return -1;
+
+    try {
+      return write_xml(output, value, doctype, docversion, list_objects_as_links);
+    } catch (const std::exception &exc) {
+      logError("Error writing %s: %s\n", filename, exc.what());
+      base_remove(filename);
+      return -1;
+    }
+  });
 
-  if (base_xmlSaveFile(path.c_str(), doc) == -1) {
-    xmlFreeDoc(doc);
+  if (result == -1)
     throw std::runtime_error("Could not save XML data to file " + path);
-  }
-  xmlFreeDoc(doc);
 }
 
 bool internal::Serializer::seen(const ValueRef &value) {
@@ -166,7 +175,7 @@ xmlNodePtr internal::Serializer::serialize_value(const ValueRef &value, xmlNodeP
 
   switch (value.type()) {
     case IntegerType:
-      node = new_int_node(parent, "value", (int)*IntegerRef::cast_from(value));
+      node = new_int_node(parent, "value", (long long)*IntegerRef::cast_from(value));
 
       set_prop(node, "type", "int");
       break;
@@ -324,23 +333,563 @@ xmlNodePtr internal::Serializer::serialize_object(const ObjectRef &object, xmlNo
 
 std::string internal::Serializer::serialize_to_xmldata(const ValueRef &value, const std::string &type,
                                                        const std::string &version, bool list_objects_as_links) {
-  xmlDocPtr doc;
-  xmlChar *buffer = NULL;
-  int size;
-
   if (value.is_valid()) {
     std::string tmp;
+    xmlBufferPtr buffer = xmlBufferCreate();
+
+    try {
+      if (write_xml(xmlOutputBufferCreateBuffer(buffer, NULL), value, type, version, list_objects_as_links) == -1)
+        throw std::runtime_error("Could not serialize XML data");
+    } catch (...) {
+      xmlBufferFree(buffer);
+      throw;
+    }
 
-    doc = create_xmldoc_for_value(value, type, version, list_objects_as_links);
-
-    xmlDocDumpFormatMemory(doc, &buffer, &size, 1);
-
-    xmlFreeDoc(doc);
-    tmp = (char *)buffer;
-
-    xmlFree(buffer);
+    tmp.assign((const char *)xmlBufferContent(buffer), xmlBufferLength(buffer));
+    xmlBufferFree(buffer);
 
     return tmp;
   } else
     return "";
 }
+
+//----------------- Streaming serializer -----------------------------------------------------------
+
+static int write_to_output(void *context, const char *buffer, int len) {
+  return xmlOutputBufferWrite((xmlOutputBufferPtr)context, len, buffer) < 0 ? -1 : len;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void check_written(int result) {
+  if (result < 0)
+    throw std::runtime_error("Error writing XML data");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Writes the XML document for the given value directly to output (which is closed afterwards), without building
+ * the document tree first. The result is byte for byte what saving the tree from create_xmldoc_for_value
+ * with formatting gives.
+ *
+ * @return the number of bytes written or -1 on error.
+ */
+int internal::Serializer::write_xml(xmlOutputBufferPtr output, const ValueRef &value, const std::string &doctype,
+                                    const std::string &docversion, bool list_objects_as_links) {
+  if (output == NULL)
+    return -1;
+
+  _writer = xmlNewTextWriter(output);
+  if (_writer == NULL) {
+    xmlOutputBufferClose(output);
+    return -1;
+  }
+  _text_node = xmlNewText((xmlChar *)"");
+  _text_saver = xmlSaveToIO(write_to_output, NULL, output, NULL, 0);
+
+  auto cleanup = [this]() {
+    if (_text_saver != NULL)
+      xmlSaveClose(_text_saver);
+    if (_text_node != NULL)
+      xmlFreeNode(_text_node);
+    xmlFreeTextWriter(_writer); // Also closes the output.
+
+    _writer = NULL;
+    _text_saver = NULL;
+    _text_node = NULL;
+  };
+
+  int result;
+  try {
+    if (_text_node == NULL || _text_saver == NULL)
+      throw std::runtime_error("Error writing XML data");
+
+    check_written(xmlTextWriterSetIndent(_writer, 1));
+    check_written(xmlTextWriterSetIndentString(_writer, (xmlChar *)"  "));
+    check_written(xmlTextWriterStartDocument(_writer, NULL, NULL, NULL));
+
+    start_element("data");
+    write_attribute(GRT_FILE_VERSION_TAG, GRT_FILE_VERSION);
+    if (!doctype.empty())
+      write_attribute("document_type", doctype.c_str());
+    if (!docversion.empty())
+      write_attribute("version", docversion.c_str());
+
+    write_value(value, NULL, list_objects_as_links);
+
+    check_written(xmlTextWriterEndDocument(_writer));
+    check_written(xmlTextWriterFlush(_writer));
+    result = output->written > 0 ? output->written : -1;
+  } catch (...) {
+    cleanup();
+    throw;
+  }
+  cleanup();
+
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Serializer::start_element(const char *name) {
+  check_written(xmlTextWriterStartElement(_writer, (xmlChar *)name));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Serializer::write_attribute(const char *name, const char *value) {
+  check_written(xmlTextWriterWriteAttribute(_writer, (xmlChar *)name, (xmlChar *)value));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Serializer::write_text(const char *text) {
+  // The text writer escapes content differently than xmlSave does (quotes, non ASCII chars), so close the
+  // start tag and let the save code write the text, as it does for the DOM.
+  check_written(xmlTextWriterWriteRaw(_writer, (xmlChar *)""));
+
+  xmlNodeSetContent(_text_node, (xmlChar *)text);
+  xmlSaveTree(_text_saver, _text_node);
+  check_written(xmlSaveFlush(_text_saver));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Serializer::end_element() {
+  check_written(xmlTextWriterEndElement(_writer));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Streaming counterpart of serialize_value(). Attributes are written in the same order, with the key
+ * (if given) last, as it is added by the caller there.
+ */
+void internal::Serializer::write_value(const ValueRef &value, const char *key, bool list_objects_as_links) {
+  char buffer[100];
+
+  switch (value.type()) {
+    case IntegerType:
+      g_snprintf(buffer, sizeof(buffer), "%lli", (long long)*IntegerRef::cast_from(value));
+
+      start_element("value");
+      write_attribute("type", "int");
+      if (key)
+        write_attribute("key", key);
+      write_text(buffer);
+      end_element();
+      break;
+
+    case DoubleType:
+      start_element("value");
+      write_attribute("type", "real");
+      if (key)
+        write_attribute("key", key);
+      write_text(base::to_string(*DoubleRef::cast_from(value)).c_str());
+      end_element();
+      break;
+
+    case StringType:
+      start_element("value");
+      write_attribute("type", "string");
+      if (key)
+        write_attribute("key", key);
+      write_text(StringRef::cast_from(value).c_str());
+      end_element();
+      break;
+
+    case ListType: {
+      BaseListRef list(BaseListRef::cast_from(value));
+
+      g_snprintf(buffer, sizeof(buffer), "%p", list.valueptr());
+      if (seen(value)) {
+        logDebug3("found duplicate list value");
+        start_element("link");
+        write_attribute("type", "list");
+        if (key)
+          write_attribute("key", key);
+        write_text(buffer);
+        end_element();
+        break;
+      }
+
+      start_element("value");
+      write_attribute("_ptr_", buffer);
+      write_attribute("type", "list");
+      write_attribute("content-type", type_to_str(list.content_type()).c_str());
+      if (!list.content_class_name().empty())
+        write_attribute("content-struct-name", list.content_class_name().c_str());
+      if (key)
+        write_attribute("key", key);
+
+      for (size_t c = list.count(), i = 0; i < c; i++) {
+        ValueRef cvalue(list.get(i));
+
+        if (cvalue.is_valid()) {
+          if (list_objects_as_links && cvalue.type() == ObjectType) {
+            start_element("link");
+            write_attribute("type", "object");
+            write_text(ObjectRef::cast_from(cvalue).id().c_str());
+            end_element();
+          } else
+            write_value(cvalue, NULL, false);
+        } else {
+          start_element("null");
+          end_element();
+        }
+      }
+      end_element();
+      break;
+    }
+
+    case DictType: {
+      DictRef dict(DictRef::cast_from(value));
+
+      g_snprintf(buffer, sizeof(buffer), "%p", value.valueptr());
+      if (seen(value)) {
+        g_warning("found duplicate dict value");
+        start_element("link");
+        write_attribute("type", "dict");
+        if (key)
+          write_attribute("key", key);
+        write_text(buffer);
+        end_element();
+        break;
+      }
+
+      start_element("value");
+      write_attribute("_ptr_", buffer);
+      write_attribute("type", "dict");
+      if (key)
+        write_attribute("key", key);
+
+      for (Dict::const_iterator iter = dict.begin(); iter != dict.end(); ++iter) {
+        if (iter->second.is_valid())
+          write_value(iter->second, iter->first.c_str(), false);
+      }
+      end_element();
+      break;
+    }
+
+    case ObjectType: {
+      ObjectRef object(ObjectRef::cast_from(value));
+
+      if (!seen(object))
+        write_object(object, key);
+      else {
+        start_element("link");
+        write_attribute("type", "object");
+        write_attribute("struct-name", object->class_name().c_str());
+        if (key)
+          write_attribute("key", key);
+        write_text(object->id().c_str());
+        end_element();
+      }
+      break;
+    }
+
+    case UnknownType:
+      break;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Serializer::write_object(const ObjectRef &object, const char *key) {
+  char checksum[40];
+
+  start_element("value");
+  write_attribute("type", "object");
+  write_attribute("struct-name", object->class_name().c_str());
+  write_attribute("id", object->id().c_str());
+
+  g_snprintf(checksum, sizeof(checksum), "0x%x", object.get_metaclass()->crc32());
+  write_attribute("struct-checksum", checksum);
+  if (key)
+    write_attribute("key", key);
+
+  MetaClass *meta = object.get_metaclass();
+  if (meta->member_slot_count() > 0) {
+    for (size_t count = meta->member_slot_count(), slot = 0; slot < count; slot++) {
+      // don't serialize calculated values
+      if (!meta->member_slot_info(slot)->calculated)
+        write_member(meta->member_slot_info(slot), meta->get_slot_value(&object.content(), slot));
+    }
+  } else {
+    // the member table is only built by GRT::end_loading_metaclasses
+    meta->foreach_member([this, &object](const MetaClass::Member *member) {
+      if (!member->calculated)
+        write_member(member, object->get_member(member->name));
+      return true;
+    });
+  }
+
+  end_element();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Serializer::write_member(const MetaClass::Member *member, const ValueRef &v) {
+  if (v.is_valid()) {
+    // not owned objects are stored as link, for lists the *contents* are saved as links
+    if (!member->owned_object && v.type() == ObjectType) {
+      start_element("link");
+      write_attribute("type", "object");
+      write_attribute("struct-name", member->type.base.object_class.c_str());
+      write_attribute("key", member->name.c_str());
+      write_text(ObjectRef::cast_from(v)->id().c_str());
+      end_element();
+    } else
+      write_value(v, member->name.c_str(), !member->owned_object);
+  }
+}
+
+//----------------- BinarySerializer ---------------------------------------------------------------
+
+static void write_varint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((char)((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char)value);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void write_string(std::string &out, const std::string &s) {
+  write_varint(out, s.size());
+  out.append(s);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+internal::BinarySerializer::BinarySerializer() {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::BinarySerializer::save_to_file(const ValueRef &value, const std::string &path,
+                                              const std::string &doctype, const std::string &docversion,
+                                              const std::string &source_checksum, bool list_objects_as_links) {
+  std::string data = serialize_to_data(value, doctype, docversion, source_checksum, list_objects_as_links);
+
+  int result = base_xmlSaveFile(path.c_str(), [&](const char *filename) {
+    FILE *file = base_fopen(filename, "wb");
+    if (file == NULL)
+      return -1;
+
+    size_t written = fwrite(data.data(), 1, data.size(), file);
+    if (fclose(file) != 0 || written != data.size()) {
+      base_remove(filename);
+      return -1;
+    }
+    return (int)written;
+  });
+
+  if (result == -1)
+    throw std::runtime_error("Could not save binary GRT data to file " + path);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string internal::BinarySerializer::serialize_to_data(const ValueRef &value, const std::string &doctype,
+                                                          const std::string &docversion,
+                                                          const std::string &source_checksum,
+                                                          bool list_objects_as_links) {
+  _string_indices.clear();
+  _strings.clear();
+  _containers.clear();
+  _objects.clear();
+  _values.clear();
+
+  write_value(value, list_objects_as_links);
+
+  std::string meta;
+  write_string(meta, doctype);
+  write_string(meta, docversion);
+  write_string(meta, source_checksum);
+
+  std::string strings;
+  write_varint(strings, _strings.size());
+  for (auto s : _strings)
+    write_string(strings, *s);
+
+  // The meta section goes first, so reading the meta info only needs the beginning of the file.
+  std::string data(GRT_BINARY_MAGIC);
+  data.push_back((char)GRT_BINARY_FORMAT_MAJOR);
+  data.push_back((char)GRT_BINARY_FORMAT_MINOR);
+
+  write_varint(data, 3);
+  write_varint(data, binary_format::MetaSection);
+  write_varint(data, 0);
+  write_varint(data, meta.size());
+  write_varint(data, binary_format::StringsSection);
+  write_varint(data, meta.size());
+  write_varint(data, strings.size());
+  write_varint(data, binary_format::ValuesSection);
+  write_varint(data, meta.size() + strings.size());
+  write_varint(data, _values.size());
+
+  data.reserve(data.size() + meta.size() + strings.size() + _values.size());
+  data.append(meta);
+  data.append(strings);
+  data.append(_values);
+
+  _values.clear();
+  _values.shrink_to_fit();
+
+  return data;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t internal::BinarySerializer::string_index(const std::string &s) {
+  auto result = _string_indices.insert(std::make_pair(s, _strings.size()));
+  if (result.second)
+    _strings.push_back(&result.first->first);
+
+  return result.first->second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::BinarySerializer::write_value(const ValueRef &value, bool list_objects_as_links) {
+  using namespace binary_format;
+
+  switch (value.type()) {
+    case IntegerType: {
+      int64_t i = *IntegerRef::cast_from(value);
+      _values.push_back((char)IntegerTag);
+      write_varint(_values, ((uint64_t)i << 1) ^ (uint64_t)(i >> 63));
+      break;
+    }
+
+    case DoubleType: {
+      double d = *DoubleRef::cast_from(value);
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+
+      _values.push_back((char)DoubleTag);
+      for (int i = 0; i < 8; i++, bits >>= 8)
+        _values.push_back((char)(bits & 0xff));
+      break;
+    }
+
+    case StringType:
+      _values.push_back((char)StringTag);
+      write_string(_values, *StringRef::cast_from(value));
+      break;
+
+    case ListType: {
+      BaseListRef list(BaseListRef::cast_from(value));
+
+      auto container = _containers.insert(std::make_pair(value.valueptr(), _containers.size()));
+      if (!container.second) {
+        _values.push_back((char)ListLinkTag);
+        write_varint(_values, container.first->second);
+        break;
+      }
+
+      _values.push_back((char)ListTag);
+      _values.push_back((char)list.content_type());
+      write_varint(_values, list.content_class_name().empty() ? 0 : string_index(list.content_class_name()) + 1);
+      write_varint(_values, list.count());
+
+      for (size_t c = list.count(), i = 0; i < c; i++) {
+        ValueRef cvalue(list.get(i));
+
+        if (!cvalue.is_valid())
+          _values.push_back((char)NullTag);
+        else if (list_objects_as_links && cvalue.type() == ObjectType) {
+          _values.push_back((char)ObjectLinkTag);
+          write_varint(_values, string_index(ObjectRef::cast_from(cvalue)->id()));
+          write_varint(_values, 0);
+        } else
+          write_value(cvalue, false);
+      }
+      break;
+    }
+
+    case DictType: {
+      DictRef dict(DictRef::cast_from(value));
+
+      auto container = _containers.insert(std::make_pair(value.valueptr(), _containers.size()));
+      if (!container.second) {
+        _values.push_back((char)DictLinkTag);
+        write_varint(_values, container.first->second);
+        break;
+      }
+
+      _values.push_back((char)DictTag);
+      for (Dict::const_iterator iter = dict.begin(); iter != dict.end(); ++iter) {
+        if (iter->second.is_valid()) {
+          write_varint(_values, string_index(iter->first) + 1);
+          write_value(iter->second, false);
+        }
+      }
+      write_varint(_values, 0);
+      break;
+    }
+
+    case ObjectType: {
+      ObjectRef object(ObjectRef::cast_from(value));
+
+      if (_objects.insert(object.valueptr()).second)
+        write_object(object);
+      else {
+        _values.push_back((char)ObjectLinkTag);
+        write_varint(_values, string_index(object->id()));
+        write_varint(_values, string_index(object->class_name()) + 1);
+      }
+      break;
+    }
+
+    case UnknownType:
+      _values.push_back((char)NullTag);
+      break;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::BinarySerializer::write_object(const ObjectRef &object) {
+  MetaClass *meta = object.get_metaclass();
+
+  _values.push_back((char)binary_format::ObjectTag);
+  write_varint(_values, string_index(object->class_name()));
+  write_varint(_values, string_index(object->id()));
+  write_varint(_values, meta->crc32());
+
+  if (meta->member_slot_count() > 0) {
+    for (size_t count = meta->member_slot_count(), slot = 0; slot < count; slot++) {
+      // don't serialize calculated values
+      if (!meta->member_slot_info(slot)->calculated)
+        write_member(meta->member_slot_info(slot), meta->get_slot_value(&object.content(), slot));
+    }
+  } else {
+    // the member table is only built by GRT::end_loading_metaclasses
+    meta->foreach_member([this, &object](const MetaClass::Member *member) {
+      if (!member->calculated)
+        write_member(member, object->get_member(member->name));
+      return true;
+    });
+  }
+  write_varint(_values, 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::BinarySerializer::write_member(const MetaClass::Member *member, const ValueRef &v) {
+  if (v.is_valid()) {
+    write_varint(_values, string_index(member->name) + 1);
+
+    // not owned objects are stored as link, for lists the *contents* are saved as links
+    if (!member->owned_object && v.type() == ObjectType) {
+      _values.push_back((char)binary_format::ObjectLinkTag);
+      write_varint(_values, string_index(ObjectRef::cast_from(v)->id()));
+      write_varint(_values, string_index(member->type.base.object_class) + 1);
+    } else
+      write_value(v, !member->owned_object);
+  }
+}
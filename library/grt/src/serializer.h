@@ -25,7 +25,15 @@
 
 #include "grt.h"
 
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <libxml/xmlwriter.h>
+#include <libxml/xmlsave.h>
+
+#define GRT_BINARY_MAGIC "GRTB"
+#define GRT_BINARY_FORMAT_MAJOR 1
+#define GRT_BINARY_FORMAT_MINOR 0
 
 namespace grt {
   namespace internal {
@@ -43,7 +51,12 @@ namespace grt {
                                        bool list_objects_as_links);
 
     protected:
-      std::set<void *> _cache;
+      std::unordered_set<void *> _cache;
+
+      // Streaming output, see write_xml().
+      xmlTextWriterPtr _writer;
+      xmlSaveCtxtPtr _text_saver;
+      xmlNodePtr _text_node;
 
       xmlNodePtr serialize_value(const ValueRef &value, xmlNodePtr parent, bool owned_objects);
       xmlNodePtr serialize_object(const Ref<Object> &object, xmlNodePtr parent);
@@ -51,6 +64,87 @@ namespace grt {
       bool seen(const ValueRef &value);
 
       bool serialize_member(const MetaClass::Member *member, const ObjectRef &object, xmlNodePtr node);
+
+      int write_xml(xmlOutputBufferPtr output, const ValueRef &value, const std::string &doctype,
+                    const std::string &docversion, bool list_objects_as_links);
+      void write_value(const ValueRef &value, const char *key, bool list_objects_as_links);
+      void write_object(const ObjectRef &object, const char *key);
+      void write_member(const MetaClass::Member *member, const ValueRef &value);
+
+      void start_element(const char *name);
+      void write_attribute(const char *name, const char *value);
+      void write_text(const char *text);
+      void end_element();
+    };
+
+    /**
+     * Binary GRT document format. All numbers are unsigned LEB128 varints unless noted otherwise.
+     *
+     *   "GRTB" <major version byte> <minor version byte>
+     *   <section count> { <section id> <offset> <size> }   offsets are relative to the end of this index
+     *   sections, in any order. Readers skip sections they don't know, a different major version is not readable.
+     *
+     * Meta section:    <string doctype> <string version> <string source checksum>
+     * Strings section: <count> { <string> }, a string is <length> <UTF-8 bytes>
+     * Values section:  <value>
+     *
+     * A value starts with a tag byte:
+     *   Null
+     *   Integer        zigzag encoded varint
+     *   Double         8 bytes IEEE 754, little endian
+     *   String         <string>
+     *   List           <content type byte> <content struct name index + 1, 0 for none> <count> { <value> }
+     *   Dict           { <key index + 1> <value> } 0
+     *   Object         <struct name index> <id index> <struct checksum> { <member name index + 1> <value> } 0
+     *   ObjectLink     <id index> <struct name index + 1, 0 for none>
+     *   ListLink, DictLink  <number of the container, in the order lists and dicts appear in the document>
+     *
+     * Indices refer to the strings section. Values that appear more than once are stored at their first
+     * occurrence and as links afterwards, as in the XML format.
+     */
+    namespace binary_format {
+      enum Section { MetaSection = 1, StringsSection = 2, ValuesSection = 3 };
+
+      enum Tag {
+        NullTag = 0,
+        IntegerTag,
+        DoubleTag,
+        StringTag,
+        ListTag,
+        DictTag,
+        ObjectTag,
+        ObjectLinkTag,
+        ListLinkTag,
+        DictLinkTag
+      };
+    };
+
+    /**
+     * Writes GRT values in the binary document format.
+     */
+    class BinarySerializer {
+    public:
+      BinarySerializer();
+
+      void save_to_file(const ValueRef &value, const std::string &path, const std::string &doctype = "",
+                        const std::string &docversion = "", const std::string &source_checksum = "",
+                        bool list_objects_as_links = false);
+
+      std::string serialize_to_data(const ValueRef &value, const std::string &doctype = "",
+                                    const std::string &docversion = "", const std::string &source_checksum = "",
+                                    bool list_objects_as_links = false);
+
+    protected:
+      std::unordered_map<std::string, size_t> _string_indices;
+      std::vector<const std::string *> _strings;
+      std::unordered_map<void *, size_t> _containers;
+      std::unordered_set<void *> _objects;
+      std::string _values;
+
+      size_t string_index(const std::string &s);
+      void write_value(const ValueRef &value, bool list_objects_as_links);
+      void write_object(const ObjectRef &object);
+      void write_member(const MetaClass::Member *member, const ValueRef &value);
     };
   };
 };
@@ -22,12 +22,19 @@
  */
 
 #include "unserializer.h"
+#include "serializer.h"
 
 #include "grtpp_util.h"
 
 #include "base/string_utilities.h"
 #include "base/log.h"
 #include "base/xml_functions.h"
+#include "base/file_utilities.h"
+#include "base/file_functions.h"
+
+#include <cstring>
+#include <map>
+#include <memory>
 
 DEFAULT_LOG_DOMAIN(DOMAIN_GRT)
 
@@ -45,17 +52,30 @@ ValueRef internal::Unserializer::find_cached(const std::string &id) {
   return iter->second;
 }
 
-ValueRef internal::Unserializer::load_from_xml(const std::string &path, std::string *doctype, std::string *docversion) {
-  xmlDocPtr doc = base::xml::loadXMLDoc(path);
+ObjectRef internal::Unserializer::find_external_object(const std::string &id) {
+  // if the linked object is not in the current tree, look for it in the global tree
+  ObjectRef object(grt::GRT::get()->find_object_by_id(id, "/"));
+
+  if (object.is_valid())
+    _cache[object->id()] = object;
+  else
+    _invalid_cache.insert(id);
 
-  ValueRef value = unserialize_xmldoc(doc, path);
+  return object;
+}
 
-  if (doctype && docversion)
-    base::xml::getXMLDocMetainfo(doc, *doctype, *docversion);
+ValueRef internal::Unserializer::load_from_xml(const std::string &path, std::string *doctype, std::string *docversion) {
+  if (!base::file_exists(path))
+    throw std::runtime_error("unable to open XML file, doesn't exists: " + path);
 
-  xmlFreeDoc(doc);
+  std::unique_ptr<xmlTextReader, void (*)(xmlTextReaderPtr)> reader(xmlReaderForFile(path.c_str(), NULL, 0),
+                                                                    xmlFreeTextReader);
+  if (!reader)
+    throw std::runtime_error("unable to parse XML file " + path);
 
-  return value;
+  _source_name = path;
+
+  return unserialize_xmlreader(reader.get(), doctype, docversion);
 }
 
 ValueRef internal::Unserializer::unserialize_xmldoc(xmlDocPtr doc, const std::string &source_path) {
@@ -141,15 +161,7 @@ ValueRef internal::Unserializer::traverse_xml_recreating_tree(xmlNodePtr node) {
 
       // we have looked up already
       // check if the object was loaded in the 1st step
-
-      // if the linked object is not in the current tree, look for it in the global tree
-      ObjectRef object(grt::GRT::get()->find_object_by_id(link_id, "/"));
-
-      if (object.is_valid())
-        _cache[object->id()] = object;
-      else
-        _invalid_cache.insert(link_id);
-      value = object;
+      value = find_external_object(link_id);
 
       if (!value.is_valid() /*&& base::xml::getProp(node, "key") != "owner"*/)
         logWarning("%s:%i: link '%s' <%s %s> key=%s could not be resolved\n", _source_name.c_str(), node->line,
@@ -171,7 +183,7 @@ ValueRef internal::Unserializer::traverse_xml_recreating_tree(xmlNodePtr node) {
 
   switch (vtype) {
     case IntegerType:
-      value = IntegerRef(strtol((char *)base::xml::getContent(node).c_str(), NULL, 0));
+      value = IntegerRef((IntegerRef::storage_type)strtoll((char *)base::xml::getContent(node).c_str(), NULL, 0));
       break;
 
     case DoubleType: {
@@ -259,15 +271,9 @@ ValueRef internal::Unserializer::traverse_xml_recreating_tree(xmlNodePtr node) {
           } else {
             sub_value = traverse_xml_recreating_tree(child);
 
-            if (sub_value.is_valid()) {
-              try {
-                list.ginsert(sub_value);
-              } catch (const std::exception &exc) {
-                logWarning("%s: Error inserting %s to list: %s", _source_name.c_str(),
-                           sub_value.debugDescription().c_str(), exc.what());
-                throw;
-              }
-            } else {
+            if (sub_value.is_valid())
+              insert_list_item(list, sub_value);
+            else {
               // error!
               logWarning("%s: skipping element '%s' in unserialized document, line %i", _source_name.c_str(),
                          child->name, child->line);
@@ -294,32 +300,36 @@ ValueRef internal::Unserializer::traverse_xml_recreating_tree(xmlNodePtr node) {
 }
 
 ObjectRef internal::Unserializer::unserialize_object_step1(xmlNodePtr node) {
-  MetaClass *gstruct;
-  std::string id;
-
   std::string prop = base::xml::getProp(node, "type");
   if (prop != "object")
     throw std::runtime_error("error unserializing object (unexpected type)");
 
-  prop = base::xml::getProp(node, "struct-name");
-  if (prop.empty())
+  return allocate_object(base::xml::getProp(node, "struct-name"), base::xml::getProp(node, "id"),
+                         base::xml::getProp(node, "struct-checksum"), node->line);
+}
+
+/**
+ * Creates an empty object of the given struct, with the serialized id. The struct checksum stored in the
+ * document is compared with the current one if checking is enabled.
+ */
+ObjectRef internal::Unserializer::allocate_object(const std::string &struct_name, const std::string &id,
+                                                  const std::string &checksum, int line) {
+  if (struct_name.empty())
     throw std::runtime_error("error unserializing object (missing struct-name)");
 
-  gstruct = grt::GRT::get()->get_metaclass(prop);
+  MetaClass *gstruct = grt::GRT::get()->get_metaclass(struct_name);
   if (!gstruct) {
-    logWarning("%s:%i: error unserializing object: struct '%s' unknown", _source_name.c_str(), node->line,
-               prop.c_str());
-    throw std::runtime_error(base::strfmt("error unserializing object (struct '%s' unknown)", prop.c_str()));
+    logWarning("%s:%i: error unserializing object: struct '%s' unknown", _source_name.c_str(), line,
+               struct_name.c_str());
+    throw std::runtime_error(base::strfmt("error unserializing object (struct '%s' unknown)", struct_name.c_str()));
   }
 
-  id = base::xml::getProp(node, "id");
   if (id.empty())
     throw std::runtime_error("missing id in unserialized object");
 
-  prop = base::xml::getProp(node, "struct-checksum");
-  if (!prop.empty()) {
-    unsigned int checksum = (unsigned int)strtol(prop.c_str(), NULL, 0);
-    if (_check_serialized_crc && checksum != gstruct->crc32()) {
+  if (!checksum.empty()) {
+    unsigned int crc = (unsigned int)strtol(checksum.c_str(), NULL, 0);
+    if (_check_serialized_crc && crc != gstruct->crc32()) {
       logWarning("current checksum of struct of serialized object %s (%s) differs from the one when it was saved",
                  id.c_str(), gstruct->name().c_str());
     }
@@ -349,7 +359,6 @@ void internal::Unserializer::unserialize_object_contents(const ObjectRef &object
   std::string prop;
   // load values
   xmlNodePtr child;
-  MetaClass *mc = object->get_metaclass();
 
   child = node->children;
   while (child) {
@@ -381,15 +390,8 @@ void internal::Unserializer::unserialize_object_contents(const ObjectRef &object
             logWarning("%s in %s:%s %s", exc.what(), object->class_name().c_str(), key.c_str(), object->id().c_str());
             throw;
           }
-          if (sub_value.is_valid()) {
-            try {
-              mc->set_member_internal((internal::Object *)object.valueptr(), key, sub_value, true);
-            } catch (const std::exception &exc) {
-              logWarning("exception setting %s<%s>:%s to %s %s", object.id().c_str(), object.class_name().c_str(),
-                         key.c_str(), sub_value.debugDescription().c_str(), exc.what());
-              throw;
-            }
-          }
+          if (sub_value.is_valid())
+            set_object_member(object, key, sub_value);
         }
       }
     }
@@ -397,10 +399,39 @@ void internal::Unserializer::unserialize_object_contents(const ObjectRef &object
   }
 }
 
-ValueRef internal::Unserializer::unserialize_xmldata(const char *data, size_t size) {
-  xmlDocPtr doc = xmlReadMemory(data, (int)size, NULL, NULL, XML_PARSE_NOENT);
+void internal::Unserializer::set_object_member(const ObjectRef &object, const std::string &key,
+                                               const ValueRef &value) {
+  try {
+    object->get_metaclass()->set_member_internal((internal::Object *)object.valueptr(), key, value, true);
+  } catch (const std::exception &exc) {
+    logWarning("exception setting %s<%s>:%s to %s %s", object.id().c_str(), object.class_name().c_str(), key.c_str(),
+               value.debugDescription().c_str(), exc.what());
+    throw;
+  }
+}
+
+void internal::Unserializer::insert_list_item(BaseListRef &list, const ValueRef &value) {
+  try {
+    list.ginsert(value);
+  } catch (const std::exception &exc) {
+    logWarning("%s: Error inserting %s to list: %s", _source_name.c_str(), value.debugDescription().c_str(),
+               exc.what());
+    throw;
+  }
+}
+
+//----------------- Streaming unserializer ---------------------------------------------------------
+
+/*
+ * The streaming variant reads the document with an xmlTextReader in a single pass, so the document tree is never
+ * built in memory. Objects are created when their value node starts (so links from their children to them, like
+ * owner, resolve immediately). Links to objects that appear later in the document are recorded and patched in once
+ * the whole document has been read, which gives the same tree the two pass DOM traversal above creates.
+ */
 
-  if (!doc) {
+static bool read_next_node(xmlTextReaderPtr reader) {
+  int result = xmlTextReaderRead(reader);
+  if (result < 0) {
     xmlErrorPtr error = xmlGetLastError();
 
     if (error)
@@ -408,10 +439,907 @@ ValueRef internal::Unserializer::unserialize_xmldata(const char *data, size_t si
     else
       throw std::runtime_error("Could not parse XML data");
   }
+  return result == 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::string reader_attribute(xmlTextReaderPtr reader, const char *name) {
+  xmlChar *prop = xmlTextReaderGetAttribute(reader, (const xmlChar *)name);
+  std::string tmp = prop ? (char *)prop : "";
+  xmlFree(prop);
+  return tmp;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static int reader_line(xmlTextReaderPtr reader) {
+  xmlNodePtr node = xmlTextReaderCurrentNode(reader);
+  return node ? (int)node->line : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static bool reader_element_is(xmlTextReaderPtr reader, const char *name) {
+  return xmlStrcmp(xmlTextReaderConstLocalName(reader), (const xmlChar *)name) == 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Calls handler for each child element of the element the reader is currently positioned on.
+ * The handler must consume the child element completely, i.e. leave the reader on its end tag
+ * (or on the element itself, if it is empty).
+ */
+template <typename Handler>
+static void for_each_child_element(xmlTextReaderPtr reader, Handler handler) {
+  if (xmlTextReaderIsEmptyElement(reader))
+    return;
+
+  int depth = xmlTextReaderDepth(reader);
+  while (read_next_node(reader)) {
+    int type = xmlTextReaderNodeType(reader);
+    if (type == XML_READER_TYPE_END_ELEMENT && xmlTextReaderDepth(reader) == depth)
+      return;
+    if (type == XML_READER_TYPE_ELEMENT)
+      handler();
+  }
+  throw std::runtime_error("Could not parse XML data, unexpected end of document");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void skip_element(xmlTextReaderPtr reader) {
+  for_each_child_element(reader, [reader]() { skip_element(reader); });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the text content of the current element (including that of sub elements, like xmlNodeGetContent)
+ * and moves the reader to its end.
+ */
+static std::string read_element_text(xmlTextReaderPtr reader) {
+  std::string text;
+  if (xmlTextReaderIsEmptyElement(reader))
+    return text;
+
+  int depth = xmlTextReaderDepth(reader);
+  while (read_next_node(reader)) {
+    switch (xmlTextReaderNodeType(reader)) {
+      case XML_READER_TYPE_END_ELEMENT:
+        if (xmlTextReaderDepth(reader) == depth)
+          return text;
+        break;
+
+      case XML_READER_TYPE_TEXT:
+      case XML_READER_TYPE_CDATA:
+      case XML_READER_TYPE_WHITESPACE:
+      case XML_READER_TYPE_SIGNIFICANT_WHITESPACE: {
+        const xmlChar *value = xmlTextReaderConstValue(reader);
+        if (value)
+          text.append((const char *)value);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  throw std::runtime_error("Could not parse XML data, unexpected end of document");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ValueRef internal::Unserializer::unserialize_xmlreader(xmlTextReaderPtr reader, std::string *doctype,
+                                                       std::string *docversion) {
+  ValueRef value;
+
+  // Objects cached by an earlier document may be replaced by ones in this document, so links to them
+  // can only be resolved at the end (as the DOM path would do it after its 1st pass).
+  _stream_fresh_cache = _cache.empty();
+  _streamed_objects.clear();
+  _pending_links.clear();
+  _pending_lists.clear();
+
+  try {
+    while (read_next_node(reader)) {
+      if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+        continue;
+
+      if (doctype && docversion) {
+        *doctype = reader_attribute(reader, "document_type");
+        *docversion = reader_attribute(reader, "version");
+      }
+
+      bool found = false;
+      for_each_child_element(reader, [&]() {
+        if (!found && reader_element_is(reader, "value")) {
+          PendingLink ignored;
+          value = stream_value(reader, ignored);
+          found = true;
+        } else
+          skip_element(reader);
+      });
+      patch_pending_links();
+
+      // Read the remaining nodes so that malformed documents are rejected as by the DOM parser.
+      while (read_next_node(reader))
+        ;
+      break;
+    }
+  } catch (...) {
+    _pending_links.clear();
+    _pending_lists.clear();
+    throw;
+  }
+
+  _streamed_objects.clear();
+
+  return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads only the document type and version from the root element of an XML document file, without reading
+ * the rest of it. Returns false if the file can't be read or has no root element.
+ */
+bool internal::Unserializer::read_xml_metainfo(const std::string &path, std::string &doctype,
+                                               std::string &docversion) {
+  if (!base::file_exists(path))
+    return false;
+
+  std::unique_ptr<xmlTextReader, void (*)(xmlTextReaderPtr)> reader(xmlReaderForFile(path.c_str(), NULL, 0),
+                                                                    xmlFreeTextReader);
+  if (!reader)
+    return false;
+
+  try {
+    while (read_next_node(reader.get())) {
+      if (xmlTextReaderNodeType(reader.get()) == XML_READER_TYPE_ELEMENT) {
+        doctype = reader_attribute(reader.get(), "document_type");
+        docversion = reader_attribute(reader.get(), "version");
+        return true;
+      }
+    }
+  } catch (std::exception &exc) {
+    logWarning("Could not read document info from %s: %s\n", path.c_str(), exc.what());
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the value or link element the reader is positioned on, including all its content.
+ * Links to objects not created yet are returned as a null value, with their id and location stored in forward_link
+ * for the caller to record where the value goes.
+ */
+ValueRef internal::Unserializer::stream_value(xmlTextReaderPtr reader, PendingLink &forward_link) {
+  int line = reader_line(reader);
+
+  if (reader_element_is(reader, "link")) {
+    std::string node_type = reader_attribute(reader, "type");
+    std::string struct_name = reader_attribute(reader, "struct-name");
+    std::string key = reader_attribute(reader, "key");
+    std::string link_id = read_element_text(reader);
+    ValueRef value = find_cached(link_id);
+
+    // lists and dicts can only be linked after they have been read
+    if (node_type.empty() || node_type != "object") {
+      if (!value.is_valid() && (_invalid_cache.find(link_id) == _invalid_cache.end()))
+        logWarning("%s: link of type '%s' could not be resolved during unserialized", _source_name.c_str(),
+                   node_type.c_str());
+      return value;
+    }
+
+    if (value.is_valid() && (_stream_fresh_cache || _streamed_objects.find(link_id) != _streamed_objects.end()))
+      return value;
+
+    forward_link.id = link_id;
+    forward_link.struct_name = struct_name;
+    forward_link.key = key;
+    forward_link.line = line;
+    return ValueRef();
+  } else if (!reader_element_is(reader, "value")) {
+    skip_element(reader);
+    return ValueRef();
+  }
+
+  std::string node_type = reader_attribute(reader, "type");
+  if (node_type.empty())
+    throw std::runtime_error(std::string("Node '")
+                               .append((const char *)xmlTextReaderConstLocalName(reader))
+                               .append("' in xml doesn't have a type property"));
+
+  ValueRef value;
+
+  switch (str_to_type(node_type)) {
+    case IntegerType:
+      value = IntegerRef((IntegerRef::storage_type)strtoll(read_element_text(reader).c_str(), NULL, 0));
+      break;
+
+    case DoubleType:
+      value = DoubleRef(base::atof<double>(read_element_text(reader)));
+      break;
+
+    case StringType:
+      value = StringRef(read_element_text(reader));
+      break;
+
+    case DictType: {
+      DictRef dict;
+
+      // check if the dictionary was already created
+      std::string ptr = reader_attribute(reader, "_ptr_");
+      if (!ptr.empty())
+        value = find_cached(ptr);
+
+      if (!value.is_valid()) {
+        std::string prop = reader_attribute(reader, "content-type");
+        if (!prop.empty()) {
+          Type content_type = str_to_type(prop);
+          if (content_type != UnknownType)
+            value = dict = DictRef(content_type, reader_attribute(reader, "content-struct-name"));
+          else
+            throw std::runtime_error("Error parsing XML. Invalid type " + prop);
+        } else
+          value = dict = DictRef(true);
+
+        if (!ptr.empty())
+          _cache[ptr] = value;
+      } else
+        dict = DictRef::cast_from(value);
+
+      for_each_child_element(reader, [&]() {
+        std::string key = reader_attribute(reader, "key");
+        if (key.empty()) {
+          skip_element(reader);
+          return;
+        }
+
+        PendingLink link;
+        ValueRef sub_value = stream_value(reader, link);
+        if (!link.id.empty()) {
+          link.dict = dict;
+          link.dict_key = key;
+          _pending_links.push_back(link);
+        } else
+          dict.set(key, sub_value);
+      });
+      break;
+    }
+
+    case ListType: {
+      Type content_type = str_to_type(reader_attribute(reader, "content-type"));
+      std::string cclass_name = reader_attribute(reader, "content-struct-name");
+      BaseListRef list;
+
+      std::string ptr = reader_attribute(reader, "_ptr_");
+      if (!ptr.empty()) {
+        // look up for this ptr, in case the owner object already has created this list
+        value = find_cached(ptr);
+        if (!value.is_valid()) {
+          value = list = BaseListRef(content_type, cclass_name);
+
+          _cache[ptr] = value;
+        } else
+          list = BaseListRef::cast_from(value);
+      } else
+        value = list = BaseListRef(content_type, cclass_name);
+
+      // Once an item links forward, it and all following items are inserted after the link was resolved.
+      PendingList *pending = nullptr;
+      bool skipping = false;
+      for_each_child_element(reader, [&]() {
+        PendingLink link;
+
+        if (skipping) {
+          // Objects in the skipped items still exist (and can be linked), as with the DOM 1st pass.
+          stream_value(reader, link);
+          return;
+        }
+
+        if (reader_element_is(reader, "null")) {
+          if (!list->null_allowed()) {
+            logWarning("%s: Attempt o add null value to %s list", _source_name.c_str(), cclass_name.c_str());
+          }
+          skip_element(reader);
+          if (pending)
+            pending->items.push_back(PendingListItem());
+          else
+            list.ginsert(ValueRef());
+          return;
+        }
+
+        std::string name = (const char *)xmlTextReaderConstLocalName(reader);
+        int line = reader_line(reader);
+        ValueRef sub_value = stream_value(reader, link);
+
+        if (!link.id.empty() || (pending && sub_value.is_valid())) {
+          if (!pending) {
+            _pending_lists.push_back(PendingList());
+            pending = &_pending_lists.back();
+            pending->list = list;
+          }
+          PendingListItem item;
+          item.value = sub_value;
+          item.link = link;
+          pending->items.push_back(item);
+        } else if (sub_value.is_valid())
+          insert_list_item(list, sub_value);
+        else {
+          // error!
+          logWarning("%s: skipping element '%s' in unserialized document, line %i", _source_name.c_str(),
+                     name.c_str(), line);
+          value.clear();
+          skipping = true;
+        }
+      });
+      break;
+    }
+
+    case ObjectType: {
+      // unserialize and initialize the object
+      ObjectRef object = allocate_object(reader_attribute(reader, "struct-name"), reader_attribute(reader, "id"),
+                                         reader_attribute(reader, "struct-checksum"), line);
+      _cache[object->id()] = object;
+      if (!_stream_fresh_cache)
+        _streamed_objects.insert(object->id());
+
+      stream_object_contents(object, reader);
+      value = object;
+      break;
+    }
+
+    case UnknownType:
+      skip_element(reader);
+      break;
+  }
+
+  return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Unserializer::stream_object_contents(const ObjectRef &object, xmlTextReaderPtr reader) {
+  for_each_child_element(reader, [&]() {
+    std::string key = reader_attribute(reader, "key");
+    if (key.empty()) {
+      skip_element(reader);
+      return;
+    }
+
+    PendingLink link;
+    if (!object->has_member(key)) {
+      logWarning("in %s: %s", object.id().c_str(),
+                 std::string("unserialized XML contains invalid member " + object.class_name() + "::" + key).c_str());
+      // Still read it, objects in there can be linked from elsewhere.
+      stream_value(reader, link);
+      return;
+    }
+
+    // if the value is a container that has already been created, cache it for reuse by stream_value
+    ValueRef sub_value = object->get_member(key);
+    if (sub_value.is_valid()) {
+      std::string ptr = reader_attribute(reader, "_ptr_");
+      if (!ptr.empty())
+        _cache[ptr] = sub_value;
+    }
+
+    try {
+      sub_value = stream_value(reader, link);
+    } catch (grt::null_value &exc) {
+      logWarning("%s in %s:%s %s", exc.what(), object->class_name().c_str(), key.c_str(), object->id().c_str());
+      throw;
+    }
+
+    if (!link.id.empty()) {
+      link.object = object;
+      link.member = key;
+      _pending_links.push_back(link);
+    } else if (sub_value.is_valid())
+      set_object_member(object, key, sub_value);
+  });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ValueRef internal::Unserializer::resolve_pending_link(const PendingLink &link) {
+  ValueRef value = find_cached(link.id);
+
+  if (!value.is_valid() && (_invalid_cache.find(link.id) == _invalid_cache.end())) {
+    value = find_external_object(link.id);
+
+    if (!value.is_valid())
+      logWarning("%s:%i: link '%s' <object %s> key=%s could not be resolved\n", _source_name.c_str(), link.line,
+                 link.id.c_str(), link.struct_name.c_str(), link.key.c_str());
+  }
+
+  return value;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::Unserializer::patch_pending_links() {
+  if (!_pending_links.empty() || !_pending_lists.empty())
+    logDebug3("%s: patching %i forward links and %i lists\n", _source_name.c_str(), (int)_pending_links.size(),
+              (int)_pending_lists.size());
+
+  for (auto &link : _pending_links) {
+    ValueRef value = resolve_pending_link(link);
+
+    if (link.object.is_valid()) {
+      if (value.is_valid())
+        set_object_member(link.object, link.member, value);
+    } else
+      link.dict.set(link.dict_key, value);
+  }
+  _pending_links.clear();
+
+  for (auto &pending : _pending_lists) {
+    for (auto &item : pending.items) {
+      ValueRef value = item.value;
+
+      if (!item.link.id.empty()) {
+        value = resolve_pending_link(item.link);
+        if (!value.is_valid()) {
+          logWarning("%s: skipping element 'link' in unserialized document, line %i", _source_name.c_str(),
+                     item.link.line);
+          break;
+        }
+      }
+      insert_list_item(pending.list, value);
+    }
+  }
+  _pending_lists.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ValueRef internal::Unserializer::unserialize_xmldata(const char *data, size_t size) {
+  std::unique_ptr<xmlTextReader, void (*)(xmlTextReaderPtr)> reader(
+    xmlReaderForMemory(data, (int)size, NULL, NULL, XML_PARSE_NOENT), xmlFreeTextReader);
+
+  if (!reader)
+    throw std::runtime_error("Could not parse XML data");
+
+  _source_name = "";
+
+  return unserialize_xmlreader(reader.get(), NULL, NULL);
+}
+
+//----------------- BinaryUnserializer -------------------------------------------------------------
+
+typedef std::map<uint64_t, std::pair<uint64_t, uint64_t> > BinarySectionIndex;
+
+static uint64_t decode_varint(const unsigned char *&pos, const unsigned char *end) {
+  uint64_t value = 0;
+
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (pos >= end)
+      throw std::runtime_error("Invalid binary GRT data (unexpected end of data)");
+
+    unsigned char byte = *pos++;
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return value;
+  }
+  throw std::runtime_error("Invalid binary GRT data (bad number)");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Checks the format version and reads the section index of a binary document.
+ * Returns the start of the section data, which section offsets are relative to.
+ */
+static const unsigned char *parse_binary_index(const unsigned char *data, size_t size, BinarySectionIndex &sections) {
+  const unsigned char *pos = data;
+  const unsigned char *end = data + size;
+
+  if (size < 6 || memcmp(data, GRT_BINARY_MAGIC, 4) != 0)
+    throw std::runtime_error("Data is not a binary GRT document");
+
+  if (data[4] != GRT_BINARY_FORMAT_MAJOR)
+    throw std::runtime_error(base::strfmt("Unsupported binary GRT document format %i.%i", data[4], data[5]));
+  pos += 6;
+
+  for (uint64_t count = decode_varint(pos, end); count > 0; --count) {
+    uint64_t id = decode_varint(pos, end);
+    uint64_t offset = decode_varint(pos, end);
+    sections[id] = std::make_pair(offset, decode_varint(pos, end));
+  }
+  return pos;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+internal::BinaryUnserializer::BinaryUnserializer(bool check_crc)
+  : Unserializer(check_crc), _data(NULL), _pos(NULL), _end(NULL) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads only the meta info (document type and version, checksum of the document it was saved with) from
+ * a binary document file. Returns false if the file isn't a binary document in a supported format.
+ */
+bool internal::BinaryUnserializer::read_metainfo(const std::string &path, std::string &doctype,
+                                                 std::string &docversion, std::string &source_checksum) {
+  FILE *file = base_fopen(path.c_str(), "rb");
+  if (file == NULL)
+    return false;
+
+  bool result = false;
+  try {
+    // The index and the meta section are written first and are small.
+    std::vector<unsigned char> buffer(4096);
+    buffer.resize(fread(buffer.data(), 1, buffer.size(), file));
+
+    BinarySectionIndex sections;
+    const unsigned char *start = parse_binary_index(buffer.data(), buffer.size(), sections);
+    BinarySectionIndex::const_iterator meta = sections.find(binary_format::MetaSection);
+
+    if (meta != sections.end()) {
+      size_t offset = (start - buffer.data()) + meta->second.first;
+      std::vector<unsigned char> data(meta->second.second);
+
+      if (fseek(file, (long)offset, SEEK_SET) == 0 && fread(data.data(), 1, data.size(), file) == data.size()) {
+        const unsigned char *pos = data.data();
+        const unsigned char *end = pos + data.size();
+        std::string *fields[] = {&doctype, &docversion, &source_checksum};
+
+        for (std::string *field : fields) {
+          uint64_t length = decode_varint(pos, end);
+          if (length > (uint64_t)(end - pos))
+            throw std::runtime_error("Invalid binary GRT data (unexpected end of data)");
+          field->assign((const char *)pos, (size_t)length);
+          pos += length;
+        }
+        result = true;
+      }
+    }
+  } catch (const std::exception &exc) {
+    logDebug("Could not read binary GRT document info from %s: %s\n", path.c_str(), exc.what());
+  }
+  fclose(file);
+
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ValueRef internal::BinaryUnserializer::load_from_file(const std::string &path, std::string *doctype,
+                                                      std::string *docversion, std::string *source_checksum) {
+  gchar *data;
+  gsize length;
+  GError *error = NULL;
+
+  if (!g_file_get_contents(path.c_str(), &data, &length, &error)) {
+    std::string message = error ? error->message : "unknown error";
+    g_error_free(error);
+    throw std::runtime_error("Could not read binary GRT document " + path + ": " + message);
+  }
+
+  _source_name = path;
+
+  ValueRef value;
+  try {
+    value = unserialize_data(data, length, doctype, docversion, source_checksum);
+  } catch (...) {
+    g_free(data);
+    throw;
+  }
+  g_free(data);
+
+  return value;
+}
 
-  ValueRef value = unserialize_xmldoc(doc);
+//--------------------------------------------------------------------------------------------------
+
+ValueRef internal::BinaryUnserializer::unserialize_data(const char *data, size_t size, std::string *doctype,
+                                                        std::string *docversion, std::string *source_checksum) {
+  BinarySectionIndex sections;
+  const unsigned char *start = parse_binary_index((const unsigned char *)data, size, sections);
+  const unsigned char *end = (const unsigned char *)data + size;
+
+  // Positions the reader on the given section.
+  auto select_section = [&](binary_format::Section id) {
+    BinarySectionIndex::const_iterator section = sections.find(id);
+    if (section == sections.end())
+      throw std::runtime_error("Invalid binary GRT data (missing section)");
+
+    uint64_t available = end - start;
+    if (section->second.first > available || section->second.second > available - section->second.first)
+      throw std::runtime_error("Invalid binary GRT data (section out of bounds)");
+
+    _pos = start + section->second.first;
+    _end = _pos + section->second.second;
+  };
+
+  _data = start;
+
+  select_section(binary_format::MetaSection);
+  std::string type = read_string();
+  std::string version = read_string();
+  std::string checksum = read_string();
+  if (doctype)
+    *doctype = type;
+  if (docversion)
+    *docversion = version;
+  if (source_checksum)
+    *source_checksum = checksum;
+
+  select_section(binary_format::StringsSection);
+  uint64_t count = read_varint();
+  if (count > (uint64_t)(_end - _pos))
+    throw std::runtime_error("Invalid binary GRT data (bad string count)");
+  _strings.clear();
+  _strings.reserve((size_t)count);
+  while (count-- > 0)
+    _strings.push_back(read_string());
+
+  select_section(binary_format::ValuesSection);
+  _stream_fresh_cache = _cache.empty();
+  _streamed_objects.clear();
+  _pending_links.clear();
+  _pending_lists.clear();
+  _containers.clear();
 
-  xmlFreeDoc(doc);
+  ValueRef value;
+  try {
+    PendingLink ignored;
+    value = read_value(ValueRef(), ignored);
+    patch_pending_links();
+  } catch (...) {
+    _pending_links.clear();
+    _pending_lists.clear();
+    _containers.clear();
+    throw;
+  }
+
+  _strings.clear();
+  _containers.clear();
+  _streamed_objects.clear();
 
   return value;
 }
+
+//--------------------------------------------------------------------------------------------------
+
+uint64_t internal::BinaryUnserializer::read_varint() {
+  return decode_varint(_pos, _end);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string internal::BinaryUnserializer::read_string() {
+  uint64_t length = read_varint();
+  if (length > (uint64_t)(_end - _pos))
+    throw std::runtime_error("Invalid binary GRT data (unexpected end of data)");
+
+  std::string s((const char *)_pos, (size_t)length);
+  _pos += length;
+  return s;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const std::string &internal::BinaryUnserializer::string_at(uint64_t index) {
+  if (index >= _strings.size())
+    throw std::runtime_error("Invalid binary GRT data (bad string reference)");
+  return _strings[(size_t)index];
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the value at the current position. If container is a list or dict and the value is one too, its content
+ * is read into container (used for the containers objects create for their members).
+ */
+ValueRef internal::BinaryUnserializer::read_value(const ValueRef &container, PendingLink &forward_link) {
+  using namespace binary_format;
+
+  int offset = (int)(_pos - _data);
+  if (_pos >= _end)
+    throw std::runtime_error("Invalid binary GRT data (unexpected end of data)");
+
+  switch (*_pos++) {
+    case NullTag:
+      return ValueRef();
+
+    case IntegerTag: {
+      uint64_t v = read_varint();
+      return IntegerRef((IntegerRef::storage_type)(int64_t)((v >> 1) ^ (~(v & 1) + 1)));
+    }
+
+    case DoubleTag: {
+      if (_end - _pos < 8)
+        throw std::runtime_error("Invalid binary GRT data (unexpected end of data)");
+
+      uint64_t bits = 0;
+      for (int i = 7; i >= 0; i--)
+        bits = (bits << 8) | _pos[i];
+      _pos += 8;
+
+      double d;
+      memcpy(&d, &bits, sizeof(d));
+      return DoubleRef(d);
+    }
+
+    case StringTag:
+      return StringRef(read_string());
+
+    case ListTag: {
+      if (_pos >= _end || *_pos > ObjectType)
+        throw std::runtime_error("Invalid binary GRT data (bad list type)");
+      Type content_type = (Type)*_pos++;
+      uint64_t cclass = read_varint();
+
+      BaseListRef list;
+      if (container.is_valid() && container.type() == ListType)
+        list = BaseListRef::cast_from(container);
+      else
+        list = BaseListRef(content_type, cclass == 0 ? "" : string_at(cclass - 1));
+      _containers.push_back(list);
+
+      ValueRef value(list);
+      read_list_items(list, value);
+      return value;
+    }
+
+    case DictTag: {
+      DictRef dict;
+      if (container.is_valid() && container.type() == DictType)
+        dict = DictRef::cast_from(container);
+      else
+        dict = DictRef(true);
+      _containers.push_back(dict);
+
+      for (uint64_t key = read_varint(); key != 0; key = read_varint()) {
+        const std::string &name = string_at(key - 1);
+        PendingLink link;
+
+        ValueRef sub_value = read_value(ValueRef(), link);
+        if (!link.id.empty()) {
+          link.key = name;
+          link.dict = dict;
+          link.dict_key = name;
+          _pending_links.push_back(link);
+        } else
+          dict.set(name, sub_value);
+      }
+      return dict;
+    }
+
+    case ObjectTag: {
+      const std::string &struct_name = string_at(read_varint());
+      const std::string &id = string_at(read_varint());
+      unsigned int checksum = (unsigned int)read_varint();
+
+      ObjectRef object = allocate_object(struct_name, id, base::strfmt("0x%x", checksum), offset);
+      _cache[id] = object;
+      if (!_stream_fresh_cache)
+        _streamed_objects.insert(id);
+
+      read_object_contents(object);
+      return object;
+    }
+
+    case ObjectLinkTag: {
+      const std::string &id = string_at(read_varint());
+      uint64_t struct_name = read_varint();
+
+      ValueRef value = find_cached(id);
+      if (value.is_valid() && (_stream_fresh_cache || _streamed_objects.find(id) != _streamed_objects.end()))
+        return value;
+
+      forward_link.id = id;
+      forward_link.struct_name = struct_name == 0 ? "" : string_at(struct_name - 1);
+      forward_link.line = offset;
+      return ValueRef();
+    }
+
+    case ListLinkTag:
+    case DictLinkTag: {
+      Type type = _pos[-1] == ListLinkTag ? ListType : DictType;
+      uint64_t index = read_varint();
+
+      if (index < _containers.size() && _containers[(size_t)index].type() == type)
+        return _containers[(size_t)index];
+
+      logWarning("%s: link of type '%s' could not be resolved during unserialized", _source_name.c_str(),
+                 type_to_str(type).c_str());
+      return ValueRef();
+    }
+
+    default:
+      throw std::runtime_error(base::strfmt("Invalid binary GRT data (unknown value type at %i)", offset));
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::BinaryUnserializer::read_list_items(BaseListRef &list, ValueRef &value) {
+  // Once an item links forward, it and all following items are inserted after the link was resolved.
+  PendingList *pending = nullptr;
+  bool skipping = false;
+
+  for (uint64_t count = read_varint(); count > 0; --count) {
+    PendingLink link;
+
+    if (skipping) {
+      // Objects in the skipped items still exist (and can be linked).
+      read_value(ValueRef(), link);
+      continue;
+    }
+
+    if (_pos < _end && *_pos == binary_format::NullTag) {
+      ++_pos;
+      if (!list->null_allowed()) {
+        logWarning("%s: Attempt o add null value to %s list", _source_name.c_str(),
+                   list.content_class_name().c_str());
+      }
+      if (pending)
+        pending->items.push_back(PendingListItem());
+      else
+        list.ginsert(ValueRef());
+      continue;
+    }
+
+    int offset = (int)(_pos - _data);
+    ValueRef sub_value = read_value(ValueRef(), link);
+
+    if (!link.id.empty() || (pending && sub_value.is_valid())) {
+      if (!pending) {
+        _pending_lists.push_back(PendingList());
+        pending = &_pending_lists.back();
+        pending->list = list;
+      }
+      PendingListItem item;
+      item.value = sub_value;
+      item.link = link;
+      pending->items.push_back(item);
+    } else if (sub_value.is_valid())
+      insert_list_item(list, sub_value);
+    else {
+      logWarning("%s: skipping list item in unserialized document, offset %i", _source_name.c_str(), offset);
+      value.clear();
+      skipping = true;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void internal::BinaryUnserializer::read_object_contents(const ObjectRef &object) {
+  for (uint64_t member = read_varint(); member != 0; member = read_varint()) {
+    const std::string &key = string_at(member - 1);
+    PendingLink link;
+
+    if (!object->has_member(key)) {
+      logWarning("in %s: %s", object.id().c_str(),
+                 std::string("unserialized data contains invalid member " + object.class_name() + "::" + key).c_str());
+      read_value(ValueRef(), link);
+      continue;
+    }
+
+    ValueRef sub_value;
+    try {
+      sub_value = read_value(object->get_member(key), link);
+    } catch (grt::null_value &exc) {
+      logWarning("%s in %s:%s %s", exc.what(), object->class_name().c_str(), key.c_str(), object->id().c_str());
+      throw;
+    }
+
+    if (!link.id.empty()) {
+      link.key = key;
+      link.object = object;
+      link.member = key;
+      _pending_links.push_back(link);
+    } else if (sub_value.is_valid())
+      set_object_member(object, key, sub_value);
+  }
+}
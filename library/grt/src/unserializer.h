@@ -25,6 +25,10 @@
 
 #include "grt.h"
 #include <set>
+#include <list>
+#include <stdint.h>
+
+#include <libxml/xmlreader.h>
 
 namespace grt {
   namespace internal {
@@ -38,12 +42,44 @@ namespace grt {
 
       ValueRef unserialize_xmldata(const char *data, size_t size);
 
+      static bool read_xml_metainfo(const std::string &path, std::string &doctype, std::string &docversion);
+
     protected:
+      // A link to an object that was not yet created when it was read by the streaming reader.
+      // It is either placed in an object member, a dict entry or a (pending) list.
+      struct PendingLink {
+        std::string id;
+        std::string struct_name;
+        std::string key;
+        int line = 0;
+
+        ObjectRef object;
+        std::string member;
+        DictRef dict;
+        std::string dict_key;
+      };
+
+      // List items following a forward link, which are inserted once the link could be resolved.
+      struct PendingListItem {
+        ValueRef value;
+        PendingLink link;
+      };
+
+      struct PendingList {
+        BaseListRef list;
+        std::vector<PendingListItem> items;
+      };
+
       std::string _source_name;
       std::map<std::string, ValueRef> _cache;
       std::set<std::string> _invalid_cache;
       bool _check_serialized_crc;
 
+      std::vector<PendingLink> _pending_links;
+      std::list<PendingList> _pending_lists;
+      bool _stream_fresh_cache = true;
+      std::set<std::string> _streamed_objects;
+
       ValueRef unserialize_from_xml(xmlNodePtr node);
       ValueRef traverse_xml_recreating_tree(xmlNodePtr node);
       void traverse_xml_creating_objects(xmlNodePtr node);
@@ -52,6 +88,50 @@ namespace grt {
       ObjectRef unserialize_object_step2(xmlNodePtr node);
       void unserialize_object_contents(const ObjectRef &object, xmlNodePtr node);
       ValueRef find_cached(const std::string &id);
+
+      ObjectRef allocate_object(const std::string &struct_name, const std::string &id, const std::string &checksum,
+                                int line);
+      ObjectRef find_external_object(const std::string &id);
+      void set_object_member(const ObjectRef &object, const std::string &key, const ValueRef &value);
+      void insert_list_item(BaseListRef &list, const ValueRef &value);
+
+      ValueRef unserialize_xmlreader(xmlTextReaderPtr reader, std::string *doctype, std::string *docversion);
+      ValueRef stream_value(xmlTextReaderPtr reader, PendingLink &forward_link);
+      void stream_object_contents(const ObjectRef &object, xmlTextReaderPtr reader);
+      ValueRef resolve_pending_link(const PendingLink &link);
+      void patch_pending_links();
+    };
+
+    /**
+     * Reads documents in the binary format written by BinarySerializer. Objects, links and containers
+     * are resolved as by the (streaming) XML unserializer.
+     */
+    class BinaryUnserializer : public Unserializer {
+    public:
+      BinaryUnserializer(bool check_crc);
+
+      ValueRef load_from_file(const std::string &path, std::string *doctype = 0, std::string *docversion = 0,
+                              std::string *source_checksum = 0);
+
+      ValueRef unserialize_data(const char *data, size_t size, std::string *doctype = 0, std::string *docversion = 0,
+                                std::string *source_checksum = 0);
+
+      static bool read_metainfo(const std::string &path, std::string &doctype, std::string &docversion,
+                                std::string &source_checksum);
+
+    protected:
+      const unsigned char *_data;
+      const unsigned char *_pos;
+      const unsigned char *_end;
+      std::vector<std::string> _strings;
+      std::vector<ValueRef> _containers;
+
+      uint64_t read_varint();
+      std::string read_string();
+      const std::string &string_at(uint64_t index);
+      ValueRef read_value(const ValueRef &container, PendingLink &forward_link);
+      void read_object_contents(const ObjectRef &object);
+      void read_list_items(BaseListRef &list, ValueRef &value);
     };
   };
 };
@@ -33,6 +33,7 @@
 #include "synthetic_mysql_model.h"
 #include "module_db_mysql.h"
 #include "backend/diff_tree.h"
+#include "diff_test_utility.h"
 
 using namespace grt;
 
@@ -362,9 +363,74 @@ TEST_FUNCTION(10) {
   ensure("10.2 Routine definer, wasn't different", change2.get() != NULL);
 }
 
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Exposes the number of names with rules, to check that comparisons don't add any.
+ */
+class rule_counting_comparer : public grt::NormalizedComparer {
+public:
+  rule_counting_comparer(const grt::DictRef options) : grt::NormalizedComparer(options) {
+  }
+  size_t rule_name_count() const {
+    return rules.size();
+  }
+};
+
+static db_mysql_CatalogRef create_catalog(bool modified) {
+  db_mysql_CatalogRef catalog(grt::Initialized);
+  for (size_t i = 0; i < 8; ++i) {
+    db_mysql_SchemaRef schema(grt::Initialized);
+    schema->owner(catalog);
+    schema->name("schema" + std::to_string(i));
+    for (size_t j = 0; j < 16; ++j) {
+      db_mysql_TableRef table(grt::Initialized);
+      table->owner(schema);
+      table->name("table" + std::to_string(j));
+      // Only differs in case, which the normalizer ignores in caseless mode.
+      table->comment(modified && j % 2 == 0 ? "SOME COMMENT" : "some comment");
+      for (size_t k = 0; k < 8; ++k) {
+        db_mysql_ColumnRef column(grt::Initialized);
+        column->owner(table);
+        column->name("column" + std::to_string(k));
+        column->defaultValue(modified && (i + j + k) % 11 == 0 ? "1" : "0");
+        table->columns().insert(column);
+      }
+      schema->tables().insert(table);
+    }
+    catalog->schemata().insert(schema);
+  }
+  return catalog;
+}
+
+// The normalizer is called from all diff threads, so it must neither change its rules nor give other results.
+TEST_FUNCTION(11) {
+  db_mysql_CatalogRef source = create_catalog(false);
+  db_mysql_CatalogRef target = create_catalog(true);
+
+  grt::DbObjectMatchAlterOmf omf;
+  rule_counting_comparer normalizer(get_traits(false));
+  normalizer.init_omf(&omf);
+  size_t rule_names = normalizer.rule_name_count();
+
+  omf.diff_threads = 0;
+  std::shared_ptr<DiffChange> change = diff_make(source, target, &omf);
+  ensure("11.1 Default value changes expected", change.get() != NULL);
+  std::string expected = dump_change(change);
+
+  omf.diff_threads = 4;
+  omf.parallel_list_depths = {1, 2};
+  for (size_t i = 0; i < 5; ++i) {
+    change = diff_make(source, target, &omf);
+    ensure("11.2 Default value changes expected", change.get() != NULL);
+    ensure_equals("11.3 Parallel diff differs", dump_change(change), expected);
+  }
+  ensure_equals("11.4 Comparison rules changed", normalizer.rule_name_count(), rule_names);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
-TEST_FUNCTION(11) {
+TEST_FUNCTION(12) {
   delete tester;
 }
 
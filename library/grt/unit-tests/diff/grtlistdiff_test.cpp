@@ -29,6 +29,11 @@
 #include "diff/changeobjects.h"
 #include "diff/changelistobjects.h"
 #include "grtdb/diff_dbobjectmatch.h"
+#include "structs.test.h"
+#include "diff_test_utility.h"
+
+#include <random>
+#include <sstream>
 
 using namespace grt;
 
@@ -250,4 +255,265 @@ TEST_FUNCTION(2) {
   assure_grt_values_equal(source, target);
 }
 
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Matches strings case insensitively (which creates duplicates in lists), with or without a hash.
+ */
+struct caseless_omf : public Omf {
+  bool use_hash;
+  caseless_omf(bool use_hash) : use_hash(use_hash) {
+  }
+
+  virtual bool less(const ValueRef& l, const ValueRef& r) const {
+    return base::tolower(*StringRef::cast_from(l)) < base::tolower(*StringRef::cast_from(r));
+  }
+  virtual bool equal(const ValueRef& l, const ValueRef& r) const {
+    return base::tolower(*StringRef::cast_from(l)) == base::tolower(*StringRef::cast_from(r));
+  }
+  virtual size_t hash(const ValueRef& value) const {
+    return use_hash ? std::hash<std::string>()(base::tolower(*StringRef::cast_from(value))) : 0;
+  }
+};
+
+/**
+ * The list diff as it was before matching was done via hashes (comparing all pairs of items).
+ * Used as reference for the current implementation. Returns the changes in the order of the change set.
+ */
+static std::vector<std::shared_ptr<ListItemChange> > reference_list_diff(const BaseListRef& source,
+                                                                         const BaseListRef& target, const Omf* omf) {
+  auto find = [omf](const BaseListRef& list, size_t limit, const ValueRef& value) {
+    for (size_t i = 0; i < limit; ++i)
+      if (omf->equal(list[i], value))
+        return i;
+    return (size_t)BaseListRef::npos;
+  };
+
+  // Longest increasing subsequence, in reversed order.
+  auto reversed_lis = [](const std::vector<size_t>& src, std::vector<size_t>& res) {
+    std::vector<size_t> history(src.size(), std::string::npos);
+    std::map<size_t, size_t> tails;
+    for (size_t i = 0; i < src.size(); ++i) {
+      auto added = tails.insert(std::make_pair(src[i], i)).first;
+      if (added != tails.begin()) {
+        history[i] = (--added)->second;
+        ++added;
+      }
+      if (++added != tails.end())
+        tails.erase(added);
+    }
+    if (tails.empty())
+      return;
+    size_t j = (--tails.end())->second;
+    do {
+      res.push_back(src[j]);
+    } while ((j = history[j]) != std::string::npos);
+  };
+
+  std::vector<std::shared_ptr<ListItemChange> > changes;
+  std::vector<size_t> source_indexes, ordered_indexes;
+  ValueRef prev_value;
+  for (size_t i = 0; i < target.count(); ++i) {
+    if (find(target, i, target[i]) != BaseListRef::npos)
+      continue;
+    size_t index = find(source, source.count(), target[i]);
+    if (index == BaseListRef::npos)
+      changes.push_back(std::shared_ptr<ListItemChange>(new ListItemAddedChange(target[i], prev_value, i)));
+    else
+      source_indexes.push_back(source.get_index(source[index]));
+    prev_value = target[i];
+  }
+
+  for (size_t i = 0; i < source.count(); ++i) {
+    if (find(source, i, source[i]) != BaseListRef::npos)
+      continue;
+    if (find(target, target.count(), source[i]) == BaseListRef::npos)
+      changes.push_back(std::shared_ptr<ListItemChange>(new ListItemRemovedChange(source[i], i)));
+    else
+      ordered_indexes.push_back(i);
+  }
+
+  std::vector<size_t> stable_elements;
+  reversed_lis(source_indexes, stable_elements);
+  std::vector<size_t> moved_elements(source_indexes.size() - stable_elements.size());
+  std::set_difference(ordered_indexes.begin(), ordered_indexes.end(), stable_elements.rbegin(),
+                      stable_elements.rend(), moved_elements.begin());
+  for (size_t moved : moved_elements) {
+    size_t index = target.get_index(target[find(target, target.count(), source[moved])]);
+    changes.push_back(std::shared_ptr<ListItemChange>(new ListItemOrderChange(
+      source[moved], target[index], omf, index == 0 ? ValueRef() : target[index - 1], index)));
+  }
+
+  for (size_t stable : stable_elements) {
+    size_t index = find(target, target.count(), source[stable]);
+    if (index != BaseListRef::npos) {
+      index = target.get_index(target[index]);
+      std::shared_ptr<ListItemChange> change = create_item_modified_change(source[stable], target[index], omf, index);
+      if (change)
+        changes.push_back(change);
+    }
+  }
+
+  std::sort(changes.begin(), changes.end(), [](const std::shared_ptr<ListItemChange>& a,
+                                               const std::shared_ptr<ListItemChange>& b) {
+    if (a->get_change_type() == ListItemRemoved)
+      return b->get_change_type() == ListItemRemoved && a->get_index() > b->get_index();
+    return b->get_change_type() == ListItemRemoved || a->get_index() < b->get_index();
+  });
+  return changes;
+}
+
+/**
+ * Describes a list item change by its type, index and the identity of the values it refers to.
+ */
+static std::string describe_change(const DiffChange* change) {
+  std::ostringstream description;
+  description << change->get_change_type() << " " << static_cast<const ListItemChange*>(change)->get_index();
+  switch (change->get_change_type()) {
+    case ListItemAdded: {
+      auto added = static_cast<const ListItemAddedChange*>(change);
+      description << " " << added->get_value().valueptr() << " " << added->get_prev_item().valueptr();
+      break;
+    }
+    case ListItemRemoved:
+      description << " " << static_cast<const ListItemRemovedChange*>(change)->get_value().valueptr();
+      break;
+    case ListItemModified: {
+      auto modified = static_cast<const ListItemModifiedChange*>(change);
+      description << " " << modified->get_old_value().valueptr() << " " << modified->get_new_value().valueptr();
+      break;
+    }
+    case ListItemOrderChanged: {
+      auto moved = static_cast<const ListItemOrderChange*>(change);
+      description << " " << moved->get_old_value().valueptr() << " " << moved->get_new_value().valueptr() << " "
+                  << moved->get_prev_item().valueptr() << " " << (moved->get_subchange() ? 1 : 0);
+      break;
+    }
+    default:
+      break;
+  }
+  return description.str();
+}
+
+// Hash based matching of list items must give exactly the same changes as comparing all pairs.
+TEST_FUNCTION(3) {
+  std::mt19937 random(4711);
+  default_omf omf;
+  caseless_omf caseless(true);
+  caseless_omf caseless_unhashed(false);
+  const Omf* omfs[] = { &omf, &caseless, &caseless_unhashed };
+
+  for (size_t run = 0; run < 2000; ++run) {
+    size_t range = 1 + random() % 30;
+    auto new_value = [&]() {
+      std::string value = std::string(1, 'a' + random() % range % 26) + std::to_string(random() % range / 26);
+      if (random() % 2)
+        value[0] = toupper(value[0]);
+      return StringRef(value);
+    };
+
+    // Target items are either items from the source (same value object) or new ones (possibly equal by value).
+    StringListRef source(grt::Initialized);
+    StringListRef target(grt::Initialized);
+    for (size_t i = random() % 25; i > 0; --i)
+      source.ginsert(new_value());
+    for (size_t i = random() % 25; i > 0; --i) {
+      if (source.count() > 0 && random() % 3 != 0)
+        target.ginsert(source[random() % source.count()]);
+      else
+        target.ginsert(new_value());
+    }
+
+    const Omf* comparer = omfs[run % 3];
+    std::vector<std::shared_ptr<ListItemChange> > expected = reference_list_diff(source, target, comparer);
+    std::shared_ptr<MultiChange> change = GrtListDiff::diff(source, target, comparer);
+
+    if (!change) {
+      ensure_equals("Unexpected changes", expected.size(), 0U);
+      continue;
+    }
+
+    const ChangeSet* changes = change->subchanges();
+    ensure_equals("Change count differs", changes->changes.size(), expected.size());
+    size_t i = 0;
+    for (ChangeSet::const_iterator iterator = changes->begin(); iterator != changes->end(); ++iterator, ++i)
+      ensure_equals("Change differs", describe_change(iterator->get()), describe_change(expected[i].get()));
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Matches the test objects by name (or by title for publications).
+ */
+struct test_object_omf : public Omf {
+  static std::string key(const ValueRef& value) {
+    ObjectRef object = ObjectRef::cast_from(value);
+    return object.has_member("title") ? object.get_string_member("title") : object.get_string_member("name");
+  }
+
+  virtual bool less(const ValueRef& l, const ValueRef& r) const {
+    if (l.type() == ObjectType && r.type() == ObjectType)
+      return key(l) < key(r);
+    return l < r;
+  }
+  virtual bool equal(const ValueRef& l, const ValueRef& r) const {
+    if (l.type() == ObjectType && r.type() == ObjectType)
+      return key(l) == key(r);
+    return l == r;
+  }
+  virtual size_t hash(const ValueRef& value) const {
+    return value.type() == ObjectType ? std::hash<std::string>()(key(value)) : value_hash(value);
+  }
+};
+
+// Diffing list items in parallel must give the same changes as diffing them one after the other.
+TEST_FUNCTION(4) {
+  grt::GRT::get()->load_metaclasses("data/structs.test.xml");
+  grt::GRT::get()->end_loading_metaclasses();
+
+  ListRef<test_Publisher> source(grt::Initialized);
+  ListRef<test_Publisher> target(grt::Initialized);
+  for (size_t i = 0; i < 30; ++i) {
+    test_PublisherRef publisher(grt::Initialized);
+    publisher->name("publisher " + std::to_string(i));
+    for (size_t j = 0; j < 20; ++j) {
+      test_BookRef book(grt::Initialized);
+      book->title("book " + std::to_string(j));
+      book->pages(j);
+      for (size_t k = 0; k < 5; ++k) {
+        test_AuthorRef author(grt::Initialized);
+        author->name("author " + std::to_string(k));
+        book->authors().insert(author);
+      }
+      publisher->books().insert(book);
+    }
+    source.insert(publisher);
+
+    test_PublisherRef copy = grt::copy_object(publisher);
+    if (i % 3 == 0)
+      copy->books()[i % 20]->pages(1000);
+    if (i % 4 == 0)
+      copy->books().remove(i % 20);
+    if (i % 5 == 0)
+      copy->books()[0]->authors()[i % 5]->name("somebody else");
+    if (i % 7 == 0)
+      copy->books().reorder(0, 10);
+    target.insert(copy);
+  }
+
+  test_object_omf omf;
+  std::shared_ptr<DiffChange> change = diff_make(source, target, &omf);
+  ensure("Changes expected", change.get() != nullptr);
+  std::string expected = dump_change(change);
+
+  omf.diff_threads = 4;
+  omf.parallel_list_depths = {1, 2};
+  for (size_t i = 0; i < 5; ++i) {
+    change = diff_make(source, target, &omf);
+    ensure("Changes expected", change.get() != nullptr);
+    ensure_equals("Parallel diff differs", dump_change(change), expected);
+  }
+}
+
 END_TESTS
@@ -26,6 +26,12 @@
 #include "structs.test.h"
 #include "grtdb/db_object_helpers.h"
 #include "grts/structs.db.mysql.h"
+#include "serializer.h"
+#include "unserializer.h"
+
+#include <cstring>
+#include <fstream>
+#include <libxml/parser.h>
 
 BEGIN_TEST_DATA_CLASS(grtpp_serialization_test)
 public:
@@ -173,6 +179,200 @@ TEST_FUNCTION(5) {
   ensure("list[2]", list[2].is_valid());
 }
 
+// Objects are linked before they appear in the document. The streaming unserializer has to patch these links
+// at the end and give the same result as the DOM based one.
+static const char *forward_links_xml =
+  "<?xml version=\"1.0\"?>\n"
+  "<data grt_format=\"2.0\" document_type=\"test\" version=\"1.2\">\n"
+  "  <value type=\"list\" content-type=\"object\">\n"
+  "    <value type=\"object\" struct-name=\"test.Book\" id=\"book1\">\n"
+  "      <value type=\"string\" key=\"title\">book &amp; more</value>\n"
+  "      <link type=\"object\" struct-name=\"test.Publisher\" key=\"publisher\">publisher1</link>\n"
+  "      <value _ptr_=\"0x1\" type=\"list\" content-type=\"object\" content-struct-name=\"test.Author\" "
+  "key=\"authors\">\n"
+  "        <link type=\"object\">author1</link>\n"
+  "        <value type=\"object\" struct-name=\"test.Author\" id=\"author2\">\n"
+  "          <value type=\"string\" key=\"name\">author2</value>\n"
+  "        </value>\n"
+  "        <link type=\"object\">unknown</link>\n"
+  "        <link type=\"object\">author1</link>\n"
+  "      </value>\n"
+  "      <value _ptr_=\"0x2\" type=\"dict\" key=\"extras\">\n"
+  "        <link type=\"object\" key=\"publisher\">publisher1</link>\n"
+  "        <link type=\"object\" key=\"unknown\">unknown</link>\n"
+  "        <value type=\"int\" key=\"count\">42</value>\n"
+  "      </value>\n"
+  "    </value>\n"
+  "    <value type=\"object\" struct-name=\"test.Publisher\" id=\"publisher1\">\n"
+  "      <value type=\"string\" key=\"name\">publisher</value>\n"
+  "    </value>\n"
+  "    <value type=\"object\" struct-name=\"test.Author\" id=\"author1\">\n"
+  "      <value type=\"string\" key=\"name\">author1</value>\n"
+  "    </value>\n"
+  "  </value>\n"
+  "</data>\n";
+
+static void check_forward_links(const std::string &message, const ValueRef &value) {
+  ObjectListRef list(ObjectListRef::cast_from(value));
+  ensure_equals(message + ": list size", list.count(), 3U);
+
+  test_BookRef book(test_BookRef::cast_from(list[0]));
+  test_PublisherRef publisher(test_PublisherRef::cast_from(list[1]));
+  test_AuthorRef author(test_AuthorRef::cast_from(list[2]));
+
+  ensure_equals(message + ": title", *book->title(), "book & more");
+  ensure(message + ": publisher", book->publisher() == publisher);
+  ensure_equals(message + ": publisher name", *publisher->name(), "publisher");
+
+  // An unresolvable link ends the list, like in the DOM path.
+  ensure_equals(message + ": authors", book->authors().count(), 2U);
+  ensure(message + ": author1", book->authors()[0] == author);
+  ensure_equals(message + ": author2", *book->authors()[1]->name(), "author2");
+
+  ensure(message + ": extras publisher", book->extras().get("publisher") == publisher);
+  ensure(message + ": extras unknown", book->extras().has_key("unknown") && !book->extras().get("unknown").is_valid());
+  ensure_equals(message + ": extras count", *IntegerRef::cast_from(book->extras().get("count")), 42);
+}
+
+TEST_FUNCTION(6) {
+  // The streaming unserializer (used for files and xml data) must create the same tree as the DOM one.
+  ValueRef streamed(grt::GRT::get()->unserialize_xml_data(forward_links_xml));
+  check_forward_links("streamed", streamed);
+
+  xmlDocPtr doc = xmlReadMemory(forward_links_xml, (int)strlen(forward_links_xml), NULL, NULL, XML_PARSE_NOENT);
+  ValueRef parsed(grt::GRT::get()->unserialize_xml(doc, ""));
+  xmlFreeDoc(doc);
+  check_forward_links("DOM", parsed);
+
+  static const std::string filename("output/forward_links.xml");
+  {
+    std::ofstream file(filename.c_str());
+    file << forward_links_xml;
+  }
+  std::string doctype, version;
+  check_forward_links("file", grt::GRT::get()->unserialize(filename, doctype, version));
+  ensure_equals("document type", doctype, "test");
+  ensure_equals("document version", version, "1.2");
+
+  doc = grt::GRT::get()->load_xml("data/serialization/catalog.xml");
+  ValueRef catalog(grt::GRT::get()->unserialize_xml(doc, "data/serialization/catalog.xml"));
+  xmlFreeDoc(doc);
+  grt_ensure_equals("streamed catalog", grt::GRT::get()->unserialize("data/serialization/catalog.xml"), catalog, true);
+}
+
+TEST_FUNCTION(7) {
+  // The streaming serializer must write exactly what saving the DOM from create_xmldoc_for_value gives.
+  test_BookRef book(grt::Initialized);
+  book->title("quotes \" ' <tags> & entities &amp; \r\n\ttabs caf\xc3\xa9 \xe2\x82\xac");
+  book->pages(-12);
+  book->price(12.5);
+
+  test_PublisherRef publisher(grt::Initialized);
+  publisher->name("");
+  book->publisher(publisher);
+
+  for (int i = 0; i < 3; i++) {
+    test_AuthorRef author(grt::Initialized);
+    author->name("author" + std::to_string(i));
+    book->authors().insert(author);
+  }
+  book->extras().set("publisher", publisher);
+  book->extras().set("empty", DictRef(true));
+  book->extras().set("key \"with\" <special> chars", StringRef("value"));
+
+  ObjectListRef list(true);
+  list.insert(book);
+  list.insert(ObjectRef());
+  list.insert(publisher);
+  list.insert(book->authors()[1]);
+
+  for (int as_links = 0; as_links < 2; as_links++) {
+    xmlDocPtr doc = grt::internal::Serializer().create_xmldoc_for_value(list, "test", "1.0", as_links != 0);
+    xmlChar *buffer = NULL;
+    int size = 0;
+    xmlDocDumpFormatMemory(doc, &buffer, &size, 1);
+    std::string expected((const char *)buffer, size);
+    xmlFree(buffer);
+    xmlFreeDoc(doc);
+
+    ensure_equals("streamed data", grt::GRT::get()->serialize_xml_data(list, "test", "1.0", as_links != 0), expected);
+
+    static const std::string filename("output/streamed_serialization.xml");
+    grt::GRT::get()->serialize(list, filename, "test", "1.0", as_links != 0);
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ensure_equals("streamed file", written, expected);
+  }
+}
+
+TEST_FUNCTION(8) {
+  // The binary format must give the same trees as the XML one.
+  static const std::string catalog_file("output/catalog.grtb");
+  ValueRef catalog(grt::GRT::get()->unserialize("data/serialization/catalog.xml"));
+  grt::GRT::get()->serialize_binary(catalog, catalog_file, "test", "1.2", "checksum");
+
+  std::string doctype, version, checksum;
+  ensure("binary meta info", grt::GRT::get()->get_binary_metainfo(catalog_file, doctype, version, checksum));
+  ensure_equals("binary document type", doctype, "test");
+  ensure_equals("binary document version", version, "1.2");
+  ensure_equals("binary source checksum", checksum, "checksum");
+  ensure("no meta info from xml", !grt::GRT::get()->get_binary_metainfo("data/serialization/catalog.xml", doctype,
+                                                                        version, checksum));
+
+  grt_ensure_equals("binary catalog", grt::GRT::get()->unserialize_binary(catalog_file, doctype, version), catalog,
+                    true);
+
+  // The publisher is linked by the book before it is written itself.
+  test_BookRef book(grt::Initialized);
+  book->title("caf\xc3\xa9 \r\n\t<&>");
+  book->pages(-12);
+  book->price(12.5);
+
+  test_PublisherRef publisher(grt::Initialized);
+  book->publisher(publisher);
+  for (int i = 0; i < 3; i++) {
+    test_AuthorRef author(grt::Initialized);
+    author->name("author" + std::to_string(i));
+    book->authors().insert(author);
+  }
+  book->extras().set("publisher", publisher);
+  book->extras().set("big", IntegerRef(-((ssize_t)1 << 40)));
+
+  ObjectListRef list(true);
+  list.insert(book);
+  list.insert(ObjectRef());
+  list.insert(publisher);
+
+  static const std::string xml_file("output/binary_reference.xml");
+  grt::GRT::get()->serialize(list, xml_file);
+  ValueRef from_xml(grt::GRT::get()->unserialize(xml_file));
+
+  std::string data = grt::internal::BinarySerializer().serialize_to_data(list, "test", "1.2", "");
+  ObjectListRef from_binary(
+    ObjectListRef::cast_from(grt::internal::BinaryUnserializer(true).unserialize_data(data.data(), data.size())));
+  grt_ensure_equals("binary tree", from_binary, from_xml, true);
+  ensure("binary forward link", test_BookRef::cast_from(from_binary[0])->publisher() == from_binary[2]);
+  ensure("binary list null", !from_binary[1].is_valid());
+
+  // Damaged data and newer format versions are rejected.
+  bool failed = false;
+  try {
+    grt::internal::BinaryUnserializer(true).unserialize_data(data.data(), data.size() / 2);
+  } catch (std::exception &) {
+    failed = true;
+  }
+  ensure("truncated data rejected", failed);
+
+  data[4] = GRT_BINARY_FORMAT_MAJOR + 1;
+  failed = false;
+  try {
+    grt::internal::BinaryUnserializer(true).unserialize_data(data.data(), data.size());
+  } catch (std::exception &) {
+    failed = true;
+  }
+  ensure("newer format rejected", failed);
+}
+
 #ifdef badtest
 TEST_FUNCTION(5) {
   // dontfollow means the object will be saved as a link, not that it wont be saved
@@ -108,6 +108,37 @@ TEST_FUNCTION(9) {
   // check foreach_member
 }
 
+TEST_FUNCTION(10) {
+  // check member slots
+  MetaClass *book = grt::GRT::get()->get_metaclass("test.Book");
+
+  std::vector<const MetaClass::Member *> members;
+  book->foreach_member([&members](const MetaClass::Member *member) {
+    members.push_back(member);
+    return true;
+  });
+
+  ensure_equals("slot count", book->member_slot_count(), members.size());
+  for (size_t slot = 0; slot < members.size(); slot++) {
+    ensure("slot member", book->member_slot_info(slot) == members[slot]);
+    ensure_equals("slot of " + members[slot]->name, book->member_slot(members[slot]->name), slot);
+  }
+  ensure("slot title (inherited)", book->member_slot("title") != MetaClass::invalid_slot);
+  ensure("slot invalid", book->member_slot("xxx") == MetaClass::invalid_slot);
+
+  test_BookRef book_obj(grt::Initialized);
+  size_t pages = book->member_slot("pages");
+  size_t title = book->member_slot("title");
+
+  book->set_slot_value(&book_obj.content(), pages, IntegerRef(42));
+  book->set_slot_value(&book_obj.content(), title, StringRef("slots"));
+  ensure_equals("set pages", *book_obj->pages(), 42);
+  ensure_equals("set title", *book_obj->title(), "slots");
+  ensure_equals("get title", *StringRef::cast_from(book->get_slot_value(&book_obj.content(), title)), "slots");
+  ensure_equals("get title by name", *StringRef::cast_from(book->get_member_value(&book_obj.content(), "title")),
+                "slots");
+}
+
 TEST_FUNCTION(20) {
   // Test struct members and their attributes.
   MetaClass *book(grt::GRT::get()->get_metaclass("test.Book"));
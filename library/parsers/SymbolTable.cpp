@@ -23,6 +23,8 @@
 
 #include <mutex>
 
+#include "base/string_utilities.h"
+
 #include "SymbolTable.h"
 
 using namespace parsers;
@@ -84,19 +86,81 @@ ScopedSymbol::ScopedSymbol(std::string const &name) : Symbol(name) {
 
 void ScopedSymbol::clear() {
   children.clear();
+  nameIndex.clear();
+  foldedNameIndex.clear();
+  typeBuckets.clear();
 }
 
 void ScopedSymbol::addAndManageSymbol(Symbol *symbol) {
   children.emplace_back(symbol);
   symbol->setParent(this);
+  indexChild(children.size() - 1);
 }
 
-Symbol *ScopedSymbol::resolve(std::string const &name, bool localOnly) {
-  for (auto &child : children) {
-    if (child->name == name)
-      return child.get();
+void ScopedSymbol::removeSymbol(Symbol *symbol) {
+  auto iterator = std::find_if(children.begin(), children.end(),
+                               [symbol](std::unique_ptr<Symbol> const &child) { return child.get() == symbol; });
+  if (iterator == children.end())
+    return;
+
+  // All indexes behind the removed child change, so rebuild the lookup structures.
+  children.erase(iterator);
+  nameIndex.clear();
+  foldedNameIndex.clear();
+  typeBuckets.clear();
+  for (size_t i = 0; i < children.size(); ++i)
+    indexChild(i);
+}
+
+void ScopedSymbol::indexChild(size_t index) {
+  Symbol *child = children[index].get();
+
+  // emplace() keeps an existing entry, so the first definition of a name wins (as in a linear search).
+  nameIndex.emplace(child->name, index);
+  foldedNameIndex.emplace(base::tolower(child->name), index);
+
+  std::type_index type = typeid(*child);
+  auto bucket = std::find_if(typeBuckets.begin(), typeBuckets.end(),
+                             [type](std::pair<std::type_index, std::vector<size_t>> const &entry) {
+                               return entry.first == type;
+                             });
+  if (bucket == typeBuckets.end())
+    typeBuckets.push_back({ type, { index } });
+  else
+    bucket->second.push_back(index);
+}
+
+/**
+ * Looks up a direct child by name. Names of schemas, tables, views and triggers are compared case sensitively,
+ * unless the symbol table says otherwise, all other names are compared case insensitively (like MySQL does).
+ */
+Symbol *ScopedSymbol::resolveLocally(std::string const &name) const {
+  auto iterator = nameIndex.find(name);
+  if (iterator != nameIndex.end())
+    return children[iterator->second].get();
+
+  iterator = foldedNameIndex.find(base::tolower(name));
+  if (iterator == foldedNameIndex.end())
+    return nullptr;
+
+  Symbol *candidate = children[iterator->second].get();
+  if (dynamic_cast<SchemaSymbol *>(candidate) != nullptr || dynamic_cast<TableSymbol *>(candidate) != nullptr ||
+      dynamic_cast<ViewSymbol *>(candidate) != nullptr || dynamic_cast<TriggerSymbol *>(candidate) != nullptr) {
+    SymbolTable *table = dynamic_cast<SymbolTable *>(const_cast<ScopedSymbol *>(this));
+    if (table == nullptr)
+      table = getParentOfType<SymbolTable>();
+    if (table == nullptr || table->isCaseSensitive())
+      return nullptr;
   }
 
+  return candidate;
+}
+
+Symbol *ScopedSymbol::resolve(std::string const &name, bool localOnly) {
+  Symbol *result = resolveLocally(name);
+  if (result != nullptr)
+    return result;
+
   // Nothing found locally. Let the parent continue.
   if (!localOnly) {
     ScopedSymbol *scopedParent = dynamic_cast<ScopedSymbol *>(parent);
@@ -303,6 +367,18 @@ void SymbolTable::addDependencies(std::vector<SymbolTable *> const &newDependenc
 
 //----------------------------------------------------------------------------------------------------------------------
 
+void SymbolTable::setCaseSensitive(bool flag) {
+  _caseSensitive = flag;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool SymbolTable::isCaseSensitive() const {
+  return _caseSensitive;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 Symbol *SymbolTable::resolve(std::string const &name, bool localOnly) {
   lock();
   Symbol *result = ScopedSymbol::resolve(name, localOnly);
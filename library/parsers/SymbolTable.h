@@ -27,6 +27,9 @@
 
 #include <set>
 #include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <algorithm>
 
 // A simple symbol table implementation, tailored towards code completion.
 
@@ -106,20 +109,45 @@ namespace parsers {
     virtual void clear() override;
 
     void addAndManageSymbol(Symbol *symbol); // Takes over ownership.
+    void removeSymbol(Symbol *symbol);       // Removes and deletes a direct child.
 
     template <typename T>
     std::vector<T *> getSymbolsOfType() const {
-      std::vector<T *> result;
-      for (auto &child : children) {
-        T *castChild = dynamic_cast<T *>(child.get());
-        if (castChild != nullptr)
-          result.push_back(castChild);
+      // Only buckets with symbols of type T are relevant. With more than one such bucket the children must be brought
+      // back into definition order.
+      std::vector<size_t> const *firstBucket = nullptr;
+      std::vector<size_t> indexes;
+      for (auto &bucket : typeBuckets) {
+        if (dynamic_cast<T *>(children[bucket.second.front()].get()) == nullptr)
+          continue;
+
+        if (firstBucket == nullptr)
+          firstBucket = &bucket.second;
+        else {
+          if (indexes.empty())
+            indexes = *firstBucket;
+          indexes.insert(indexes.end(), bucket.second.begin(), bucket.second.end());
+        }
       }
 
+      std::vector<T *> result;
+      if (firstBucket == nullptr)
+        return result;
+
+      if (!indexes.empty())
+        std::sort(indexes.begin(), indexes.end());
+      else
+        indexes = *firstBucket;
+
+      result.reserve(indexes.size());
+      for (size_t index : indexes)
+        result.push_back(dynamic_cast<T *>(children[index].get()));
+
       return result;
     }
 
     // Retrieval functions for this scope or any of the parent scopes (conditionally).
+    // Names are compared case insensitively for all symbols which MySQL treats so (see isCaseSensitive()).
     virtual Symbol *resolve(std::string const &name, bool localOnly = false);
 
     // Returns all accessible symbols that have a type assigned.
@@ -145,7 +173,16 @@ namespace parsers {
 
     std::vector<std::unique_ptr<Symbol>> children; // All child symbols in definition order.
 
+    // Lookup structures for the children (indexes into children), maintained when adding and removing symbols.
+    // Symbols must not be renamed after they were added.
+    std::unordered_map<std::string, size_t> nameIndex;       // The first child with a given name.
+    std::unordered_map<std::string, size_t> foldedNameIndex; // The same for the lower case name.
+    std::vector<std::pair<std::type_index, std::vector<size_t>>> typeBuckets; // The children per (dynamic) type.
+
     ScopedSymbol(std::string const &name = "");
+
+    Symbol *resolveLocally(std::string const &name) const;
+    void indexChild(size_t index);
   };
 
   class PARSERS_PUBLIC_TYPE VariableSymbol : public TypedSymbol {
@@ -374,6 +411,11 @@ namespace parsers {
 
     void addDependencies(std::vector<SymbolTable *> const &newDependencies);
 
+    // Schema, table, view and trigger names are case sensitive (the default), unless the server uses
+    // lower_case_table_names > 0. All other names are always compared case insensitively.
+    void setCaseSensitive(bool flag);
+    bool isCaseSensitive() const;
+
     // The returned symbol instance is managed by this table.
     template <typename T, typename... Args>
     T *addNewSymbol(ScopedSymbol *parent, Args &&... args)  {
@@ -395,11 +437,7 @@ namespace parsers {
 
       lock();
       if (parent == nullptr || parent == this) {
-        for (auto &child : children) {
-          T *castChild = dynamic_cast<T *>(child.get());
-          if (castChild != nullptr)
-            result.push_back(castChild);
-        }
+        result = ScopedSymbol::getSymbolsOfType<T>();
 
         for (SymbolTable *table : _dependencies) {
           auto subList = table->getSymbolsOfType<T>();
@@ -418,6 +456,7 @@ namespace parsers {
   private:
     // Other symbol information available to this instance.
     std::vector<SymbolTable *> _dependencies;
+    bool _caseSensitive = true;
 
     class Private;
     Private *_d;
@@ -21,6 +21,8 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <mutex>
+
 #include "antlr4-runtime.h"
 
 #include "CodeCompletionCore.h"
@@ -31,7 +33,12 @@ using namespace antlr4::misc;
 
 //----------------------------------------------------------------------------------------------------------------------
 
-std::unordered_map<std::type_index, CodeCompletionCore::FollowSetsPerState> CodeCompletionCore::_followSetsByATN;
+std::map<CodeCompletionCore::FollowSetsKey, CodeCompletionCore::FollowSetsPerState>
+  CodeCompletionCore::_followSetsByATN;
+std::unordered_map<std::type_index, std::vector<PredicateTransition *>> CodeCompletionCore::_predicatesByATN;
+
+// Guards _followSetsByATN and _predicatesByATN while entries are added. Existing entries are never modified.
+static std::mutex followSetsMutex;
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -42,10 +49,17 @@ CodeCompletionCore::CodeCompletionCore(Parser *parser)
 //----------------------------------------------------------------------------------------------------------------------
 
 CandidatesCollection CodeCompletionCore::collectCandidates(size_t caretTokenIndex, ParserRuleContext *context) {
+  _followSets = nullptr; // The parser settings may have changed since the last run.
+  precomputeFollowSets();
+  auto start = std::chrono::steady_clock::now();
+
   _shortcutMap.clear();
   _candidates.rules.clear();
   _candidates.tokens.clear();
-  _statesProcessed = 0;
+  _candidates.complete = true;
+  _statistics = CompletionStatistics();
+  _stopped = false;
+  _deadline = start + std::chrono::milliseconds(timeout);
 
   _tokenStartIndex = context != nullptr ? context->start->getTokenIndex() : 0;
 
@@ -69,6 +83,10 @@ CandidatesCollection CodeCompletionCore::collectCandidates(size_t caretTokenInde
   size_t startRule = context != nullptr ? context->getRuleIndex() : 0;
   processRule(_atn.ruleToStartState[startRule], 0, callStack, "");
 
+  _candidates.complete = !_stopped;
+  _statistics.milliseconds =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
   if (showResult) {
     std::cout << std::endl << std::endl << "Collected rules:" << std::endl;
     for (auto &rule : _candidates.rules) {
@@ -98,6 +116,95 @@ CandidatesCollection CodeCompletionCore::collectCandidates(size_t caretTokenInde
 
 //----------------------------------------------------------------------------------------------------------------------
 
+CompletionStatistics const& CodeCompletionCore::statistics() const {
+  return _statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CodeCompletionCore::precomputeFollowSets() {
+  if (_followSets != nullptr)
+    return;
+
+  std::type_index type = typeid(*_parser);
+  std::vector<PredicateTransition *> const *predicates;
+  {
+    std::lock_guard<std::mutex> lock(followSetsMutex);
+    auto iterator = _predicatesByATN.find(type);
+    if (iterator == _predicatesByATN.end()) {
+      std::vector<PredicateTransition *> list;
+      for (ATNState *state : _atn.states) {
+        if (state == nullptr)
+          continue;
+        for (Transition *transition : state->transitions) {
+          if (transition->getSerializationType() == Transition::PREDICATE)
+            list.push_back(static_cast<PredicateTransition *>(transition));
+        }
+      }
+      iterator = _predicatesByATN.emplace(type, std::move(list)).first;
+    }
+    predicates = &iterator->second;
+  }
+
+  // The predicates depend on the parser settings (server version, sql mode etc.).
+  FollowSetsKey key = { type, {} };
+  key.second.reserve(predicates->size());
+  for (PredicateTransition *transition : *predicates)
+    key.second.push_back(checkPredicate(transition));
+
+  {
+    std::lock_guard<std::mutex> lock(followSetsMutex);
+    auto iterator = _followSetsByATN.find(key);
+    if (iterator != _followSetsByATN.end()) {
+      _followSets = &iterator->second;
+      return;
+    }
+  }
+
+  // For rule start states we determine and cache the follow set, which gives us 3 advantages:
+  // 1) We can quickly check if a symbol would be matched when we follow that rule. We can so check in advance
+  //    and can save us all the intermediate steps if there is no match.
+  // 2) We'll have all symbols that are collectable already together when we are at the caret when entering a rule.
+  // 3) We get this lookup for free with any 2nd or further visit of the same rule, which often happens
+  //    in non trivial grammars, especially with (recursive) expressions and of course when invoking code completion
+  //    multiple times.
+  // This is done without holding the lock, so that other parser settings are not blocked meanwhile.
+  FollowSetsPerState setsPerState;
+  for (size_t i = 0; i < _atn.ruleToStartState.size(); ++i) {
+    ATNState *startState = _atn.ruleToStartState[i];
+    FollowSetsHolder &holder = setsPerState[startState->stateNumber];
+    holder.sets = determineFollowSets(startState, _atn.ruleToStopState[i]);
+
+    // Sets are split by path to allow translating them to preferred rules. But for quick hit tests
+    // it is also useful to have a set with all symbols combined.
+    for (auto &set : holder.sets)
+      holder.combined.addAll(set.intervals);
+  }
+
+  // If another thread computed the same entry meanwhile, that one is kept.
+  std::lock_guard<std::mutex> lock(followSetsMutex);
+  _followSets = &_followSetsByATN.emplace(key, std::move(setsPerState)).first->second;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Checks the limits for the collection run. Once one is hit all rule processing ends.
+ */
+bool CodeCompletionCore::shouldStop() {
+  if (_stopped)
+    return true;
+
+  if (cancelFlag != nullptr && *cancelFlag)
+    _stopped = true;
+  else if (timeout > 0 && (_statistics.statesProcessed % 64) == 0 && std::chrono::steady_clock::now() > _deadline)
+    _stopped = true;
+
+  return _stopped;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
  * Checks if the predicate associated with the given transition evaluates to true.
  */
@@ -270,6 +377,8 @@ CodeCompletionCore::RuleEndStatus CodeCompletionCore::processRule(ATNState *star
   std::vector<size_t> &callStack, std::string indentation) {
 
   // Start with rule specific handling before going into the ATN walk.
+  if (shouldStop())
+    return {};
 
   // Check first if we've taken this path with the same input before.
   auto &positionMap = _shortcutMap[startState->ruleIndex];
@@ -277,33 +386,15 @@ CodeCompletionCore::RuleEndStatus CodeCompletionCore::processRule(ATNState *star
     if (showDebugOutput) {
       std::cout << "=====> shortcut" << std::endl;
     }
+    ++_statistics.shortcutHits;
     return positionMap[tokenIndex];
   }
 
+  ++_statistics.rulesProcessed;
   RuleEndStatus result;
 
-  // For rule start states we determine and cache the follow set, which gives us 3 advantages:
-  // 1) We can quickly check if a symbol would be matched when we follow that rule. We can so check in advance
-  //    and can save us all the intermediate steps if there is no match.
-  // 2) We'll have all symbols that are collectable already together when we are at the caret when entering a rule.
-  // 3) We get this lookup for free with any 2nd or further visit of the same rule, which often happens
-  //    in non trivial grammars, especially with (recursive) expressions and of course when invoking code completion
-  //    multiple times.
-  FollowSetsPerState &setsPerState = _followSetsByATN[typeid(_parser)];
-  if (setsPerState.count(startState->stateNumber) == 0) {
-    ATNState *stop = _atn.ruleToStopState[startState->ruleIndex];
-    auto followSets = determineFollowSets(startState, stop);
-    setsPerState[startState->stateNumber].sets = followSets;
-
-    // Sets are split by path to allow translating them to preferred rules. But for quick hit tests
-    // it is also useful to have a set with all symbols combined.
-    IntervalSet combined;
-    for (auto &set : setsPerState[startState->stateNumber].sets)
-      combined.addAll(set.intervals);
-    setsPerState[startState->stateNumber].combined = combined;
-  }
-
-  FollowSetsHolder &followSets = setsPerState[startState->stateNumber];
+  // The follow sets of all rules are computed in advance (see precomputeFollowSets()).
+  FollowSetsHolder const &followSets = _followSets->at(startState->stateNumber);
   callStack.push_back(startState->ruleIndex);
 
   if (tokenIndex >= _tokens.size() - 1) { // At caret?
@@ -342,6 +433,7 @@ CodeCompletionCore::RuleEndStatus CodeCompletionCore::processRule(ATNState *star
     // or if the current input symbol will be matched somewhere after this entry point.
     size_t currentSymbol = _tokens[tokenIndex];
     if (!followSets.combined.contains(Token::EPSILON) && !followSets.combined.contains(currentSymbol)) {
+      ++_statistics.followSetRejections;
       callStack.pop_back();
       return {};
     }
@@ -359,9 +451,12 @@ CodeCompletionCore::RuleEndStatus CodeCompletionCore::processRule(ATNState *star
   statePipeline.push_back({ startState, tokenIndex });
 
   while (!statePipeline.empty()) {
+    if (shouldStop())
+      break;
+
     currentEntry = statePipeline.back();
     statePipeline.pop_back();
-    ++_statesProcessed;
+    ++_statistics.statesProcessed;
 
     size_t currentSymbol = _tokens[tokenIndex];
     bool atCaret = currentEntry.tokenIndex >= _tokens.size() - 1;
@@ -22,9 +22,12 @@
  */
 
 #include <unordered_set>
+#include <map>
 #include <string>
 #include <vector>
 #include <typeindex>
+#include <atomic>
+#include <chrono>
 
 namespace antlr4 {
   class Parser;
@@ -43,7 +46,17 @@ namespace antlr4 {
   // All the candidates which have been found. Tokens and rules are separated (both use a numeric value).
   struct CandidatesCollection {
     std::map<size_t, TokenList> tokens;
-    std::map<size_t, RuleList> rules;    
+    std::map<size_t, RuleList> rules;
+    bool complete = true; // False if the collection ran out of time or was cancelled (the candidates are partial then).
+  };
+
+  // Some numbers about the last collection run.
+  struct CompletionStatistics {
+    size_t statesProcessed = 0;
+    size_t rulesProcessed = 0;
+    size_t shortcutHits = 0;       // Rules not walked again, because they were walked before with the same input.
+    size_t followSetRejections = 0; // Rules not walked, because their follow set doesn't match the input.
+    double milliseconds = 0;
   };
 
   // The main class for doing the collection process.
@@ -59,9 +72,20 @@ namespace antlr4 {
     std::unordered_set<size_t> ignoredTokens;  // Tokens which should not appear in the candidates set.
     std::unordered_set<size_t> preferredRules; // Rules which replace any candidate token they contain.
                                                // This allows to return descriptive rules (e.g. className, instead of ID/identifier).
+    // Limits for the collection process. When one is hit the candidates found so far are returned.
+    size_t timeout = 0;                             // In milliseconds, 0 for no limit.
+    std::atomic<bool> const *cancelFlag = nullptr; // Set by the caller (e.g. from another thread) to stop collection.
+
     CodeCompletionCore(antlr4::Parser *parser);
 
     CandidatesCollection collectCandidates(size_t caretTokenIndex, ParserRuleContext *context);
+    CompletionStatistics const& statistics() const;
+
+    // Computes the follow sets for all rules of the parser's ATN (shared by all instances for the same parser class
+    // and the same outcome of the grammar predicates, e.g. for a server version).
+    // Done on the first collection run if not called before, but this can take a moment, so better call it
+    // at startup (with the same ignored tokens as used later).
+    void precomputeFollowSets();
 
   private:
     // Token stream position info after a rule was processed.
@@ -78,9 +102,12 @@ namespace antlr4 {
 
     size_t _tokenStartIndex; // The index of the token which is the start token in a given parser rule context.
 
-    size_t _statesProcessed;
     std::unordered_map<size_t, std::unordered_map<size_t, RuleEndStatus>> _shortcutMap;
     CandidatesCollection _candidates; // The collected candidates (rules and tokens).
+    CompletionStatistics _statistics;
+
+    std::chrono::steady_clock::time_point _deadline;
+    bool _stopped; // Time is up or collection was cancelled.
 
     // A record for a follow set along with the path at which this set was found.
     // If there is only a single symbol in the interval set then we also collect and store tokens which follow
@@ -103,13 +130,20 @@ namespace antlr4 {
     };
 
     using FollowSetsPerState = std::unordered_map<size_t, FollowSetsHolder>;
-    static std::unordered_map<std::type_index, FollowSetsPerState> _followSetsByATN;
+
+    // Predicates are evaluated while collecting the follow sets, so they are kept per parser class and the results
+    // of all predicate transitions in its ATN (in ATN order).
+    using FollowSetsKey = std::pair<std::type_index, std::vector<bool>>;
+    static std::map<FollowSetsKey, FollowSetsPerState> _followSetsByATN;
+    static std::unordered_map<std::type_index, std::vector<antlr4::atn::PredicateTransition *>> _predicatesByATN;
+    FollowSetsPerState const *_followSets = nullptr; // The entry for our parser, complete and no longer modified.
 
     struct PipelineEntry {
       antlr4::atn::ATNState *state;
       size_t tokenIndex;
     };
 
+    bool shouldStop();
     bool checkPredicate(antlr4::atn::PredicateTransition *transition) const;
     bool translateToRuleIndex(std::vector<size_t> const& ruleStack);
     void printRuleState(std::vector<size_t> const& stack) const;
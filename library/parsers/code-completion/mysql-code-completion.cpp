@@ -52,6 +52,9 @@ using namespace antlr4;
 
 DEFAULT_LOG_DOMAIN("MySQL code completion");
 
+// Time (in ms) the candidate collection may take. It returns what it found so far if that is exceeded.
+#define AC_TIME_BUDGET 500
+
 //--------------------------------------------------------------------------------------------------
 
 struct TableReference {
@@ -60,6 +63,88 @@ struct TableReference {
   std::string alias;
 };
 
+/**
+ * Sets up the code completion core with the tokens and rules the MySQL code completion works with.
+ */
+static void setupCompletionCore(CodeCompletionCore &c3) {
+  c3.ignoredTokens = {
+    MySQLLexer::EOF,
+    MySQLLexer::EQUAL_OPERATOR,
+    MySQLLexer::ASSIGN_OPERATOR,
+    MySQLLexer::NULL_SAFE_EQUAL_OPERATOR,
+    MySQLLexer::GREATER_OR_EQUAL_OPERATOR,
+    MySQLLexer::GREATER_THAN_OPERATOR,
+    MySQLLexer::LESS_OR_EQUAL_OPERATOR,
+    MySQLLexer::LESS_THAN_OPERATOR,
+    MySQLLexer::NOT_EQUAL_OPERATOR,
+    MySQLLexer::NOT_EQUAL2_OPERATOR,
+    MySQLLexer::PLUS_OPERATOR,
+    MySQLLexer::MINUS_OPERATOR,
+    MySQLLexer::MULT_OPERATOR,
+    MySQLLexer::DIV_OPERATOR,
+    MySQLLexer::MOD_OPERATOR,
+    MySQLLexer::LOGICAL_NOT_OPERATOR,
+    MySQLLexer::BITWISE_NOT_OPERATOR,
+    MySQLLexer::SHIFT_LEFT_OPERATOR,
+    MySQLLexer::SHIFT_RIGHT_OPERATOR,
+    MySQLLexer::LOGICAL_AND_OPERATOR,
+    MySQLLexer::BITWISE_AND_OPERATOR,
+    MySQLLexer::BITWISE_XOR_OPERATOR,
+    MySQLLexer::LOGICAL_OR_OPERATOR,
+    MySQLLexer::BITWISE_OR_OPERATOR,
+    MySQLLexer::DOT_SYMBOL,
+    MySQLLexer::COMMA_SYMBOL,
+    MySQLLexer::SEMICOLON_SYMBOL,
+    MySQLLexer::COLON_SYMBOL,
+    MySQLLexer::OPEN_PAR_SYMBOL,
+    MySQLLexer::CLOSE_PAR_SYMBOL,
+    MySQLLexer::OPEN_CURLY_SYMBOL,
+    MySQLLexer::CLOSE_CURLY_SYMBOL,
+    MySQLLexer::UNDERLINE_SYMBOL,
+    MySQLLexer::AT_SIGN_SYMBOL,
+    MySQLLexer::AT_AT_SIGN_SYMBOL,
+    MySQLLexer::NULL2_SYMBOL,
+    MySQLLexer::PARAM_MARKER,
+    MySQLLexer::CONCAT_PIPES_SYMBOL,
+    MySQLLexer::AT_TEXT_SUFFIX,
+    MySQLLexer::BACK_TICK_QUOTED_ID,
+    MySQLLexer::SINGLE_QUOTED_TEXT,
+    MySQLLexer::DOUBLE_QUOTED_TEXT,
+    MySQLLexer::NCHAR_TEXT,
+    MySQLLexer::UNDERSCORE_CHARSET,
+    MySQLLexer::IDENTIFIER,
+    MySQLLexer::INT_NUMBER,
+    MySQLLexer::LONG_NUMBER,
+    MySQLLexer::ULONGLONG_NUMBER,
+    MySQLLexer::DECIMAL_NUMBER,
+    MySQLLexer::BIN_NUMBER,
+    MySQLLexer::HEX_NUMBER,
+  };
+
+  c3.preferredRules = {
+    MySQLParser::RuleSchemaRef,
+
+    MySQLParser::RuleTableRef, MySQLParser::RuleTableRefWithWildcard, MySQLParser::RuleFilterTableRef,
+
+    MySQLParser::RuleColumnRef, MySQLParser::RuleColumnInternalRef, MySQLParser::RuleTableWild,
+
+    MySQLParser::RuleFunctionRef, MySQLParser::RuleFunctionCall, MySQLParser::RuleRuntimeFunctionCall,
+    MySQLParser::RuleTriggerRef, MySQLParser::RuleViewRef, MySQLParser::RuleProcedureRef,
+    MySQLParser::RuleLogfileGroupRef, MySQLParser::RuleTablespaceRef, MySQLParser::RuleEngineRef,
+    MySQLParser::RuleCollationName, MySQLParser::RuleCharsetName, MySQLParser::RuleEventRef,
+    MySQLParser::RuleServerRef, MySQLParser::RuleUser,
+
+    MySQLParser::RuleUserVariable, MySQLParser::RuleSystemVariable, MySQLParser::RuleLabelRef,
+    MySQLParser::RuleSetSystemVariable,
+
+    // For better handling, but will be ignored.
+    MySQLParser::RuleParameterName, MySQLParser::RuleProcedureName, MySQLParser::RuleIdentifier,
+    MySQLParser::RuleLabelIdentifier,
+  };
+}
+
+//--------------------------------------------------------------------------------------------------
+
 // Context structure for code completion results and token info.
 struct AutoCompletionContext {
   CandidatesCollection completionCandidates;
@@ -77,81 +162,8 @@ struct AutoCompletionContext {
 
   void collectCandidates(MySQLParser *parser, Scanner &scanner, size_t caretOffset, size_t caretLine) {
     CodeCompletionCore c3(parser);
-
-    c3.ignoredTokens = {
-      MySQLLexer::EOF,
-      MySQLLexer::EQUAL_OPERATOR,
-      MySQLLexer::ASSIGN_OPERATOR,
-      MySQLLexer::NULL_SAFE_EQUAL_OPERATOR,
-      MySQLLexer::GREATER_OR_EQUAL_OPERATOR,
-      MySQLLexer::GREATER_THAN_OPERATOR,
-      MySQLLexer::LESS_OR_EQUAL_OPERATOR,
-      MySQLLexer::LESS_THAN_OPERATOR,
-      MySQLLexer::NOT_EQUAL_OPERATOR,
-      MySQLLexer::NOT_EQUAL2_OPERATOR,
-      MySQLLexer::PLUS_OPERATOR,
-      MySQLLexer::MINUS_OPERATOR,
-      MySQLLexer::MULT_OPERATOR,
-      MySQLLexer::DIV_OPERATOR,
-      MySQLLexer::MOD_OPERATOR,
-      MySQLLexer::LOGICAL_NOT_OPERATOR,
-      MySQLLexer::BITWISE_NOT_OPERATOR,
-      MySQLLexer::SHIFT_LEFT_OPERATOR,
-      MySQLLexer::SHIFT_RIGHT_OPERATOR,
-      MySQLLexer::LOGICAL_AND_OPERATOR,
-      MySQLLexer::BITWISE_AND_OPERATOR,
-      MySQLLexer::BITWISE_XOR_OPERATOR,
-      MySQLLexer::LOGICAL_OR_OPERATOR,
-      MySQLLexer::BITWISE_OR_OPERATOR,
-      MySQLLexer::DOT_SYMBOL,
-      MySQLLexer::COMMA_SYMBOL,
-      MySQLLexer::SEMICOLON_SYMBOL,
-      MySQLLexer::COLON_SYMBOL,
-      MySQLLexer::OPEN_PAR_SYMBOL,
-      MySQLLexer::CLOSE_PAR_SYMBOL,
-      MySQLLexer::OPEN_CURLY_SYMBOL,
-      MySQLLexer::CLOSE_CURLY_SYMBOL,
-      MySQLLexer::UNDERLINE_SYMBOL,
-      MySQLLexer::AT_SIGN_SYMBOL,
-      MySQLLexer::AT_AT_SIGN_SYMBOL,
-      MySQLLexer::NULL2_SYMBOL,
-      MySQLLexer::PARAM_MARKER,
-      MySQLLexer::CONCAT_PIPES_SYMBOL,
-      MySQLLexer::AT_TEXT_SUFFIX,
-      MySQLLexer::BACK_TICK_QUOTED_ID,
-      MySQLLexer::SINGLE_QUOTED_TEXT,
-      MySQLLexer::DOUBLE_QUOTED_TEXT,
-      MySQLLexer::NCHAR_TEXT,
-      MySQLLexer::UNDERSCORE_CHARSET,
-      MySQLLexer::IDENTIFIER,
-      MySQLLexer::INT_NUMBER,
-      MySQLLexer::LONG_NUMBER,
-      MySQLLexer::ULONGLONG_NUMBER,
-      MySQLLexer::DECIMAL_NUMBER,
-      MySQLLexer::BIN_NUMBER,
-      MySQLLexer::HEX_NUMBER,
-    };
-
-    c3.preferredRules = {
-      MySQLParser::RuleSchemaRef,
-
-      MySQLParser::RuleTableRef, MySQLParser::RuleTableRefWithWildcard, MySQLParser::RuleFilterTableRef,
-
-      MySQLParser::RuleColumnRef, MySQLParser::RuleColumnInternalRef, MySQLParser::RuleTableWild,
-
-      MySQLParser::RuleFunctionRef, MySQLParser::RuleFunctionCall, MySQLParser::RuleRuntimeFunctionCall,
-      MySQLParser::RuleTriggerRef, MySQLParser::RuleViewRef, MySQLParser::RuleProcedureRef,
-      MySQLParser::RuleLogfileGroupRef, MySQLParser::RuleTablespaceRef, MySQLParser::RuleEngineRef,
-      MySQLParser::RuleCollationName, MySQLParser::RuleCharsetName, MySQLParser::RuleEventRef,
-      MySQLParser::RuleServerRef, MySQLParser::RuleUser,
-
-      MySQLParser::RuleUserVariable, MySQLParser::RuleSystemVariable, MySQLParser::RuleLabelRef,
-      MySQLParser::RuleSetSystemVariable,
-
-      // For better handling, but will be ignored.
-      MySQLParser::RuleParameterName, MySQLParser::RuleProcedureName, MySQLParser::RuleIdentifier,
-      MySQLParser::RuleLabelIdentifier,
-    };
+    setupCompletionCore(c3);
+    c3.timeout = AC_TIME_BUDGET;
 
     static std::set<size_t> noSeparatorRequiredFor = {
       MySQLLexer::EQUAL_OPERATOR,
@@ -221,6 +233,12 @@ struct AutoCompletionContext {
 */
     completionCandidates = c3.collectCandidates(caretIndex, context);
 
+    CompletionStatistics const& statistics = c3.statistics();
+    logDebug2("Candidate collection took %.1f ms, %lu rules, %lu states, %lu follow set rejections%s\n",
+              statistics.milliseconds, (unsigned long)statistics.rulesProcessed,
+              (unsigned long)statistics.statesProcessed, (unsigned long)statistics.followSetRejections,
+              completionCandidates.complete ? "" : " (time budget exceeded, partial result)");
+
     // Post processing some entries.
     if (completionCandidates.tokens.count(MySQLLexer::NOT2_SYMBOL) > 0) {
       // NOT2 is a NOT with special meaning in the operator precedence chain.
@@ -1144,3 +1162,11 @@ std::vector<std::pair<int, std::string>> getCodeCompletionList(size_t caretLine,
 }
 
 //--------------------------------------------------------------------------------------------------
+
+void initializeMySQLCodeCompletion(MySQLParser *parser) {
+  CodeCompletionCore c3(parser);
+  setupCompletionCore(c3);
+  c3.precomputeFollowSets();
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -33,3 +33,7 @@ namespace parsers {
 PARSERS_PUBLIC_TYPE std::vector<std::pair<int, std::string>> getCodeCompletionList(
   size_t caretLine, size_t caretOffset, const std::string &defaultSchema, bool uppercaseKeywords,
   parsers::MySQLParser *parser, parsers::SymbolTable &symbolTable);
+
+// Prepares the (shared) data used for code completion with the given parser, to avoid that delay in the first
+// completion run.
+PARSERS_PUBLIC_TYPE void initializeMySQLCodeCompletion(parsers::MySQLParser *parser);
@@ -29,6 +29,12 @@
 using namespace antlr4;
 using namespace parsers;
 
+// Number of bytes given to the lexer for a statement classification, before the full text is used.
+#define CLASSIFICATION_PREFIX_LENGTH 512
+
+// Tokens which end within that many chars before the end of the prefix might have been cut at the prefix end.
+#define CLASSIFICATION_PREFIX_MARGIN 64
+
 //----------------------------------------------------------------------------------------------------------------------
 
 MySQLBaseLexer::MySQLBaseLexer(CharStream *input) : Lexer(input) {
@@ -934,6 +940,46 @@ size_t MySQLBaseLexer::keywordFromText(std::string const& name) {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * Runs the classifier on a prefix of the text first. The result is only used if all tokens the classifier looked at
+ * end well before the prefix end (which means they are the same as in the full text). Otherwise the full text is used.
+ */
+template <typename Result>
+Result MySQLBaseLexer::classify(const std::string &text, std::function<Result()> const &classifier) {
+  if (text.size() > CLASSIFICATION_PREFIX_LENGTH + CLASSIFICATION_PREFIX_MARGIN) {
+    // Don't cut a multi byte char.
+    size_t length = CLASSIFICATION_PREFIX_LENGTH;
+    while (length > 0 && (text[length] & 0xC0) == 0x80)
+      --length;
+
+    _classificationInput.load(text.substr(0, length));
+    setInputStream(&_classificationInput);
+    _pendingTokens.clear();
+    Result result = classifier();
+    if (_input->index() + CLASSIFICATION_PREFIX_MARGIN <= _classificationInput.size())
+      return result;
+  }
+
+  _classificationInput.load(text);
+  setInputStream(&_classificationInput);
+  _pendingTokens.clear();
+  return classifier();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MySQLQueryType MySQLBaseLexer::determineQueryType(const std::string &text) {
+  return classify<MySQLQueryType>(text, [this]() { return determineQueryType(); });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t MySQLBaseLexer::determineFirstTokenType(const std::string &text) {
+  return classify<size_t>(text, [this]() { return nextDefaultChannelToken()->getType(); });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 bool MySQLBaseLexer::isRelation(size_t type) {
   switch (type) {
     case MySQLLexer::EQUAL_OPERATOR:
@@ -23,6 +23,9 @@
 
 #pragma once
 
+#include <functional>
+
+#include "ANTLRInputStream.h"
 #include "Lexer.h"
 #include "MySQLRecognizerCommon.h"
 #include "mysql-recognition-types.h"
@@ -50,6 +53,13 @@ namespace parsers {
     // Scans from the current token position to find out which query type we are dealing with in the input.
     MySQLQueryType determineQueryType();
 
+    // Lexer-only classification of a statement, which replaces the current input of the lexer. Only a prefix of
+    // the text is lexed, unless the tokens needed for the decision don't fit into it.
+    MySQLQueryType determineQueryType(const std::string &text);
+
+    // Returns the type of the first token in the text that is not on a hidden channel (Token::EOF if there's none).
+    size_t determineFirstTokenType(const std::string &text);
+
     static bool isRelation(size_t type);
     static bool isNumber(size_t type);
     static bool isOperator(size_t type);
@@ -81,6 +91,10 @@ namespace parsers {
 
     std::unique_ptr<antlr4::Token> nextDefaultChannelToken();
     bool skipDefiner(std::unique_ptr<antlr4::Token> &token);
+
+    antlr4::ANTLRInputStream _classificationInput;
+    template <typename Result>
+    Result classify(const std::string &text, std::function<Result()> const &classifier);
   };
 
 } // namespace parsers
@@ -237,6 +237,283 @@ TEST_FUNCTION(10) {
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * The original byte-at-a-time statement splitter, kept as reference for the (faster) scanner in the parser module.
+ */
+static const unsigned char *referenceSkipLeadingWhitespace(const unsigned char *head, const unsigned char *tail) {
+  while (head < tail && *head <= ' ')
+    head++;
+  return head;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static bool referenceIsLineBreak(const unsigned char *head, const unsigned char *line_break) {
+  if (*line_break == '\0')
+    return false;
+
+  while (*head != '\0' && *line_break != '\0' && *head == *line_break) {
+    head++;
+    line_break++;
+  }
+  return *line_break == '\0';
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void referenceStatementRanges(const char *sql, size_t length,
+  const std::string &initialDelimiter, std::vector<StatementRange> &ranges, const std::string &lineBreak) {
+
+  static const unsigned char keyword[] = "delimiter";
+
+  std::string delimiter = initialDelimiter.empty() ? ";" : initialDelimiter;
+  const unsigned char *delimiterHead = reinterpret_cast<const unsigned char *>(delimiter.c_str());
+
+  const unsigned char *start = reinterpret_cast<const unsigned char *>(sql);
+  const unsigned char *head = start;
+  const unsigned char *tail = head;
+  const unsigned char *end = head + length;
+  const unsigned char *newLine = reinterpret_cast<const unsigned char *>(lineBreak.c_str());
+
+  size_t currentLine = 0;
+  size_t statementStart = 0;
+  bool haveContent = false; // Set when anything else but comments were found for the current statement.
+
+  while (tail < end) {
+    switch (*tail) {
+      case '/': { // Possible multi line comment or hidden (conditional) command.
+        if (*(tail + 1) == '*') {
+          tail += 2;
+          bool isHiddenCommand = (*tail == '!');
+          while (true) {
+            while (tail < end && *tail != '*') {
+              if (referenceIsLineBreak(tail, newLine))
+                ++currentLine;
+              tail++;
+            }
+
+            if (tail == end) // Unfinished comment.
+              break;
+            else {
+              if (*++tail == '/') {
+                tail++; // Skip the slash too.
+                break;
+              }
+            }
+          }
+
+          if (isHiddenCommand)
+            haveContent = true;
+          if (!haveContent) {
+            head = tail; // Skip over the comment.
+            statementStart = currentLine;
+          }
+
+        } else
+          tail++;
+
+        break;
+      }
+
+      case '-': { // Possible single line comment.
+        const unsigned char *end_char = tail + 2;
+        if (*(tail + 1) == '-' &&
+            (*end_char == ' ' || *end_char == '\t' || referenceIsLineBreak(end_char, newLine))) {
+          // Skip everything until the end of the line.
+          tail += 2;
+          while (tail < end && !referenceIsLineBreak(tail, newLine))
+            tail++;
+
+          if (!haveContent) {
+            head = tail;
+            statementStart = currentLine;
+          }
+        } else
+          tail++;
+
+        break;
+      }
+
+      case '#': { // MySQL single line comment.
+        while (tail < end && !referenceIsLineBreak(tail, newLine))
+          tail++;
+
+        if (!haveContent) {
+          head = tail;
+          statementStart = currentLine;
+        }
+
+        break;
+      }
+
+      case '"':
+      case '\'':
+      case '`': { // Quoted string/id. Skip this in a local loop.
+        haveContent = true;
+        char quote = *tail++;
+        while (tail < end && *tail != quote) {
+          // Skip any escaped character too.
+          if (*tail == '\\')
+            tail++;
+          tail++;
+        }
+        if (*tail == quote)
+          tail++; // Skip trailing quote char if one was there.
+
+        break;
+      }
+
+      case 'd':
+      case 'D': {
+        haveContent = true;
+
+        // Possible start of the keyword DELIMITER. Must be at the start of the text or a character,
+        // which is not part of a regular MySQL identifier (0-9, A-Z, a-z, _, $, \u0080-\uffff).
+        unsigned char previous = tail > start ? *(tail - 1) : 0;
+        bool is_identifier_char = previous >= 0x80 || (previous >= '0' && previous <= '9') ||
+                                  ((previous | 0x20) >= 'a' && (previous | 0x20) <= 'z') || previous == '$' ||
+                                  previous == '_';
+        if (tail == start || !is_identifier_char) {
+          const unsigned char *run = tail + 1;
+          const unsigned char *kw = keyword + 1;
+          int count = 9;
+          while (count-- > 1 && (*run++ | 0x20) == *kw++)
+            ;
+          if (count == 0 && *run == ' ') {
+            // Delimiter keyword found. Get the new delimiter (everything until the end of the line).
+            tail = run++;
+            while (run < end && !referenceIsLineBreak(run, newLine))
+              ++run;
+            delimiter = base::trim(std::string(reinterpret_cast<const char *>(tail), run - tail));
+            delimiterHead = reinterpret_cast<const unsigned char *>(delimiter.c_str());
+
+            // Skip over the delimiter statement and any following line breaks.
+            while (referenceIsLineBreak(run, newLine)) {
+              ++currentLine;
+              ++run;
+            }
+            tail = run;
+            head = tail;
+            statementStart = currentLine;
+          } else
+            ++tail;
+        } else
+          ++tail;
+
+        break;
+      }
+
+      default:
+        if (referenceIsLineBreak(tail, newLine)) {
+          ++currentLine;
+          if (!haveContent)
+            ++statementStart;
+        }
+
+        if (*tail > ' ')
+          haveContent = true;
+        tail++;
+        break;
+    }
+
+    if (*tail == *delimiterHead) {
+      // Found possible start of the delimiter. Check if it really is.
+      size_t count = delimiter.size();
+      if (count == 1) {
+        // Most common case. Trim the statement and check if it is not empty before adding the range.
+        head = referenceSkipLeadingWhitespace(head, tail);
+        if (head < tail)
+          ranges.push_back({ statementStart, static_cast<size_t>(head - start), static_cast<size_t>(tail - head) });
+        head = ++tail;
+        statementStart = currentLine;
+        haveContent = false;
+      } else {
+        const unsigned char *run = tail + 1;
+        const unsigned char *del = delimiterHead + 1;
+        while (count-- > 1 && (*run++ == *del++))
+          ;
+
+        if (count == 0) {
+          // Multi char delimiter is complete. Tail still points to the start of the delimiter.
+          // Run points to the first character after the delimiter.
+          head = referenceSkipLeadingWhitespace(head, tail);
+          if (head < tail)
+            ranges.push_back({ statementStart, static_cast<size_t>(head - start), static_cast<size_t>(tail - head) });
+          tail = run;
+          head = run;
+          statementStart = currentLine;
+          haveContent = false;
+        }
+      }
+    }
+  }
+
+  // Add remaining text to the range list.
+  head = referenceSkipLeadingWhitespace(head, tail);
+  if (head < tail)
+    ranges.push_back({ statementStart, static_cast<size_t>(head - start), static_cast<size_t>(tail - head) });
+
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void compareStatementRanges(MySQLParserServices *services, const std::string &sql, const std::string &delimiter,
+                                   const std::string &lineBreak, const std::string &message) {
+  std::vector<StatementRange> expected;
+  referenceStatementRanges(sql.c_str(), sql.size(), delimiter, expected, lineBreak);
+
+  std::vector<StatementRange> actual;
+  services->determineStatementRanges(sql.c_str(), sql.size(), delimiter, actual, lineBreak);
+
+  ensure_equals(message + " (range count)", actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ensure_equals(message + " (line, range " + std::to_string(i) + ")", actual[i].line, expected[i].line);
+    ensure_equals(message + " (start, range " + std::to_string(i) + ")", actual[i].start, expected[i].start);
+    ensure_equals(message + " (length, range " + std::to_string(i) + ")", actual[i].length, expected[i].length);
+  }
+}
+
+/**
+ * Differential test for the statement splitter: must return the same ranges as the reference implementation.
+ */
+TEST_FUNCTION(12) {
+  for (size_t i = 0; i < sizeof(test_files) / sizeof(test_files[0]); ++i) {
+#ifdef _WIN32
+    std::ifstream stream(base::string_to_wstring(test_files[i].name), std::ios::binary);
+#else
+    std::ifstream stream(test_files[i].name, std::ios::binary);
+#endif
+    ensure("Error loading sql file: " + test_files[i].name, stream.good());
+    std::string sql((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    compareStatementRanges(_services, sql, test_files[i].initial_delmiter, test_files[i].line_break, test_files[i].name);
+    compareStatementRanges(_services, sql, ";", "\n", test_files[i].name);
+  }
+
+  static const char *snippets[] = {
+    "select 1; select 2;select 3",
+    "select 'a;b', \"c;d\", `e;f`; select 'it\\'s;' ; select 'end\\",
+    "-- comment;\nselect 1; # another; comment\nselect 2;--not a comment;\nselect 3",
+    "/* multi; line\n comment */ select 1; /*! hidden; */; /* unfinished",
+    "delimiter $$\ncreate procedure p() begin select 1; end$$\nDELIMITER ;\nselect 2;",
+    "xdelimiter $$\nselect 1;\n_delimiter //\nselect 2;",
+    "DELIMITER //\r\nselect 1//\r\nselect 2 /\r\n/ select 3//\r\ndelimiter ;\r\nselect 4;",
+    "\n\n   \n;;;\n\t select\n1\n;\n\n",
+    "select 'unterminated; string",
+    "s\xc3\xa9lect d\xc3\xa9limiter; select 1; delimiter\n",
+  };
+
+  for (size_t i = 0; i < sizeof(snippets) / sizeof(snippets[0]); ++i) {
+    std::string message = "Snippet " + std::to_string(i);
+    for (auto lineBreak : { "\n", "\r\n" }) {
+      compareStatementRanges(_services, snippets[i], ";", lineBreak, message);
+      compareStatementRanges(_services, snippets[i], "$$", lineBreak, message);
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
 /**
  * This test generates queries with many (all?) MySQL function names used in foreign key creation
  * (parser bug #21114). Taken from the server test suite.
@@ -21,9 +21,18 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <thread>
+#include <unordered_map>
+
 #include "base/string_utilities.h"
 #include "base/util_functions.h"
 #include "base/log.h"
+#include "base/file_functions.h"
 
 #include "grtpp_util.h"
 
@@ -34,6 +43,7 @@
 #include "mysql/MySQLParserBaseListener.h"
 
 #include "objimpl/wrapper/parser_ContextReference_impl.h"
+#include "grtdb/db_helpers.h"
 #include "grtdb/db_object_helpers.h"
 #include "code-completion/mysql-code-completion.h"
 
@@ -50,6 +60,12 @@ using namespace antlr4::tree;
 
 DEFAULT_LOG_DOMAIN("parser")
 
+// Scripts with fewer statements are not worth the overhead of parsing them in parallel.
+#define PARALLEL_PARSING_MIN_STATEMENTS 500
+
+// Maximum number of unused parser contexts kept for reuse.
+#define PARSER_CONTEXT_POOL_SIZE 32
+
 GRT_MODULE_ENTRY_POINT(MySQLParserServicesImpl);
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -70,6 +86,139 @@ long shortVersion(const GrtVersionRef &version) {
   return (long)short_version;
 }
 
+//------------------ PredictionProfile ---------------------------------------------------------------------------------
+
+// Minimum number of SLL attempts for a statement shape, before it is considered for direct LL parsing.
+#define PREDICTION_PROFILE_MIN_ATTEMPTS 4
+
+// Every n-th parse of a statement shape that is parsed with LL directly still tries SLL, to adapt to changes.
+#define PREDICTION_PROFILE_PROBE_INTERVAL 64
+
+/**
+ * Statements are parsed with the fast SLL prediction mode first and parsed again in LL mode if that fails.
+ * For valid statements which SLL cannot handle the first run is wasted. This profile records per statement shape
+ * (parse unit and the first two tokens) how often that happened. Shapes that (almost) always need LL are then parsed
+ * in LL mode directly. The profile is process wide and can be exported and imported again.
+ */
+class PredictionProfile {
+public:
+  typedef std::tuple<int, size_t, size_t> Shape;
+
+  static PredictionProfile *get() {
+    static PredictionProfile profile;
+    return &profile;
+  }
+
+  /**
+   * Tells whether the SLL run should be skipped for the given shape.
+   */
+  bool skipSLL(const Shape &shape) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = _entries[shape];
+    if (entry.attempts >= PREDICTION_PROFILE_MIN_ATTEMPTS && entry.fallbacks * 10 >= entry.attempts * 9) {
+      if (++entry.skipped % PREDICTION_PROFILE_PROBE_INTERVAL != 0) {
+        ++_statistics.llDirect;
+        return true;
+      }
+    }
+    ++_statistics.sllAttempts;
+    return false;
+  }
+
+  /**
+   * Records the outcome of an SLL run. neededLL is true if SLL failed for a valid statement.
+   */
+  void recordSLL(const Shape &shape, bool neededLL) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry &entry = _entries[shape];
+    ++entry.attempts;
+    if (neededLL) {
+      ++entry.fallbacks;
+      ++_statistics.llFallbacks;
+    }
+  }
+
+  MySQLParserServices::PredictionStatistics statistics() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _statistics;
+  }
+
+  void resetStatistics() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _statistics = MySQLParserServices::PredictionStatistics();
+  }
+
+  /**
+   * Returns the profile as text, one line per shape: unit, first and second token (symbolic names), SLL attempts
+   * and SLL fallbacks.
+   */
+  std::string exportProfile() {
+    ANTLRInputStream input;
+    MySQLLexer lexer(&input);
+    const dfa::Vocabulary &vocabulary = lexer.getVocabulary();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string result;
+    for (auto &entry : _entries) {
+      if (entry.second.attempts == 0)
+        continue;
+      result += std::to_string(std::get<0>(entry.first)) + " " + tokenName(vocabulary, std::get<1>(entry.first)) +
+                " " + tokenName(vocabulary, std::get<2>(entry.first)) + " " + std::to_string(entry.second.attempts) +
+                " " + std::to_string(entry.second.fallbacks) + "\n";
+    }
+    return result;
+  }
+
+  /**
+   * Adds the counts from a previously exported profile. Lines with unknown tokens are ignored.
+   */
+  void importProfile(const std::string &profile) {
+    ANTLRInputStream input;
+    MySQLLexer lexer(&input);
+    const dfa::Vocabulary &vocabulary = lexer.getVocabulary();
+    std::map<std::string, size_t> tokenTypes;
+    for (size_t i = 0; i <= vocabulary.getMaxTokenType(); ++i)
+      tokenTypes[vocabulary.getSymbolicName(i)] = i;
+    tokenTypes["EOF"] = Token::EOF;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::istringstream stream(profile);
+    std::string line;
+    while (std::getline(stream, line)) {
+      std::istringstream fields(line);
+      int unit;
+      std::string first, second;
+      size_t attempts, fallbacks;
+      if (!(fields >> unit >> first >> second >> attempts >> fallbacks) || fallbacks > attempts)
+        continue;
+      if (tokenTypes.count(first) == 0 || tokenTypes.count(second) == 0)
+        continue;
+
+      Entry &entry = _entries[Shape(unit, tokenTypes[first], tokenTypes[second])];
+      entry.attempts += attempts;
+      entry.fallbacks += fallbacks;
+    }
+  }
+
+private:
+  struct Entry {
+    size_t attempts = 0;
+    size_t fallbacks = 0;
+    size_t skipped = 0;
+  };
+
+  std::mutex _mutex;
+  std::map<Shape, Entry> _entries;
+  MySQLParserServices::PredictionStatistics _statistics;
+
+  static std::string tokenName(const dfa::Vocabulary &vocabulary, size_t type) {
+    if (type == Token::EOF)
+      return "EOF";
+    std::string name = vocabulary.getSymbolicName(type);
+    return name.empty() ? std::to_string(type) : name;
+  }
+};
+
 //------------------ MySQLParserContextImpl ----------------------------------------------------------------------------
 
 struct MySQLParserContextImpl;
@@ -110,44 +259,56 @@ struct MySQLParserContextImpl : public MySQLParserContext {
   bool caseSensitive;
   std::vector<ParserErrorInfo> errors;
 
-  MySQLParserContextImpl(GrtCharacterSetsRef charsets, GrtVersionRef version_, bool caseSensitive)
+  /**
+   * Creates an unconfigured context for the context pool, which calls reconfigure() before handing it out.
+   */
+  MySQLParserContextImpl()
     : lexer(&input), tokens(&lexer), parser(&tokens), lexerErrorListener(this), parserErrorListener(this),
-    caseSensitive(caseSensitive) {
+    caseSensitive(false) {
+    setupListeners();
+  }
+
+  virtual bool isCaseSensitive() override {
+    return caseSensitive;
+  }
 
-    std::set<std::string> filteredCharsets;
+  static std::set<std::string> filterCharsets(GrtCharacterSetsRef charsets) {
+    std::set<std::string> result;
     for (size_t i = 0; i < charsets->count(); i++)
-      filteredCharsets.insert("_" + base::tolower(*charsets[i]->name()));
-    lexer.charsets = filteredCharsets;
-    updateServerVersion(version_);
+      result.insert("_" + base::tolower(*charsets[i]->name()));
+    return result;
+  }
 
-    lexer.removeErrorListeners();
-    lexer.addErrorListener(&lexerErrorListener);
+  /**
+   * Gives a (pooled) context new settings, as if it had been freshly created with them.
+   */
+  void reconfigure(const std::set<std::string> &charsets, GrtVersionRef newVersion, bool newCaseSensitive,
+                   const std::string &newMode) {
+    lexer.charsets = charsets;
+    version = newVersion;
+    applyServerVersion();
+    caseSensitive = newCaseSensitive;
+    updateSqlMode(newMode);
 
-    parser.removeParseListeners();
-    parser.removeErrorListeners();
-    parser.addErrorListener(&parserErrorListener);
+    errors.clear();
+    setupListeners();
   }
 
-  virtual bool isCaseSensitive() override {
-    return caseSensitive;
+  /**
+   * Frees everything from the last parse run, before the context goes back into the pool.
+   */
+  void recycle() {
+    parser.reset();
+    errors.clear();
+    input.load("");
+    lexer.setInputStream(&input);
+    tokens.setTokenSource(&lexer);
   }
 
   virtual void updateServerVersion(GrtVersionRef newVersion) override {
     if (version != newVersion) {
       version = newVersion;
-      lexer.serverVersion = shortVersion(version);
-      parser.serverVersion = lexer.serverVersion;
-
-      if (lexer.serverVersion < 50503) {
-        lexer.charsets.erase("_utf8mb4");
-        lexer.charsets.erase("_utf16");
-        lexer.charsets.erase("_utf32");
-      } else {
-        // Duplicates are automatically ignored.
-        lexer.charsets.insert("_utf8mb4");
-        lexer.charsets.insert("_utf16");
-        lexer.charsets.insert("_utf32");
-      }
+      applyServerVersion();
     }
   }
 
@@ -206,17 +367,34 @@ struct MySQLParserContextImpl : public MySQLParserContext {
     return errors.empty();
   }
 
+  /**
+   * Only sets up the input for the lexer, without parsing anything (used when a cached result replaces parsing).
+   */
+  void loadInput(const std::string &text) {
+    parser.reset();
+    input.load(text);
+    lexer.setInputStream(&input);
+    tokens.setTokenSource(&lexer);
+  }
+
   MySQLQueryType determineQueryType(const std::string &text) {
     // Important: this call invalidates any previous parse result (because we have to reset lexer and parser to avoid
     //            dangling token references).
     parser.reset();
     errors.clear();
-    
-    input.load(text);
-    lexer.setInputStream(&input);
     tokens.setTokenSource(&lexer);
 
-    return lexer.determineQueryType();
+    return lexer.determineQueryType(text);
+  }
+
+  size_t determineFirstTokenType(const std::string &text) {
+    // Same as for determineQueryType: any previous parse result is invalid after this call.
+    parser.reset();
+    errors.clear();
+    tokens.setTokenSource(&lexer);
+
+    size_t type = lexer.determineFirstTokenType(text);
+    return type == Token::EOF ? 0 : type;
   }
 
   std::vector<std::pair<int, std::string>> getCodeCompletionCandidates(
@@ -233,6 +411,31 @@ struct MySQLParserContextImpl : public MySQLParserContext {
   }
 
 private:
+  void applyServerVersion() {
+    lexer.serverVersion = shortVersion(version);
+    parser.serverVersion = lexer.serverVersion;
+
+    if (lexer.serverVersion < 50503) {
+      lexer.charsets.erase("_utf8mb4");
+      lexer.charsets.erase("_utf16");
+      lexer.charsets.erase("_utf32");
+    } else {
+      // Duplicates are automatically ignored.
+      lexer.charsets.insert("_utf8mb4");
+      lexer.charsets.insert("_utf16");
+      lexer.charsets.insert("_utf32");
+    }
+  }
+
+  void setupListeners() {
+    lexer.removeErrorListeners();
+    lexer.addErrorListener(&lexerErrorListener);
+
+    parser.removeParseListeners();
+    parser.removeErrorListeners();
+    parser.addErrorListener(&parserErrorListener);
+  }
+
   ParseTree *parseUnit(MySQLParseUnit unit) {
     switch (unit) {
       case MySQLParseUnit::PuCreateSchema:
@@ -279,6 +482,15 @@ private:
     parser.reset();
     parser.setBuildParseTree(!fast);
 
+    // Statement shapes which SLL can't handle anyway are parsed with LL right away.
+    PredictionProfile *profile = PredictionProfile::get();
+    PredictionProfile::Shape shape((int)unit, tokens.LA(1), tokens.LA(2));
+    if (profile->skipSLL(shape)) {
+      parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
+      parser.getInterpreter<ParserATNSimulator>()->setPredictionMode(PredictionMode::LL);
+      return parseUnit(unit);
+    }
+
     // First parse with the bail error strategy to get quick feedback for correct queries.
     parser.setErrorHandler(std::make_shared<BailErrorStrategy>());
     parser.getInterpreter<ParserATNSimulator>()->setPredictionMode(PredictionMode::SLL);
@@ -286,12 +498,14 @@ private:
     ParseTree *tree;
     try {
       tree = parseUnit(unit);
+      profile->recordSLL(shape, false);
     } catch (ParseCancellationException &) {
       // Even in fast mode we have to do a second run if we got no error yet (BailErrorStrategy
       // does not do full processing).
-      if (fast && !errors.empty())
+      if (fast && !errors.empty()) {
         tree = nullptr;
-      else {
+        profile->recordSLL(shape, false);
+      } else {
         // If parsing was canceled we either really have a syntax error or we need to do a second step,
         // now with the default strategy and LL parsing.
         tokens.reset();
@@ -300,6 +514,9 @@ private:
         parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
         parser.getInterpreter<ParserATNSimulator>()->setPredictionMode(PredictionMode::LL);
         tree = parseUnit(unit);
+
+        // Only a valid statement tells us that SLL was not enough.
+        profile->recordSLL(shape, errors.empty());
       }
     }
 
@@ -490,14 +707,508 @@ void ParserErrorListener::syntaxError(Recognizer *recognizer, Token *offendingSy
                   offendingSymbol->getStopIndex() - offendingSymbol->getStartIndex() + 1);
 }
 
+//------------------ ParserContextPool ---------------------------------------------------------------------------------
+
+/**
+ * Keeps unused parser contexts for reuse, so that not every operation has to build a new lexer, parser and their
+ * simulators. All parsers share the DFA cache (it's a static member of the generated parser), which is warmed
+ * once in the background with a small set of typical statements, to take the hit of the first parse runs away from
+ * the first code completion or syntax check.
+ */
+class ParserContextPool {
+public:
+  static ParserContextPool *get() {
+    // Never freed, contexts may be returned during application shutdown.
+    static ParserContextPool *pool = new ParserContextPool();
+    return pool;
+  }
+
+  MySQLParserContextImpl *acquire(const std::set<std::string> &charsets, GrtVersionRef version, bool caseSensitive,
+                                  const std::string &mode) {
+    MySQLParserContextImpl *context = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_contexts.empty()) {
+        context = _contexts.back();
+        _contexts.pop_back();
+      }
+    }
+
+    if (context == nullptr)
+      context = new MySQLParserContextImpl();
+    context->reconfigure(charsets, version, caseSensitive, mode);
+    return context;
+  }
+
+  MySQLParserContextImpl *acquire(const MySQLParserContextImpl &other) {
+    return acquire(other.lexer.charsets, other.version, other.caseSensitive, other.mode);
+  }
+
+  /**
+   * Returns a context which is given back to the pool once the last reference is gone.
+   */
+  std::shared_ptr<MySQLParserContextImpl> acquireShared(GrtCharacterSetsRef charsets, GrtVersionRef version,
+                                                        bool caseSensitive, const std::string &mode) {
+    return std::shared_ptr<MySQLParserContextImpl>(
+      acquire(MySQLParserContextImpl::filterCharsets(charsets), version, caseSensitive, mode),
+      [](MySQLParserContextImpl *context) { ParserContextPool::get()->release(context); });
+  }
+
+  void release(MySQLParserContextImpl *context) {
+    context->recycle();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_contexts.size() < PARSER_CONTEXT_POOL_SIZE)
+      _contexts.push_back(context);
+    else
+      delete context;
+  }
+
+  /**
+   * Starts parsing the warm-up statements in a background thread (once).
+   */
+  void startWarmUp() {
+    std::lock_guard<std::mutex> lock(_warmUpMutex);
+    if (_warmedUp || _warmUpThread.joinable())
+      return;
+
+    // GRT values are created here, in the calling thread.
+    MySQLParserContextImpl *context = acquire({}, bec::parse_version("8.0.16"), false, "");
+    _stopWarmUp = false;
+    _warmUpThread = std::thread([this, context]() {
+      warmUp(context);
+      release(context);
+    });
+  }
+
+  /**
+   * Waits for a running warm-up to end, after telling it to stop early.
+   */
+  void stopWarmUp() {
+    std::lock_guard<std::mutex> lock(_warmUpMutex);
+    if (_warmUpThread.joinable()) {
+      _stopWarmUp = true;
+      _warmUpThread.join();
+      _warmedUp = true;
+    }
+  }
+
+private:
+  std::mutex _mutex;
+  std::vector<MySQLParserContextImpl *> _contexts;
+
+  std::mutex _warmUpMutex;
+  std::thread _warmUpThread;
+  std::atomic<bool> _stopWarmUp;
+  bool _warmedUp = false;
+
+  ParserContextPool() : _stopWarmUp(false) {
+  }
+
+  void warmUp(MySQLParserContextImpl *context) {
+    // Statements (and the parse units used for them) as they commonly appear in the SQL IDE and the object editors.
+    static const std::vector<std::pair<MySQLParseUnit, std::string>> statements = {
+      { MySQLParseUnit::PuGeneric, "select a, b as c, count(*) from s.t1 join t2 using (id) left join t3 on t3.x = "
+        "t1.y where a > 1 and b like 'x%' group by a, b having count(*) > 2 order by 1 desc limit 10" },
+      { MySQLParseUnit::PuGeneric, "select * from (select id, max(v) over (partition by g) from t) as d where id in "
+        "(select id from u where exists (select 1 from w)) union all select 1, 2" },
+      { MySQLParseUnit::PuGeneric, "with cte as (select 1 as n) select n, now(), concat('a', \"b\"), cast(n as char) "
+        "from cte" },
+      { MySQLParseUnit::PuGeneric, "insert into t (a, b, c) values (1, 'text', null), (2, 0x1F, current_timestamp) on "
+        "duplicate key update b = values(b)" },
+      { MySQLParseUnit::PuGeneric, "update t1 set a = a + 1, b = default where id between 1 and 5 order by id limit 1" },
+      { MySQLParseUnit::PuGeneric, "delete from t1 where a is not null and b <> 'x'" },
+      { MySQLParseUnit::PuGeneric, "alter table t1 add column c int unsigned not null default 0 after b, drop index "
+        "idx, add constraint fk foreign key (c) references t2 (id) on delete cascade" },
+      { MySQLParseUnit::PuGeneric, "drop table if exists t1, t2" },
+      { MySQLParseUnit::PuGeneric, "show full columns from t1 from s like 'a%'" },
+      { MySQLParseUnit::PuGeneric, "use s" },
+      { MySQLParseUnit::PuGeneric, "set @a = 1, session sql_mode = 'ANSI_QUOTES'" },
+      { MySQLParseUnit::PuCreateSchema, "create database if not exists s default character set utf8mb4 collate "
+        "utf8mb4_0900_ai_ci" },
+      { MySQLParseUnit::PuCreateTable, "create table if not exists s.t1 (id int not null auto_increment, name "
+        "varchar(45) null default 'x' comment 'c', price decimal(10,2), created datetime default current_timestamp, "
+        "primary key (id), unique index name_unique (name asc), constraint fk_t2 foreign key (id) references t2 (id) "
+        "on delete no action on update cascade) engine = InnoDB default charset = utf8mb4" },
+      { MySQLParseUnit::PuCreateView, "create or replace algorithm = merge definer = current_user sql security "
+        "invoker view v1 (a, b) as select a, b from t1 with check option" },
+      { MySQLParseUnit::PuCreateTrigger, "create definer = 'root'@'localhost' trigger tr before insert on t1 for each "
+        "row begin if new.a < 0 then set new.a = 0; end if; end" },
+      { MySQLParseUnit::PuCreateProcedure, "create procedure p(in a int, out b varchar(10)) reads sql data begin "
+        "declare c int default 0; declare cur cursor for select x from t; while c < a do set c = c + 1; end while; "
+        "select c into b; end" },
+      { MySQLParseUnit::PuCreateFunction, "create function f(a int) returns int deterministic return a * 2" },
+      { MySQLParseUnit::PuCreateIndex, "create unique index idx using btree on t1 (a, b(10) desc)" },
+      { MySQLParseUnit::PuCreateEvent, "create event e on schedule every 1 hour do delete from t1" },
+      { MySQLParseUnit::PuGrant, "grant select, insert on s.* to 'u'@'%' with grant option" },
+    };
+
+    initializeMySQLCodeCompletion(&context->parser);
+
+    for (auto &statement : statements) {
+      if (_stopWarmUp)
+        return;
+
+      // Once with the syntax check (SLL) and once with a full parse.
+      context->errorCheck(statement.second, statement.first);
+      context->parse(statement.second, statement.first);
+    }
+    logDebug3("Parser warm-up finished\n");
+  }
+};
+
+//------------------ ParseResultCache ----------------------------------------------------------------------------------
+
+// Maximum number of statements kept in the parse result cache. When exceeded the cache starts over.
+#define PARSE_CACHE_MAX_ENTRIES 100000
+
+// Number of new syntax check results collected before they are appended to the cache file.
+#define PARSE_CACHE_WRITE_BATCH 256
+
+static const char parseCacheSignature[] = "WBPC0002";
+
+/**
+ * Keeps the outcome of syntax checks (the error list) and of statement detail parsing per statement, so that
+ * unchanged statements don't go through the parser again. Entries are found by a hash of the statement text and all
+ * settings of the parser context which influence the result. A hit is only taken if the stored text and settings
+ * match exactly, the hash alone is not trusted.
+ * Syntax check results can optionally be stored in a file, to which new entries are appended in batches and from
+ * which they are loaded again on the next start.
+ * Access is thread safe.
+ */
+class ParseResultCache {
+public:
+  static ParseResultCache *get() {
+    // Never freed, as it holds grt values which must not be released after the grt is gone.
+    static ParseResultCache *cache = new ParseResultCache();
+    return cache;
+  }
+
+  /**
+   * Computes a value for all settings of the given context which influence parsing. Character sets are
+   * part of it because they decide which introducers (like _utf8mb4) are known.
+   * FNV-1a, which gives the same value on all platforms, as required for the file.
+   */
+  static uint64_t settingsFor(MySQLParserContextImpl *context, MySQLParseUnit unit) {
+    std::string settings = std::to_string((int)unit) + ":" + std::to_string(context->lexer.serverVersion) + ":" +
+                           context->mode + ":" + (context->caseSensitive ? "1" : "0") + ":";
+    for (auto &charset : context->lexer.charsets)
+      settings += charset + ",";
+    return hash(14695981039346656037ULL, settings.c_str(), settings.size());
+  }
+
+  /**
+   * Computes the cache key for the text, when parsed with the given settings (see settingsFor()).
+   */
+  static uint64_t keyFor(uint64_t settings, const char *text, size_t length) {
+    return hash(settings, text, length);
+  }
+
+  static uint64_t keyFor(MySQLParserContextImpl *context, const char *text, size_t length, MySQLParseUnit unit) {
+    return keyFor(settingsFor(context, unit), text, length);
+  }
+
+  bool errors(uint64_t settings, const char *text, size_t length, std::vector<ParserErrorInfo> &errors) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iterator = _errors.find(keyFor(settings, text, length));
+    if (iterator == _errors.end() || !iterator->second.matches(settings, text, length))
+      return false;
+    errors = iterator->second.errors;
+    return true;
+  }
+
+  void addErrors(uint64_t settings, const char *text, size_t length, const std::vector<ParserErrorInfo> &errors) {
+    std::string batch;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_errors.size() >= PARSE_CACHE_MAX_ENTRIES) {
+        _errors.clear();
+        _pendingWrites.clear();
+        _pendingCount = 0;
+        std::lock_guard<std::mutex> fileLock(_fileMutex);
+        openFile(true);
+      }
+
+      ErrorEntry &entry = _errors[keyFor(settings, text, length)];
+      entry.settings = settings;
+      entry.text.assign(text, length);
+      entry.errors = errors;
+
+      if (_persistent) {
+        serializeEntry(entry, _pendingWrites);
+        if (++_pendingCount >= PARSE_CACHE_WRITE_BATCH) {
+          batch.swap(_pendingWrites);
+          _pendingCount = 0;
+        }
+      }
+    }
+
+    // Writing happens outside of the cache lock, so lookups don't wait for the disk.
+    if (!batch.empty())
+      writeBatch(batch);
+  }
+
+  bool details(uint64_t settings, const std::string &text, grt::DictRef &details) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iterator = _details.find(keyFor(settings, text.c_str(), text.size()));
+    if (iterator == _details.end() || iterator->second.settings != settings || iterator->second.text != text)
+      return false;
+    details = grt::DictRef::cast_from(grt::copy_value(iterator->second.details, true));
+    return true;
+  }
+
+  void addDetails(uint64_t settings, const std::string &text, grt::DictRef details) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_details.size() >= PARSE_CACHE_MAX_ENTRIES)
+      _details.clear();
+    DetailsEntry &entry = _details[keyFor(settings, text.c_str(), text.size())];
+    entry.settings = settings;
+    entry.text = text;
+    entry.details = grt::DictRef::cast_from(grt::copy_value(details, true));
+  }
+
+  /**
+   * Loads the syntax check results stored in the given file and appends new results to it from now on.
+   * An empty path writes what is still pending and closes the current file.
+   */
+  void setFile(const std::string &path) {
+    std::string batch;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      batch.swap(_pendingWrites);
+      _pendingCount = 0;
+    }
+    if (!batch.empty())
+      writeBatch(batch);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::lock_guard<std::mutex> fileLock(_fileMutex);
+    if (_file != nullptr) {
+      fclose(_file);
+      _file = nullptr;
+    }
+    _path = path;
+    _persistent = !_path.empty();
+    if (!_persistent)
+      return;
+
+    size_t count = readFile();
+    openFile(count == 0 || count >= PARSE_CACHE_MAX_ENTRIES);
+  }
+
+private:
+  struct ErrorEntry {
+    uint64_t settings = 0;
+    std::string text;
+    std::vector<ParserErrorInfo> errors;
+
+    bool matches(uint64_t otherSettings, const char *otherText, size_t length) const {
+      return settings == otherSettings && text.size() == length && memcmp(text.data(), otherText, length) == 0;
+    }
+  };
+
+  struct DetailsEntry {
+    uint64_t settings = 0;
+    std::string text;
+    grt::DictRef details;
+  };
+
+  std::mutex _mutex; // Guards the entries and the pending writes.
+  std::unordered_map<uint64_t, ErrorEntry> _errors;
+  std::unordered_map<uint64_t, DetailsEntry> _details;
+  bool _persistent = false;
+  std::string _pendingWrites; // Serialized entries not yet written to the file.
+  size_t _pendingCount = 0;
+
+  std::mutex _fileMutex; // Guards the file. Taken after _mutex, if both are needed.
+  std::string _path;
+  FILE *_file = nullptr;
+
+  ParseResultCache() {
+  }
+
+  static uint64_t hash(uint64_t hash, const char *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= (unsigned char)data[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  void openFile(bool truncate) {
+    if (_path.empty())
+      return;
+    if (_file != nullptr)
+      fclose(_file);
+
+    _file = base_fopen(_path.c_str(), truncate ? "wb" : "ab");
+    if (_file == nullptr) {
+      logWarning("Could not open parse cache file %s\n", _path.c_str());
+      return;
+    }
+    if (truncate) {
+      fwrite(parseCacheSignature, 1, sizeof(parseCacheSignature), _file);
+      fflush(_file);
+    }
+  }
+
+  /**
+   * Reads all entries from the cache file. A damaged or incomplete entry (e.g. from a crash while writing)
+   * ends reading, the file is then rewritten. Returns the number of entries read (0 if the file must be rewritten).
+   */
+  size_t readFile() {
+    FILE *file = base_fopen(_path.c_str(), "rb");
+    if (file == nullptr)
+      return 0;
+
+    auto readNumber = [file](uint64_t &value) {
+      return fread(&value, 1, sizeof(value), file);
+    };
+
+    size_t count = 0;
+    bool complete = false;
+    char signature[sizeof(parseCacheSignature)];
+    if (fread(signature, 1, sizeof(signature), file) == sizeof(signature) &&
+        memcmp(signature, parseCacheSignature, sizeof(signature)) == 0) {
+      while (true) {
+        uint64_t settings, textLength, errorCount;
+        size_t bytesRead = readNumber(settings);
+        if (bytesRead == 0) {
+          complete = feof(file) != 0;
+          break;
+        }
+        if (bytesRead != sizeof(settings) || readNumber(textLength) != sizeof(textLength) ||
+            textLength > 100 * 1024 * 1024)
+          break;
+
+        ErrorEntry entry;
+        entry.settings = settings;
+        entry.text.resize(textLength);
+        if ((textLength > 0 && fread(&entry.text[0], textLength, 1, file) != 1) ||
+            readNumber(errorCount) != sizeof(errorCount) || errorCount > 1000)
+          break;
+
+        entry.errors.resize(errorCount);
+        bool valid = true;
+        for (auto &error : entry.errors) {
+          uint64_t values[6];
+          valid = fread(values, sizeof(values), 1, file) == 1 && values[5] < 10000;
+          if (!valid)
+            break;
+          error.tokenType = values[0];
+          error.charOffset = values[1];
+          error.line = values[2];
+          error.offset = values[3];
+          error.length = values[4];
+          error.message.resize(values[5]);
+          valid = values[5] == 0 || fread(&error.message[0], values[5], 1, file) == 1;
+          if (!valid)
+            break;
+        }
+        if (!valid)
+          break;
+
+        uint64_t key = keyFor(entry.settings, entry.text.c_str(), entry.text.size());
+        _errors[key] = std::move(entry);
+        ++count;
+      }
+    }
+    fclose(file);
+
+    if (!complete) {
+      logWarning("Parse cache file %s is damaged or outdated and will be recreated\n", _path.c_str());
+      return 0;
+    }
+    logDebug("Read %lu entries from parse cache file\n", (unsigned long)count);
+    return count;
+  }
+
+  static void serializeEntry(const ErrorEntry &entry, std::string &output) {
+    auto addNumber = [&output](uint64_t value) { output.append((const char *)&value, sizeof(value)); };
+
+    addNumber(entry.settings);
+    addNumber(entry.text.size());
+    output.append(entry.text);
+    addNumber(entry.errors.size());
+    for (auto &error : entry.errors) {
+      uint64_t values[6] = { error.tokenType, error.charOffset, error.line, error.offset, error.length,
+                             error.message.size() };
+      output.append((const char *)values, sizeof(values));
+      output.append(error.message);
+    }
+  }
+
+  void writeBatch(const std::string &batch) {
+    std::lock_guard<std::mutex> fileLock(_fileMutex);
+    if (_file == nullptr)
+      return;
+    fwrite(batch.data(), 1, batch.size(), _file);
+    fflush(_file);
+  }
+};
+
+//------------------ StatementFingerprints -----------------------------------------------------------------------------
+
+// Maximum number of objects for which a statement fingerprint is kept. When exceeded all fingerprints are dropped.
+#define STATEMENT_FINGERPRINTS_MAX_ENTRIES 50000
+
+/**
+ * Remembers for catalog objects (by object id) the fingerprint of the statement they were last built from without
+ * errors. When the same statement comes in again for that object (e.g. an unchanged routine in a routine group)
+ * it doesn't need to be parsed and applied again, which keeps the object and everything it owns untouched.
+ * A fingerprint covers the statement text and all settings of the parser context which influence the result.
+ * Access is thread safe.
+ */
+class StatementFingerprints {
+public:
+  static StatementFingerprints *get() {
+    static StatementFingerprints fingerprints;
+    return &fingerprints;
+  }
+
+  static uint64_t fingerprint(MySQLParserContextImpl *context, const std::string &sql, MySQLParseUnit unit) {
+    return ParseResultCache::keyFor(context, sql.c_str(), sql.size(), unit);
+  }
+
+  /**
+   * Determines if the given object was built from the given sql (with the current context settings) and is still
+   * unchanged, which is the case if its sql definition is still the same text.
+   */
+  bool isUnchanged(MySQLParserContextImpl *context, db_DatabaseDdlObjectRef object, const std::string &sql,
+                   MySQLParseUnit unit) {
+    if (*object->sqlDefinition() != sql)
+      return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iterator = _fingerprints.find(object->id());
+    return iterator != _fingerprints.end() && iterator->second == fingerprint(context, sql, unit);
+  }
+
+  void set(MySQLParserContextImpl *context, db_DatabaseDdlObjectRef object, MySQLParseUnit unit) {
+    uint64_t value = fingerprint(context, *object->sqlDefinition(), unit);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_fingerprints.size() >= STATEMENT_FINGERPRINTS_MAX_ENTRIES)
+      _fingerprints.clear();
+    _fingerprints[object->id()] = value;
+  }
+
+  void remove(db_DatabaseDdlObjectRef object) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _fingerprints.erase(object->id());
+  }
+
+private:
+  std::mutex _mutex;
+  std::unordered_map<std::string, uint64_t> _fingerprints;
+};
+
 //------------------ MySQLParserServicesImpl ---------------------------------------------------------------------------
 
 MySQLParserContext::Ref MySQLParserServicesImpl::createParserContext(GrtCharacterSetsRef charsets,
                                                                      GrtVersionRef version, const std::string &sqlMode,
                                                                      bool caseSensitive) {
-  MySQLParserContext::Ref context = std::make_shared<MySQLParserContextImpl>(charsets, version, caseSensitive != 0);
-  context->updateSqlMode(sqlMode);
-  return context;
+  return ParserContextPool::get()->acquireShared(charsets, version, caseSensitive, sqlMode);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -506,13 +1217,23 @@ parser_ContextReferenceRef MySQLParserServicesImpl::createNewParserContext(GrtCh
                                                                            GrtVersionRef version,
                                                                            const std::string &sqlMode,
                                                                            int caseSensitive) {
-  MySQLParserContext::Ref context = std::make_shared<MySQLParserContextImpl>(charsets, version, caseSensitive != 0);
-  context->updateSqlMode(sqlMode);
+  MySQLParserContext::Ref context =
+    ParserContextPool::get()->acquireShared(charsets, version, caseSensitive != 0, sqlMode);
   return parser_context_to_grt(context);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
+MySQLParserContext::Ref MySQLParserServicesImpl::cloneParserContext(MySQLParserContext::Ref context) {
+  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+
+  return MySQLParserContext::Ref(ParserContextPool::get()->acquire(*impl), [](MySQLParserContext *context) {
+    ParserContextPool::get()->release(static_cast<MySQLParserContextImpl *>(context));
+  });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 size_t MySQLParserServicesImpl::tokenFromString(MySQLParserContext::Ref context, const std::string &token) {
   MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
 
@@ -529,6 +1250,14 @@ MySQLQueryType MySQLParserServicesImpl::determineQueryType(MySQLParserContext::R
 
 //----------------------------------------------------------------------------------------------------------------------
 
+size_t MySQLParserServicesImpl::determineFirstTokenType(MySQLParserContext::Ref context, const std::string &text) {
+  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+
+  return impl->determineFirstTokenType(text);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
  *	Resolves all column/table references we collected before to existing objects.
  *	If any of the references does not point to a valid object, we create a stub object for it.
@@ -772,10 +1501,14 @@ size_t MySQLParserServicesImpl::parseTrigger(MySQLParserContext::Ref context, db
                                              const std::string &sql) {
   logDebug2("Parse trigger\n");
 
-  trigger->sqlDefinition(base::trim(sql));
+  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+  std::string definition = base::trim(sql);
+  if (StatementFingerprints::get()->isUnchanged(impl, trigger, definition, MySQLParseUnit::PuCreateTrigger))
+    return 0;
+
+  trigger->sqlDefinition(definition);
   trigger->lastChangeDate(base::fmttime(0, DATETIME_FMT));
 
-  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
   auto tree = impl->parse(sql, MySQLParseUnit::PuCreateTrigger);
 
   db_mysql_TableRef table;
@@ -824,6 +1557,11 @@ size_t MySQLParserServicesImpl::parseTrigger(MySQLParserContext::Ref context, db
     else
       table->customData().remove("triggerInvalid");
   }
+
+  if (impl->errors.empty())
+    StatementFingerprints::get()->set(impl, trigger, MySQLParseUnit::PuCreateTrigger);
+  else
+    StatementFingerprints::get()->remove(trigger);
   return impl->errors.size();
 }
 
@@ -917,10 +1655,14 @@ size_t MySQLParserServicesImpl::parseRoutine(MySQLParserContext::Ref context, db
                                              const std::string &sql) {
   logDebug2("Parse routine\n");
 
-  routine->sqlDefinition(base::trim(sql));
+  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+  std::string definition = base::trim(sql);
+  if (StatementFingerprints::get()->isUnchanged(impl, routine, definition, MySQLParseUnit::PuCreateRoutine))
+    return 0;
+
+  routine->sqlDefinition(definition);
   routine->lastChangeDate(base::fmttime(0, DATETIME_FMT));
 
-  MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
   auto tree = impl->parse(sql, MySQLParseUnit::PuCreateRoutine);
 
   if (impl->errors.empty()) {
@@ -946,6 +1688,10 @@ size_t MySQLParserServicesImpl::parseRoutine(MySQLParserContext::Ref context, db
     routine->modelOnly(1);
   }
 
+  if (impl->errors.empty())
+    StatementFingerprints::get()->set(impl, routine, MySQLParseUnit::PuCreateRoutine);
+  else
+    StatementFingerprints::get()->remove(routine);
   return impl->errors.size();
 }
 
@@ -982,6 +1728,10 @@ size_t MySQLParserServicesImpl::parseRoutinesSql(parser_ContextReferenceRef cont
 * This process has two parts attached:
 *   - Update the sql text + properties for any routine that is in the script in the owning schema.
 *   - Update the list of routines in the given routine group to what is in the script.
+*
+* Statements which are unchanged since the last run (same text and parser settings, and the routine wasn't
+* modified in between) are not parsed again. Their routines stay as they are, as does the routine list of the group
+* if no routine was added, removed or moved. This keeps editing a single routine in a large group cheap.
 */
 size_t MySQLParserServicesImpl::parseRoutines(MySQLParserContext::Ref context, db_mysql_RoutineGroupRef group,
                                               const std::string &sql) {
@@ -994,17 +1744,46 @@ size_t MySQLParserServicesImpl::parseRoutines(MySQLParserContext::Ref context, d
   std::vector<StatementRange> ranges;
   determineStatementRanges(sql.c_str(), sql.size(), ";", ranges, "\n");
 
-  grt::ListRef<db_Routine> routines = group->routines();
-  routines.remove_all();
-
   db_mysql_SchemaRef schema = db_mysql_SchemaRef::cast_from(group->owner());
   db_mysql_CatalogRef catalog = db_mysql_CatalogRef::cast_from(schema->owner());
   grt::ListRef<db_Routine> schema_routines = schema->routines();
 
+  // The routines currently in the group, by their sql, as candidates for statements that didn't change.
+  grt::ListRef<db_Routine> routines = group->routines();
+  std::unordered_map<std::string, db_mysql_RoutineRef> previousRoutines;
+  for (size_t i = 0; i < routines.count(); ++i) {
+    db_mysql_RoutineRef routine = db_mysql_RoutineRef::cast_from(routines[i]);
+    if (routine->owner() == schema && schema_routines.get_index(routine) != grt::BaseListRef::npos)
+      previousRoutines.emplace(*routine->sqlDefinition(), routine);
+  }
+
+  std::vector<db_mysql_RoutineRef> groupRoutines;
+  auto addToGroup = [&groupRoutines](db_mysql_RoutineRef routine) {
+    for (auto &entry : groupRoutines) {
+      if (base::same_string(routine->name(), entry->name(), false))
+        return;
+    }
+    groupRoutines.push_back(routine);
+  };
+
   int syntaxErrorCounter = 1;
+  size_t unchangedCount = 0;
 
   for (auto &range : ranges) {
     std::string routineSQL = sql.substr(range.start, range.length);
+
+    auto previous = previousRoutines.find(base::trim(routineSQL));
+    if (previous != previousRoutines.end()) {
+      db_mysql_RoutineRef routine = previous->second;
+      previousRoutines.erase(previous);
+      if (StatementFingerprints::get()->isUnchanged(impl, routine, *routine->sqlDefinition(),
+                                                    MySQLParseUnit::PuCreateRoutine)) {
+        ++unchangedCount;
+        addToGroup(routine);
+        continue;
+      }
+    }
+
     auto tree = impl->parse(routineSQL, MySQLParseUnit::PuCreateRoutine);
 
     errorCount += impl->errors.size();
@@ -1027,8 +1806,9 @@ size_t MySQLParserServicesImpl::parseRoutines(MySQLParserContext::Ref context, d
       routine->routineType("unknown");
       routine->modelOnly(1);
       routine->sqlDefinition(base::trim(routineSQL));
+      StatementFingerprints::get()->remove(routine);
 
-      routines.insert(routine);
+      addToGroup(routine);
     } else {
       db_mysql_RoutineRef routine;
       for (size_t i = 0; i < schema_routines.count(); ++i) {
@@ -1070,19 +1850,29 @@ size_t MySQLParserServicesImpl::parseRoutines(MySQLParserContext::Ref context, d
       routine->sqlDefinition(base::trim(routineSQL));
       routine->lastChangeDate(base::fmttime(0, DATETIME_FMT));
 
+      if (impl->errors.empty())
+        StatementFingerprints::get()->set(impl, routine, MySQLParseUnit::PuCreateRoutine);
+      else
+        StatementFingerprints::get()->remove(routine);
+
       // Finally add the routine to the group if it isn't already there.
-      bool found = false;
-      for (size_t i = 0; i < routines.count(); ++i) {
-        if (base::same_string(routine->name(), routines[i]->name(), false)) {
-          found = true;
-          break;
-        }
-      }
-      if (!found)
-        routines.insert(routine);
+      addToGroup(routine);
     }
   }
 
+  // Rebuild the routine list only if it differs from what the script gives (each change is an undo step).
+  bool listChanged = routines.count() != groupRoutines.size();
+  for (size_t i = 0; !listChanged && i < groupRoutines.size(); ++i)
+    listChanged = routines[i] != groupRoutines[i];
+
+  if (listChanged) {
+    routines.remove_all();
+    for (auto &routine : groupRoutines)
+      routines.insert(routine);
+  }
+
+  logDebug3("Routine group: %lu statements, %lu unchanged\n", (unsigned long)ranges.size(),
+            (unsigned long)unchangedCount);
   return errorCount;
 }
 
@@ -1268,12 +2058,96 @@ size_t MySQLParserServicesImpl::parseSQLIntoCatalogSql(parser_ContextReferenceRe
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * Parses the statements of a script concurrently, with an own parser context per statement in a window of statements.
+ * The parse trees are kept until the statements are requested in their original order (for applying them to a catalog,
+ * which must happen in the calling thread), after which the next window is parsed.
+ */
+class StatementParser {
+public:
+  StatementParser(MySQLParserContextImpl *templateContext, size_t threadCount, const std::string &sql,
+                  const std::vector<StatementRange> &ranges, const std::set<MySQLQueryType> &relevantTypes)
+    : _sql(sql), _ranges(ranges), _relevantTypes(relevantTypes), _threadCount(threadCount), _windowStart(0),
+      _windowEnd(0) {
+    // A few statements per thread to balance differently sized statements.
+    _slots.resize(threadCount * 8);
+    for (auto &slot : _slots)
+      slot.context = ParserContextPool::get()->acquire(*templateContext);
+  }
+
+  ~StatementParser() {
+    for (auto &slot : _slots)
+      ParserContextPool::get()->release(slot.context);
+  }
+
+  /**
+   * Returns the context which parsed the statement with the given index (errors in that context are those of this
+   * statement). The query type is always returned, the parse tree only for relevant statements.
+   */
+  MySQLParserContextImpl *result(size_t index, MySQLQueryType &queryType, ParseTree *&tree) {
+    if (index < _windowStart || index >= _windowEnd)
+      parseWindow(index);
+
+    Slot &slot = _slots[index - _windowStart];
+    queryType = slot.queryType;
+    tree = slot.tree;
+    return slot.context;
+  }
+
+private:
+  struct Slot {
+    MySQLParserContextImpl *context = nullptr;
+    MySQLQueryType queryType = QtUnknown;
+    ParseTree *tree = nullptr;
+  };
+
+  const std::string &_sql;
+  const std::vector<StatementRange> &_ranges;
+  const std::set<MySQLQueryType> &_relevantTypes;
+  std::vector<Slot> _slots;
+  size_t _threadCount;
+  size_t _windowStart;
+  size_t _windowEnd;
+
+  void parseWindow(size_t start) {
+    _windowStart = start;
+    _windowEnd = std::min(start + _slots.size(), _ranges.size());
+
+    std::atomic<size_t> next(0);
+    size_t count = _windowEnd - _windowStart;
+    auto worker = [&]() {
+      for (size_t i = next++; i < count; i = next++) {
+        Slot &slot = _slots[i];
+        const StatementRange &range = _ranges[_windowStart + i];
+        std::string query(_sql.c_str() + range.start, range.length);
+        slot.queryType = slot.context->determineQueryType(query);
+        slot.tree = nullptr;
+        if (_relevantTypes.count(slot.queryType) > 0)
+          slot.tree = slot.context->parse(query, MySQLParseUnit::PuGeneric);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < _threadCount && i < count; ++i)
+      threads.push_back(std::thread(worker));
+    worker();
+    for (auto &thread : threads)
+      thread.join();
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
 /**
 *	Expects the sql to be a single or multi-statement text in utf-8 encoding which is parsed and
 *	the details are used to build a grt tree. Existing objects are replaced unless the SQL has
 *	an "if not exist" clause (or no "or replace" clause for views).
 *	Statements handled are: create, drop and table rename, everything else is ignored.
 *
+*  Large scripts are parsed by several threads (number given by the "parse_threads" option, the default depends on
+*  the script size and the available cores). The results are applied to the catalog in statement order, so the
+*  catalog is the same as if all statements were parsed one after the other.
+*
 *  Note for case sensitivity: only schema, table and trigger names *can* be case sensitive.
 *  This is determined by the case_sensitive() function of the given context. All other objects
 *  are searched for case-insensitively.
@@ -1361,21 +2235,37 @@ size_t MySQLParserServicesImpl::parseSQLIntoCatalog(MySQLParserContext::Ref cont
 
   StringListRef errors = StringListRef::cast_from(options.get("errors"));
 
+  ssize_t threadCount = options.get_int("parse_threads", 0);
+  if (threadCount <= 0)
+    threadCount = ranges.size() < PARALLEL_PARSING_MIN_STATEMENTS ? 1 : std::thread::hardware_concurrency();
+  std::unique_ptr<StatementParser> statementParser;
+  if (threadCount > 1)
+    statementParser.reset(new StatementParser(impl, threadCount, sql, ranges, relevantQueryTypes));
+
   // Collect textual FK references into a local cache. At the end this is used
   // to find actual ref tables + columns, when all tables have been parsed.
   DbObjectsRefsCache refCache;
-  for (auto &range : ranges) {
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    auto &range = ranges[i];
     std::string query(sql.c_str() + range.start, range.length);
-    MySQLQueryType queryType = impl->determineQueryType(query);
+
+    MySQLParserContextImpl *parsed = impl;
+    MySQLQueryType queryType;
+    ParseTree *tree = nullptr;
+    if (statementParser)
+      parsed = statementParser->result(i, queryType, tree);
+    else
+      queryType = impl->determineQueryType(query);
 
     if (relevantQueryTypes.count(queryType) == 0)
       continue; // Something we are not interested in. Don't bother parsing it.
 
-    auto tree = impl->parse(query, MySQLParseUnit::PuGeneric);
-    if (!impl->errors.empty()) {
-      errorCount += impl->errors.size();
+    if (!statementParser)
+      tree = impl->parse(query, MySQLParseUnit::PuGeneric);
+    if (!parsed->errors.empty()) {
+      errorCount += parsed->errors.size();
       if (errors.is_valid()) {
-        for (auto &error : impl->errors)
+        for (auto &error : parsed->errors)
           errors.insert("(" + std::to_string(range.line) + ", " + std::to_string(error.offset) + ") "
                         + error.message);
       }
@@ -1955,13 +2845,63 @@ size_t MySQLParserServicesImpl::doSyntaxCheck(parser_ContextReferenceRef context
 size_t MySQLParserServicesImpl::checkSqlSyntax(MySQLParserContext::Ref context, const char *sql, size_t length,
                                                MySQLParseUnit type) {
   MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
+
+  // Unchanged statements (e.g. in a re-opened script or after a small edit) get their result from the cache.
+  ParseResultCache *cache = ParseResultCache::get();
+  uint64_t settings = ParseResultCache::settingsFor(impl, type);
+  if (cache->errors(settings, sql, length, impl->errors)) {
+    impl->loadInput({ sql, length });
+    return impl->errors.size();
+  }
+
   impl->errorCheck({sql, length}, type);
+  cache->addErrors(settings, sql, length, impl->errors);
 
   return impl->errors.size();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
+void MySQLParserServicesImpl::setParseCacheFile(const std::string &path) {
+  ParseResultCache::get()->setFile(path);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MySQLParserServicesImpl::startParserWarmUp() {
+  ParserContextPool::get()->startWarmUp();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MySQLParserServicesImpl::stopParserWarmUp() {
+  ParserContextPool::get()->stopWarmUp();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string MySQLParserServicesImpl::exportPredictionProfile() {
+  return PredictionProfile::get()->exportProfile();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MySQLParserServicesImpl::importPredictionProfile(const std::string &profile) {
+  PredictionProfile::get()->importProfile(profile);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MySQLParserServices::PredictionStatistics MySQLParserServicesImpl::predictionStatistics(bool reset) {
+  PredictionProfile *profile = PredictionProfile::get();
+  PredictionStatistics result = profile->statistics();
+  if (reset)
+    profile->resetStatistics();
+  return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 class SchemaReferencesListener : public MySQLParserBaseListener {
 public:
   std::list<size_t> offsets;
@@ -2118,6 +3058,101 @@ bool isLineBreak(const unsigned char *head, const unsigned char *line_break) {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/**
+ * Byte classification for the statement range scanner. Everything not marked here is ordinary text, which can be
+ * skipped in bulk as it neither starts a comment, a quoted string, a line break, the DELIMITER keyword nor the
+ * current delimiter.
+ */
+class StatementScannerTable {
+public:
+  StatementScannerTable(unsigned char lineBreakStart, unsigned char delimiterStart) {
+    memset(_special, 0, sizeof(_special));
+    for (unsigned char c : { '\0', '/', '-', '#', '"', '\'', '`', 'd', 'D' })
+      _special[c] = true;
+    _special[lineBreakStart] = true;
+    _lineBreakStart = lineBreakStart;
+    setDelimiterStart(delimiterStart);
+  }
+
+  void setDelimiterStart(unsigned char delimiterStart) {
+    if (!isAlwaysSpecial(_delimiterStart) && _delimiterStart != _lineBreakStart)
+      _special[_delimiterStart] = false;
+    _special[delimiterStart] = true;
+    _delimiterStart = delimiterStart;
+  }
+
+  /**
+   * Skips over ordinary bytes and returns the position of the next byte that needs a closer look (or end).
+   * haveContent is set if any non-whitespace byte was skipped.
+   */
+  const unsigned char *skipOrdinary(const unsigned char *tail, const unsigned char *end, bool &haveContent) const {
+    bool content = false;
+    while (end - tail >= 4 && !_special[tail[0]] && !_special[tail[1]] && !_special[tail[2]] && !_special[tail[3]]) {
+      content |= (tail[0] > ' ') | (tail[1] > ' ') | (tail[2] > ' ') | (tail[3] > ' ');
+      tail += 4;
+    }
+    while (tail < end && !_special[*tail]) {
+      content |= (*tail > ' ');
+      ++tail;
+    }
+    if (content)
+      haveContent = true;
+    return tail;
+  }
+
+private:
+  static bool isAlwaysSpecial(unsigned char c) {
+    switch (c) {
+      case '\0':
+      case '/':
+      case '-':
+      case '#':
+      case '"':
+      case '\'':
+      case '`':
+      case 'd':
+      case 'D':
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool _special[256];
+  unsigned char _lineBreakStart = 0;
+  unsigned char _delimiterStart = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the first position at or after run which holds either the given quote char or a backslash (or end).
+ * Works on 8 bytes at a time, using the usual "has zero byte" bit trick to find a candidate word.
+ */
+static const unsigned char *findQuoteOrEscape(const unsigned char *run, const unsigned char *end,
+                                              unsigned char quote) {
+  static const uint64_t ones = 0x0101010101010101ULL;
+  static const uint64_t highBits = 0x8080808080808080ULL;
+  const uint64_t quotePattern = ones * quote;
+  const uint64_t escapePattern = ones * '\\';
+
+  while (end - run >= 8) {
+    uint64_t word;
+    memcpy(&word, run, sizeof(word));
+    uint64_t q = word ^ quotePattern;
+    uint64_t e = word ^ escapePattern;
+    if ((((q - ones) & ~q) | ((e - ones) & ~e)) & highBits)
+      break; // One of the next 8 bytes is a match. Find it below.
+    run += 8;
+  }
+
+  while (run < end && *run != quote && *run != '\\')
+    ++run;
+  return run;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 grt::BaseListRef MySQLParserServicesImpl::getSqlStatementRanges(const std::string &sql) {
 
   std::vector<StatementRange> ranges;
@@ -2154,6 +3189,8 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
   const unsigned char *end = head + length;
   const unsigned char *newLine = reinterpret_cast<const unsigned char *>(lineBreak.c_str());
 
+  StatementScannerTable scannerTable(*newLine, *delimiterHead);
+
   size_t currentLine = 0;
   size_t statementStart = 0;
   bool haveContent = false; // Set when anything else but comments were found for the current statement.
@@ -2228,12 +3265,12 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
       case '\'':
       case '`': { // Quoted string/id. Skip this in a local loop.
         haveContent = true;
-        char quote = *tail++;
-        while (tail < end && *tail != quote) {
-          // Skip any escaped character too.
-          if (*tail == '\\')
-            tail++;
-          tail++;
+        unsigned char quote = *tail++;
+        while (tail < end) {
+          tail = findQuoteOrEscape(tail, end, quote);
+          if (tail == end || *tail == quote)
+            break;
+          tail += 2; // Skip the backslash and the escaped character.
         }
         if (*tail == quote)
           tail++; // Skip trailing quote char if one was there.
@@ -2264,6 +3301,7 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
               ++run;
             delimiter = base::trim(std::string(reinterpret_cast<const char *>(tail), run - tail));
             delimiterHead = reinterpret_cast<const unsigned char *>(delimiter.c_str());
+            scannerTable.setDelimiterStart(*delimiterHead);
 
             // Skip over the delimiter statement and any following line breaks.
             while (isLineBreak(run, newLine)) {
@@ -2291,6 +3329,9 @@ size_t MySQLParserServicesImpl::determineStatementRanges(const char *sql, size_t
         if (*tail > ' ')
           haveContent = true;
         tail++;
+
+        // Ordinary text can neither change the state nor end the statement, so skip it in one go.
+        tail = scannerTable.skipOrdinary(tail, end, haveContent);
         break;
     }
 
@@ -2483,30 +3524,39 @@ grt::DictRef MySQLParserServicesImpl::parseStatement(MySQLParserContext::Ref con
   // So it should be moved into an own file if it grows beyond a few 100 lines.
   MySQLParserContextImpl *impl = dynamic_cast<MySQLParserContextImpl *>(context.get());
 
+  ParseResultCache *cache = ParseResultCache::get();
+  uint64_t settings = ParseResultCache::settingsFor(impl, MySQLParseUnit::PuGeneric);
+  grt::DictRef result;
+  if (cache->details(settings, sql, result))
+    return result;
+
   // First do the query determination, then parse, or we invalidate the tokens from the parse run.
   MySQLQueryType queryType = impl->determineQueryType(sql);
 
   auto tree = impl->parse(sql, MySQLParseUnit::PuGeneric);
   if (!impl->errors.empty()) {
     // Return the error message in case of syntax errors.
-    grt::DictRef result(true);
+    result = grt::DictRef(true);
     result.gset("error", impl->errors[0].message);
-    return result;
-  }
-
-  switch (queryType) {
-    case QtGrant:
-    case QtGrantProxy: {
-      GrantListener listener(tree);
-      return listener.data;
-    }
+  } else {
+    switch (queryType) {
+      case QtGrant:
+      case QtGrantProxy: {
+        GrantListener listener(tree);
+        result = listener.data;
+        break;
+      }
 
-    default: {
-      grt::DictRef result(true);
-      result.gset("error", "Unsupported query type (" + std::to_string(queryType) + ")");
-      return result;
+      default: {
+        result = grt::DictRef(true);
+        result.gset("error", "Unsupported query type (" + std::to_string(queryType) + ")");
+        break;
+      }
     }
   }
+
+  cache->addDetails(settings, sql, result);
+  return result;
 }
 
 //--------------------------------------------------------------------------------------------------
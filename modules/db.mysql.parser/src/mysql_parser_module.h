@@ -134,9 +134,11 @@ public:
                                                                const std::string &sqlMode, bool caseSensitive) override;
   parser_ContextReferenceRef createNewParserContext(GrtCharacterSetsRef charsets, GrtVersionRef version,
                                                     const std::string &sqlMode, int case_sensitive);
+  virtual parsers::MySQLParserContext::Ref cloneParserContext(parsers::MySQLParserContext::Ref context) override;
 
   virtual size_t tokenFromString(parsers::MySQLParserContext::Ref context, const std::string &token) override;
   virtual MySQLQueryType determineQueryType(parsers::MySQLParserContext::Ref context, const std::string &text) override;
+  virtual size_t determineFirstTokenType(parsers::MySQLParserContext::Ref context, const std::string &text) override;
 
   // DB objects.
   virtual size_t parseTable(parsers::MySQLParserContext::Ref context, db_mysql_TableRef table,
@@ -180,6 +182,12 @@ public:
   size_t doSyntaxCheck(parser_ContextReferenceRef context_ref, const std::string &sql, const std::string &type);
   virtual size_t checkSqlSyntax(parsers::MySQLParserContext::Ref context, const char *sql, size_t length,
                                 MySQLParseUnit type) override;
+  virtual void setParseCacheFile(const std::string &path) override;
+  virtual void startParserWarmUp() override;
+  virtual void stopParserWarmUp() override;
+  virtual std::string exportPredictionProfile() override;
+  virtual void importPredictionProfile(const std::string &profile) override;
+  virtual PredictionStatistics predictionStatistics(bool reset) override;
 
   size_t doSchemaRefRename(parser_ContextReferenceRef context_ref, db_mysql_CatalogRef catalog,
                            const std::string old_name, const std::string new_name);
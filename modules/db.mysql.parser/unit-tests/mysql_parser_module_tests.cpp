@@ -25,6 +25,7 @@
 
 #include "grt.h"
 #include "grtsqlparser/mysql_parser_services.h"
+#include "grtdb/db_helpers.h"
 
 using namespace parsers;
 
@@ -54,6 +55,36 @@ END_TEST_DATA_CLASS
 
 TEST_MODULE(mysql_parser_module_tests, "parser module tests");
 
+// Statement classification only lexes the start of a statement, unless that is not enough to decide.
+TEST_FUNCTION(4)
+{
+  ensure_equals("4.1", _services->determineQueryType(_context, "select 1"), QtSelect);
+  ensure_equals("4.2", _services->determineQueryType(_context, " /* a */ -- b\n # c\n insert into t values (1)"), QtInsert);
+  ensure_equals("4.3", _services->determineQueryType(_context, "/*!50100 create table a (b int) */"), QtCreateTable);
+
+  // Leading comments longer than the lexed prefix.
+  std::string sql = "/* " + std::string(2000, 'x') + " */ update t set a = 1";
+  ensure_equals("4.4", _services->determineQueryType(_context, sql), QtUpdate);
+
+  // A token crossing the prefix end.
+  sql = "create definer = `" + std::string(600, 'u') + "`@`%` view v as select 1";
+  ensure_equals("4.5", _services->determineQueryType(_context, sql), QtCreateView);
+
+  // Only whitespace and comments are skipped, a leading parenthesis is the first token.
+  size_t openParToken = _services->tokenFromString(_context, "OPEN_PAR_SYMBOL");
+  ensure_equals("4.6", _services->determineFirstTokenType(_context, "\n  (select 1)"), openParToken);
+  ensure_equals("4.7", _services->determineFirstTokenType(_context, "/* only a comment */"), 0U);
+  ensure_equals("4.8", _services->determineFirstTokenType(_context, ""), 0U);
+
+  // A large statement, of which only the start is lexed for classification.
+  sql = "insert into t values (1, 'a')";
+  for (size_t i = 0; i < 20000; ++i)
+    sql += ", (" + std::to_string(i) + ", 'abcdefghijklmnopqrstuvwxyz')";
+
+  ensure_equals("4.9", _services->determineQueryType(_context, sql), QtInsert);
+  ensure_equals("4.10", _services->checkSqlSyntax(_context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric), 0U);
+}
+
 // Tests for parseStatement.
 // Each test function tests a group of statements from the grammar, as listed in the top rule.
 // Not all query types are implemented in parseStatement. So most of the functions are empty atm.
@@ -208,6 +239,103 @@ TEST_FUNCTION(95)
 // other_administrativeStatement
 // utilityStatement
 
+// Syntax check results are cached, but must be the same as without the cache and depend on the parse settings.
+TEST_FUNCTION(96)
+{
+  std::string sql = "select 1 from dual where a = \"b\"";
+  std::string wrong = "select 1 from where a = 1";
+
+  ensure_equals("96.1", _services->checkSqlSyntax(_context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric), 0U);
+  size_t errorCount = _services->checkSqlSyntax(_context, wrong.c_str(), wrong.size(), MySQLParseUnit::PuGeneric);
+  ensure("96.2", errorCount > 0);
+  std::vector<ParserErrorInfo> errors = _context->errorsWithOffset(0);
+
+  // Now from the cache.
+  ensure_equals("96.3", _services->checkSqlSyntax(_context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric), 0U);
+  ensure_equals("96.4", _services->checkSqlSyntax(_context, wrong.c_str(), wrong.size(), MySQLParseUnit::PuGeneric),
+    errorCount);
+  std::vector<ParserErrorInfo> cachedErrors = _context->errorsWithOffset(0);
+  ensure_equals("96.5", cachedErrors.size(), errors.size());
+  for (size_t i = 0; i < errors.size(); ++i)
+  {
+    ensure_equals("96.6", cachedErrors[i].message, errors[i].message);
+    ensure_equals("96.7", cachedErrors[i].charOffset, errors[i].charOffset);
+    ensure_equals("96.8", cachedErrors[i].length, errors[i].length);
+  }
+
+  // A different parse unit or sql mode must not use the results from above.
+  ensure("96.9", _services->checkSqlSyntax(_context, sql.c_str(), sql.size(), MySQLParseUnit::PuCreateView) > 0);
+
+  // Double quoted text is only valid as a table name if it is an identifier (ANSI_QUOTES).
+  std::string quoted = "select \"a\" from \"t\"";
+  ensure("96.10", _services->checkSqlSyntax(_context, quoted.c_str(), quoted.size(), MySQLParseUnit::PuGeneric) > 0);
+  _context->updateSqlMode("ANSI_QUOTES");
+  ensure_equals("96.11",
+    _services->checkSqlSyntax(_context, quoted.c_str(), quoted.size(), MySQLParseUnit::PuGeneric), 0U);
+  _context->updateSqlMode("");
+  ensure("96.12", _services->checkSqlSyntax(_context, quoted.c_str(), quoted.size(), MySQLParseUnit::PuGeneric) > 0);
+}
+
+// Prediction profile: statement shapes which always need LL skip the SLL run.
+TEST_FUNCTION(97)
+{
+  _services->predictionStatistics(true);
+
+  // Distinct statements, to avoid the parse result cache.
+  for (size_t i = 0; i < 3; ++i)
+  {
+    std::string sql = "select " + std::to_string(i) + " from dual";
+    ensure_equals("97.1", _services->checkSqlSyntax(_context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric), 0U);
+  }
+  MySQLParserServices::PredictionStatistics statistics = _services->predictionStatistics(true);
+  ensure_equals("97.2", statistics.sllAttempts, 3U);
+  ensure_equals("97.3", statistics.llDirect, 0U);
+
+  std::string profile = _services->exportPredictionProfile();
+  ensure("97.4", profile.find(" SELECT_SYMBOL INT_NUMBER ") != std::string::npos);
+
+  // A shape known to always fall back to LL.
+  _services->importPredictionProfile(std::to_string((int)MySQLParseUnit::PuGeneric) +
+    " SELECT_SYMBOL DECIMAL_NUMBER 100 100\nsome garbage\n");
+  std::string sql = "select 1.5 from dual";
+  ensure_equals("97.5", _services->checkSqlSyntax(_context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric), 0U);
+  sql = "select 1.5 from";
+  ensure("97.6", _services->checkSqlSyntax(_context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric) > 0);
+  statistics = _services->predictionStatistics(false);
+  ensure_equals("97.7", statistics.llDirect, 2U);
+  ensure_equals("97.8", statistics.sllAttempts, 0U);
+
+  profile = _services->exportPredictionProfile();
+  ensure("97.9", profile.find(" SELECT_SYMBOL DECIMAL_NUMBER 100 100\n") != std::string::npos);
+  ensure("97.10", profile.find("garbage") == std::string::npos);
+}
+
+// Pooled parser contexts must behave like new ones, whatever settings they had before.
+TEST_FUNCTION(98)
+{
+  _services->startParserWarmUp();
+
+  // Only valid with ANSI_QUOTES, which the pooled contexts must not keep.
+  std::string sql = "select \"a\" from \"t1\"";
+  MySQLParserContext::Ref context = _services->createParserContext(GrtCharacterSetsRef(true),
+    bec::parse_version("5.7.10"), "ANSI_QUOTES", true);
+  ensure_equals("98.1", _services->checkSqlSyntax(context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric), 0U);
+  context.reset();
+
+  for (size_t i = 0; i < 40; ++i)
+  {
+    context = _services->createParserContext(GrtCharacterSetsRef(true), bec::parse_version("8.0.16"), "", false);
+    ensure("98.2", !context->isCaseSensitive());
+    ensure_equals("98.3", context->sqlMode(), "");
+    ensure_equals("98.4", bec::version_to_int(context->serverVersion()), 80016);
+    ensure("98.5", _services->checkSqlSyntax(context, sql.c_str(), sql.size(), MySQLParseUnit::PuGeneric) > 0);
+    ensure("98.6", !context->errorsWithOffset(0).empty());
+    context.reset();
+  }
+
+  _services->stopParserWarmUp();
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99)
@@ -23,8 +23,11 @@
 
 #include <glib.h>
 #include <boost/signals2.hpp>
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 
+#include "base/string_utilities.h"
 #include "mysql_sql_inserts_loader.h"
 #include "mysql_sql_parser_utils.h"
 #include <boost/foreach.hpp>
@@ -33,6 +36,400 @@ using namespace grt;
 
 #define NULL_STATE_KEEPER Null_state_keeper _nsk(this);
 
+namespace {
+
+  /**
+   * Converts the sql text of an insert value to the form expected by the recordset storage:
+   * quotes are removed from strings, everything else, which is not a plain number, is marked as function call.
+   */
+  void prepare_insert_value(std::string &value) {
+    if (1 < value.size()) {
+      switch (value[0]) {
+        case '\'':
+        case '"':
+          value = value.substr(1, value.size() - 2);
+          break;
+        default:
+          static const std::string func_call_seq = "\\func ";
+          if (value[0] == '\\') {
+            if ((value.size() > func_call_seq.size()) &&
+                (value.compare(0, func_call_seq.size(), func_call_seq) == 0)) {
+              value = '\\' + value;
+            }
+          } else {
+            bool is_expression = false;
+            for (std::string::iterator i = value.begin(), i_end = value.end(); i != i_end; ++i) {
+              if (!std::isdigit(*i) && (*i != '.') && (*i != ',')) {
+                is_expression = true;
+                break;
+              }
+            }
+            if (is_expression) {
+              value = func_call_seq + value;
+            }
+          }
+          break;
+      }
+    }
+  }
+
+  /**
+   * A minimal scanner for plain INSERT ... VALUES statements, as they are generated for table inserts.
+   * It knows just enough of the MySQL syntax (whitespace, comments, identifiers, strings) to take such statements
+   * apart without building a parse tree. Whenever it meets anything else it gives up and the statement is
+   * handed over to the full parser.
+   */
+  class Insert_scanner {
+  public:
+    const char *pos;
+    const char *end;
+
+    Insert_scanner(const char *begin, const char *end, bool ansi_quotes, bool no_backslash_escapes)
+      : pos(begin), end(end), _ansi_quotes(ansi_quotes), _no_backslash_escapes(no_backslash_escapes) {
+    }
+
+    static bool is_identifier_char(char c) {
+      return std::isalnum((unsigned char)c) || c == '_' || c == '$' || (unsigned char)c >= 0x80;
+    }
+
+    bool at_end() const {
+      return pos >= end;
+    }
+
+    // Skips whitespace and comments. Returns false if a hidden command (/*! ... */) was found.
+    bool skip_space() {
+      while (pos < end) {
+        if (std::isspace((unsigned char)*pos))
+          ++pos;
+        else if (!skip_comment())
+          break;
+      }
+      return pos == end || end - pos < 3 || strncmp(pos, "/*!", 3) != 0;
+    }
+
+    // Whitespace only, comments are not accepted between values.
+    void skip_blanks() {
+      while (pos < end && std::isspace((unsigned char)*pos))
+        ++pos;
+    }
+
+    bool keyword(const char *word) {
+      size_t length = strlen(word);
+      if ((size_t)(end - pos) < length || g_ascii_strncasecmp(pos, word, length) != 0)
+        return false;
+      if (pos + length < end && is_identifier_char(pos[length]))
+        return false;
+      pos += length;
+      return true;
+    }
+
+    bool symbol(char c) {
+      if (pos < end && *pos == c) {
+        ++pos;
+        return true;
+      }
+      return false;
+    }
+
+    // Reads a single (not qualified) identifier, unquoting it if necessary.
+    bool identifier(std::string &name) {
+      if (pos == end)
+        return false;
+
+      char quote = *pos;
+      if (quote == '`' || (quote == '"' && _ansi_quotes)) {
+        const char *start = ++pos;
+        while (pos < end && *pos != quote)
+          ++pos;
+        if (pos == end || pos == start || (pos + 1 < end && pos[1] == quote))
+          return false; // Unterminated, empty or with escaped quotes.
+        name.assign(start, pos++);
+        return true;
+      }
+
+      const char *start = pos;
+      while (pos < end && is_identifier_char(*pos))
+        ++pos;
+      if (pos == start)
+        return false;
+      name.assign(start, pos);
+      return true;
+    }
+
+    // Skips a string literal or quoted identifier starting at the current position.
+    bool skip_quoted() {
+      char quote = *pos++;
+      while (pos < end) {
+        if (*pos == '\\' && !_no_backslash_escapes && quote != '`') {
+          pos += 2;
+          continue;
+        }
+        if (*pos == quote) {
+          if (pos + 1 < end && pos[1] == quote) {
+            pos += 2;
+            continue;
+          }
+          ++pos;
+          return true;
+        }
+        ++pos;
+      }
+      return false;
+    }
+
+    // Reads the text of a single value up to the next top level comma or closing parenthesis.
+    bool value(std::string &text, bool &is_null) {
+      const char *start = pos;
+      const char *last = pos;
+      int depth = 0;
+      while (pos < end) {
+        switch (*pos) {
+          case '"':
+            if (_ansi_quotes)
+              return false;
+          // fall through
+          case '\'':
+          case '`':
+            if (!skip_quoted())
+              return false;
+            last = pos;
+            continue;
+
+          case '(':
+            ++depth;
+            break;
+
+          case ')':
+            if (depth == 0)
+              return finish_value(start, last, text, is_null);
+            --depth;
+            break;
+
+          case ',':
+            if (depth == 0)
+              return finish_value(start, last, text, is_null);
+            break;
+
+          case ';':
+          case '#':
+          case '\\':
+            return false;
+
+          case '-':
+            if (pos + 1 < end && pos[1] == '-')
+              return false;
+            break;
+
+          case '/':
+            if (pos + 1 < end && pos[1] == '*')
+              return false;
+            break;
+
+          default:
+            if (std::isspace((unsigned char)*pos)) {
+              ++pos;
+              continue;
+            }
+            break;
+        }
+        last = ++pos;
+      }
+      return false;
+    }
+
+    // Moves to the position after the next statement delimiter (or the end of the text).
+    void skip_statement() {
+      while (pos < end) {
+        switch (*pos) {
+          case '\'':
+          case '"':
+          case '`':
+            if (!skip_quoted())
+              pos = end;
+            break;
+
+          case ';':
+            ++pos;
+            return;
+
+          default:
+            if (!skip_comment())
+              ++pos;
+            break;
+        }
+      }
+    }
+
+  private:
+    bool _ansi_quotes;
+    bool _no_backslash_escapes;
+
+    // Skips a comment at the current position, if there is one. Hidden commands are not comments.
+    bool skip_comment() {
+      if (*pos == '#' || (*pos == '-' && end - pos > 2 && pos[1] == '-' && std::isspace((unsigned char)pos[2]))) {
+        while (pos < end && *pos != '\n')
+          ++pos;
+        return true;
+      }
+
+      if (*pos == '/' && end - pos > 1 && pos[1] == '*' && (end - pos == 2 || pos[2] != '!')) {
+        const char *comment_end = std::search(pos + 2, end, "*/", "*/" + 2);
+        pos = (comment_end == end) ? end : comment_end + 2;
+        return true;
+      }
+
+      return false;
+    }
+
+    /**
+     * Checks that an unquoted value is one the scanner fully understands: a number, a hex or bit literal,
+     * a word (NULL, DEFAULT, a constant like CURRENT_TIMESTAMP) or a call of a function without arguments.
+     * Anything else (expressions, several tokens without a comma between them etc.) is left to the parser,
+     * which also reports the errors in it.
+     */
+    static bool is_single_token(const char *start, const char *last) {
+      const char *p = start;
+
+      // x'..', b'..'
+      if ((*p == 'x' || *p == 'X' || *p == 'b' || *p == 'B') && last - p > 2 && p[1] == '\'') {
+        bool bits = *p == 'b' || *p == 'B';
+        for (p += 2; p < last - 1 && *p != '\''; ++p)
+          if (!std::isxdigit((unsigned char)*p) || (bits && *p != '0' && *p != '1'))
+            return false;
+        return p == last - 1 && *p == '\'';
+      }
+
+      if (std::isalpha((unsigned char)*p) || *p == '_') {
+        while (p < last && is_identifier_char(*p))
+          ++p;
+        return p == last || (last - p == 2 && p[0] == '(' && p[1] == ')');
+      }
+
+      // 0x.., 0b..
+      if (*p == '0' && last - p > 2 && (p[1] == 'x' || p[1] == 'b')) {
+        for (p += 2; p < last; ++p)
+          if (!std::isxdigit((unsigned char)*p) || (start[1] == 'b' && *p != '0' && *p != '1'))
+            return false;
+        return true;
+      }
+
+      // [+-] digits [. digits] [e [+-] digits]
+      if (*p == '-' || *p == '+')
+        ++p;
+      bool has_digits = false;
+      for (; p < last && std::isdigit((unsigned char)*p); ++p)
+        has_digits = true;
+      if (p < last && *p == '.')
+        for (++p; p < last && std::isdigit((unsigned char)*p); ++p)
+          has_digits = true;
+      if (!has_digits)
+        return false;
+      if (p < last && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p < last && (*p == '-' || *p == '+'))
+          ++p;
+        if (p == last || !std::isdigit((unsigned char)*p))
+          return false;
+        while (p < last && std::isdigit((unsigned char)*p))
+          ++p;
+      }
+      return p == last;
+    }
+
+    bool finish_value(const char *start, const char *last, std::string &text, bool &is_null) {
+      if (last == start)
+        return false;
+
+      // A string must be the only part of the value (no concatenation of adjacent strings etc.).
+      if (*start == '\'' || (*start == '"' && !_ansi_quotes)) {
+        Insert_scanner string_scanner(start, last, _ansi_quotes, _no_backslash_escapes);
+        if (!string_scanner.skip_quoted() || string_scanner.pos != last)
+          return false;
+      } else if (!is_single_token(start, last))
+        return false;
+
+      text.assign(start, last);
+      is_null = (last - start == 4) && g_ascii_strncasecmp(start, "NULL", 4) == 0;
+      if (is_null)
+        text.clear();
+      else
+        prepare_insert_value(text);
+      return true;
+    }
+  };
+
+  struct Plain_insert {
+    std::string schema_name;
+    std::string table_name;
+    Sql_inserts_loader::Strings fields_names;
+    std::vector<Sql_inserts_loader::Strings> rows;
+    std::vector<std::vector<bool> > null_fields;
+  };
+
+  /**
+   * Parses INSERT [INTO] [schema.]table (column, ...) VALUES (value, ...), ... at the scanner position.
+   * Returns false for anything else, leaving the scanner at an undefined position.
+   */
+  bool parse_plain_insert(Insert_scanner &scanner, Plain_insert &insert) {
+    if (!scanner.keyword("INSERT") || !scanner.skip_space())
+      return false;
+    if (scanner.keyword("INTO") && !scanner.skip_space())
+      return false;
+
+    std::string name;
+    if (!scanner.identifier(name) || !scanner.skip_space())
+      return false;
+    if (scanner.symbol('.')) {
+      insert.schema_name = name;
+      if (!scanner.skip_space() || !scanner.identifier(name) || !scanner.skip_space())
+        return false;
+    }
+    insert.table_name = name;
+
+    if (!scanner.symbol('('))
+      return false;
+    do {
+      if (!scanner.skip_space() || !scanner.identifier(name) || !scanner.skip_space())
+        return false;
+      insert.fields_names.push_back(name);
+    } while (scanner.symbol(','));
+    if (!scanner.symbol(')') || !scanner.skip_space())
+      return false;
+
+    if (!scanner.keyword("VALUES") && !scanner.keyword("VALUE"))
+      return false;
+
+    do {
+      if (!scanner.skip_space() || !scanner.symbol('('))
+        return false;
+
+      Sql_inserts_loader::Strings values;
+      std::vector<bool> nulls;
+      values.reserve(insert.fields_names.size());
+      nulls.reserve(insert.fields_names.size());
+      do {
+        std::string value;
+        bool is_null;
+        scanner.skip_blanks();
+        if (!scanner.value(value, is_null))
+          return false;
+        values.push_back(value);
+        nulls.push_back(is_null);
+      } while (scanner.symbol(','));
+      if (!scanner.symbol(')'))
+        return false;
+
+      insert.rows.push_back(std::move(values));
+      insert.null_fields.push_back(std::move(nulls));
+      if (!scanner.skip_space())
+        return false;
+    } while (scanner.symbol(','));
+
+    return scanner.symbol(';') || scanner.at_end();
+  }
+
+} // namespace
+
 Mysql_sql_inserts_loader::Mysql_sql_inserts_loader() {
   NULL_STATE_KEEPER
 }
@@ -43,9 +440,54 @@ void Mysql_sql_inserts_loader::load(const std::string &sql, const std::string &s
   _schema_name = schema_name;
   _process_sql_statement = boost::bind(&Mysql_sql_inserts_loader::process_sql_statement, this, _1);
 
-  Mysql_sql_parser_fe sql_parser_fe(bec::GRTManager::get()->get_app_option_string("SqlMode"));
+  std::string sql_mode = bec::GRTManager::get()->get_app_option_string("SqlMode");
+  Mysql_sql_parser_fe sql_parser_fe(sql_mode);
   sql_parser_fe.ignore_dml = false;
-  Mysql_sql_parser_base::parse_sql_script(sql_parser_fe, sql.c_str());
+
+  // Plain INSERT statements (which is what insert scripts usually consist of) are taken apart directly.
+  // Everything else is collected and handed over to the full parser, keeping the original statement order.
+  sql_mode = base::toupper(sql_mode);
+  Insert_scanner scanner(sql.data(), sql.data() + sql.size(), sql_mode.find("ANSI") != std::string::npos,
+                         sql_mode.find("NO_BACKSLASH_ESCAPES") != std::string::npos);
+  std::string other_statements;
+  while (!scanner.at_end()) {
+    const char *start = scanner.pos;
+    bool no_hidden_command = scanner.skip_space();
+    if (scanner.at_end())
+      break;
+
+    if (no_hidden_command && scanner.keyword("DELIMITER")) {
+      // Custom delimiters are left to the full parser.
+      other_statements.append(start, scanner.end);
+      break;
+    }
+
+    const char *statement_start = scanner.pos;
+    Plain_insert insert;
+    insert.schema_name = _schema_name;
+    if (no_hidden_command && parse_plain_insert(scanner, insert)) {
+      if (!other_statements.empty()) {
+        Mysql_sql_parser_base::parse_sql_script(sql_parser_fe, other_statements.c_str());
+        other_statements.clear();
+      }
+
+      const char *statement_end = scanner.pos;
+      if (statement_end > statement_start && *(statement_end - 1) == ';')
+        --statement_end;
+      _sql_statement.assign(statement_start, statement_end);
+
+      const std::pair<std::string, std::string> schema_table = make_pair(insert.schema_name, insert.table_name);
+      for (size_t i = 0; i < insert.rows.size(); ++i)
+        _process_insert(sql_statement(), schema_table, insert.fields_names, insert.rows[i], insert.null_fields[i]);
+    } else {
+      scanner.pos = statement_start;
+      scanner.skip_statement();
+      other_statements.append(start, scanner.pos);
+    }
+  }
+
+  if (!other_statements.empty())
+    Mysql_sql_parser_base::parse_sql_script(sql_parser_fe, other_statements.c_str());
 }
 
 int Mysql_sql_inserts_loader::process_sql_statement(const SqlAstNode *tree) {
@@ -115,34 +557,7 @@ Mysql_sql_inserts_loader::Parse_result Mysql_sql_inserts_loader::process_insert_
 
               if (!is_field_null) {
                 value = item->restore_sql_text(_sql_statement);
-                if (1 < value.size()) {
-                  switch (value[0]) {
-                    case '\'':
-                    case '"':
-                      value = value.substr(1, value.size() - 2);
-                      break;
-                    default:
-                      static const std::string func_call_seq = "\\func ";
-                      if (value[0] == '\\') {
-                        if ((value.size() > func_call_seq.size()) &&
-                            (value.compare(0, func_call_seq.size(), func_call_seq) == 0)) {
-                          value = '\\' + value;
-                        }
-                      } else {
-                        bool is_expression = false;
-                        for (std::string::iterator i = value.begin(), i_end = value.end(); i != i_end; ++i) {
-                          if (!std::isdigit(*i) && (*i != '.') && (*i != ',')) {
-                            is_expression = true;
-                            break;
-                          }
-                        }
-                        if (is_expression) {
-                          value = func_call_seq + value;
-                        }
-                      }
-                      break;
-                  }
-                }
+                prepare_insert_value(value);
               }
 
               fields_values.push_back(value);
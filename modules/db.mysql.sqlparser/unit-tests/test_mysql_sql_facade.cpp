@@ -28,6 +28,8 @@
 #include "grt_test_utility.h"
 #include "testgrt.h"
 #include "grtsqlparser/sql_facade.h"
+#include "grtsqlparser/sql_inserts_loader.h"
+#include "base/string_utilities.h"
 #include "wb_helpers.h"
 
 BEGIN_TEST_DATA_CLASS(mysql_sql_facade)
@@ -230,6 +232,85 @@ TEST_FUNCTION(11) {
   ensure_equals("Unexpected Column Count", columns.size(), 0U);
 }
 
+struct Loaded_insert {
+  std::string schema;
+  std::string table;
+  Sql_inserts_loader::Strings fields_names;
+  Sql_inserts_loader::Strings fields_values;
+  std::vector<bool> null_fields;
+};
+
+static std::vector<Loaded_insert> load_inserts(SqlFacade::Ref sql_facade, const std::string &sql) {
+  std::vector<Loaded_insert> result;
+  Sql_inserts_loader::Ref loader = sql_facade->sqlInsertsLoader();
+  loader->process_insert_cb([&result](const std::string &, const std::pair<std::string, std::string> &schema_table,
+                                      const Sql_inserts_loader::Strings &fields_names,
+                                      const Sql_inserts_loader::Strings &fields_values,
+                                      const std::vector<bool> &null_fields) {
+    result.push_back({ schema_table.first, schema_table.second, fields_names, fields_values, null_fields });
+  });
+  loader->load(sql, "def");
+  return result;
+}
+
+// Plain insert statements are loaded without the full parser, which must give the same rows.
+TEST_FUNCTION(12) {
+  ensure("failed to get sqlparser module", (NULL != sql_facade));
+
+  std::string inserts =
+    "INSERT INTO `sakila`.`actor` (`actor_id`, first_name, `last_name`) VALUES (1, 'PENELOPE', 'GUINESS'), "
+    "(2, 'it\\'s', NULL);\n"
+    "INSERT actor (actor_id, first_name, last_name) VALUES (-3, now(), \"O''Neil\"), (4.5, DEFAULT, x'41')";
+
+  // The hidden command prefix forces the full parser.
+  std::vector<Loaded_insert> fast = load_inserts(sql_facade, inserts);
+  std::vector<Loaded_insert> full = load_inserts(sql_facade, "/*!*/ " + base::replaceString(inserts, "\n", "\n/*!*/ "));
+
+  ensure_equals("12.1 row count", fast.size(), 4U);
+  ensure_equals("12.2 row count (full parser)", full.size(), fast.size());
+  for (size_t i = 0; i < fast.size(); ++i) {
+    std::string row = "12.3 row " + std::to_string(i);
+    ensure_equals(row + " schema", fast[i].schema, full[i].schema);
+    ensure_equals(row + " table", fast[i].table, full[i].table);
+    ensure("12.4 " + row + " fields", fast[i].fields_names == full[i].fields_names);
+    ensure("12.5 " + row + " values", fast[i].fields_values == full[i].fields_values);
+    ensure("12.6 " + row + " nulls", fast[i].null_fields == full[i].null_fields);
+  }
+
+  ensure_equals("12.7", fast[0].schema, "sakila");
+  ensure_equals("12.8", fast[2].schema, "def");
+  ensure_equals("12.9", fast[0].fields_names[1], "first_name");
+  ensure_equals("12.10", fast[1].fields_values[1], "it\\'s");
+  ensure("12.11", fast[1].null_fields[2]);
+  ensure_equals("12.12", fast[2].fields_values[0], "\\func -3");
+  ensure_equals("12.13", fast[2].fields_values[2], "O''Neil");
+}
+
+// Values the fast path doesn't fully understand are left to the full parser, including invalid ones.
+TEST_FUNCTION(13) {
+  ensure("failed to get sqlparser module", (NULL != sql_facade));
+
+  const char *statements[] = {
+    "INSERT INTO t (a, b) VALUES (1, 2 3)",        // Missing comma.
+    "INSERT INTO t (a, b) VALUES (1, 'a' 'b')",    // Adjacent strings.
+    "INSERT INTO t (a, b) VALUES (1, 2 + 3)",      // Expression.
+    "INSERT INTO t (a, b) VALUES (1, 1e)",         // Incomplete number.
+    "INSERT INTO t (a, b) VALUES (1, now() now())" // Two calls.
+  };
+  for (const char *statement : statements) {
+    std::vector<Loaded_insert> fast = load_inserts(sql_facade, statement);
+    std::vector<Loaded_insert> full = load_inserts(sql_facade, std::string("/*!*/ ") + statement);
+
+    ensure_equals(std::string("13.1 row count of ") + statement, fast.size(), full.size());
+    for (size_t i = 0; i < fast.size(); ++i)
+      ensure(std::string("13.2 values of ") + statement, fast[i].fields_values == full[i].fields_values);
+  }
+
+  std::vector<Loaded_insert> rows = load_inserts(sql_facade, "INSERT INTO t (a, b) VALUES (1, 2 3)");
+  for (size_t i = 0; i < rows.size(); ++i)
+    ensure("13.3 malformed value accepted", rows[i].fields_values[1] != "\\func 2 3");
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
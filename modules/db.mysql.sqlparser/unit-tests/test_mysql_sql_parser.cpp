@@ -238,6 +238,32 @@ TEST_FUNCTION(90)
   test_import_sql(900, "test", "new_schema_name");
 }
 
+// Parallel parsing must result in the same catalog as parsing one statement after the other.
+TEST_FUNCTION(95)
+{
+  for (size_t test_no : { 700, 701, 702 })
+  {
+    std::string sql = base::getTextFileContent("data/modules_grt/wb_mysql_import/sql/" + std::to_string(test_no) + ".sql");
+
+    db_mysql_CatalogRef catalogs[2] = { db_mysql_CatalogRef(grt::Initialized), db_mysql_CatalogRef(grt::Initialized) };
+    for (size_t i = 0; i < 2; ++i)
+    {
+      catalogs[i]->version(_tester->get_rdbms()->version());
+      catalogs[i]->defaultCharacterSetName("utf8");
+      catalogs[i]->defaultCollationName("utf8_general_ci");
+      grt::replace_contents(catalogs[i]->simpleDatatypes(), _tester->get_rdbms()->simpleDatatypes());
+
+      DictRef options = DictRef(true);
+      options.set("gen_fk_names_when_empty", IntegerRef(0));
+      options.set("parse_threads", IntegerRef(i == 0 ? 1 : 4));
+      ensure_equals("Parse errors (" + std::to_string(test_no) + ")",
+        _services->parseSQLIntoCatalog(_context, catalogs[i], sql, options), 0U);
+    }
+
+    grt_ensure_equals(("Parallel parsing (" + std::to_string(test_no) + ")").c_str(), catalogs[1], catalogs[0]);
+  }
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99)
@@ -181,6 +181,50 @@ TEST_FUNCTION(30) {
     ensure_equals("Routine unintentionally changed", processed_routines[index], double_processed_routines[index]);
 }
 
+/**
+ *	Editing one routine of a group must leave the other routines (and what they own) untouched.
+ */
+TEST_FUNCTION(40) {
+  std::string routine_sql =
+    "DELIMITER //" NL "CREATE FUNCTION f1(a INT) RETURNS INT RETURN a + 1 //" NL
+    "CREATE PROCEDURE p1(IN b INT)" NL "BEGIN" NL "  SELECT b;" NL "END //" NL
+    "CREATE FUNCTION f2(c INT) RETURNS INT RETURN c * 2 //" NL "DELIMITER ;";
+
+  SynteticMySQLModel model;
+  model.schema->name("test_schema");
+  model.routineGroup->name("rg");
+  MySQLRoutineGroupEditorBE rg(model.routineGroup);
+
+  rg.use_sql(routine_sql);
+  grt::ListRef<db_Routine> routines = model.routineGroup->routines();
+  assure_equal(routines.count(), 3U);
+
+  db_RoutineRef f1 = routines[0], p1 = routines[1], f2 = routines[2];
+  db_RoutineParamRef f1Param = f1->params()[0], p1Param = p1->params()[0];
+
+  std::string sql = rg.get_sql();
+  sql.replace(sql.find("SELECT b;"), 9, "SELECT b + 1;");
+  rg.use_sql(sql);
+
+  routines = model.routineGroup->routines();
+  assure_equal(routines.count(), 3U);
+  ensure("Unchanged routine replaced", routines[0] == f1 && routines[2] == f2);
+  ensure("Unchanged routine re-parsed", f1->params()[0] == f1Param);
+  ensure("Changed routine replaced", routines[1] == p1);
+  ensure("Changed routine not parsed", p1->params()[0] != p1Param);
+  ensure("Changed routine sql not updated", std::string(*p1->sqlDefinition()).find("SELECT b + 1;") != std::string::npos);
+
+  // Reordering the statements reorders the routines, without re-creating them.
+  sql = "DELIMITER //" NL + std::string(*f2->sqlDefinition()) + " //" NL + std::string(*f1->sqlDefinition()) + " //" NL +
+        std::string(*p1->sqlDefinition()) + " //" NL "DELIMITER ;";
+  rg.use_sql(sql);
+
+  routines = model.routineGroup->routines();
+  assure_equal(routines.count(), 3U);
+  ensure("Routines not reordered", routines[0] == f2 && routines[1] == f1 && routines[2] == p1);
+  ensure("Unchanged routine re-parsed", f1->params()[0] == f1Param);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {